@@ -6,6 +6,8 @@
 
 QT += opengl #core and gui are already included
 
+CONFIG += c++11
+
 TARGET = QuoniamTerrain
 TEMPLATE = app
 
@@ -94,7 +96,9 @@ UI_DIR = ./tmp
 SOURCES +=\
     src/core/AxisAlignedBoundingBox.cpp \
     src/core/BoundingSphere.cpp \
+    src/core/BoundingVolumeHierarchy.cpp \
     src/core/Camera.cpp \
+    src/core/CameraGizmo.cpp \
     src/core/Debug.cpp \
     src/core/Geometry.cpp \
     src/core/Gizmo.cpp \
@@ -102,12 +106,19 @@ SOURCES +=\
     src/core/GLSLProgram.cpp \
     src/core/GLSLShader.cpp \
     src/core/GPUGeometry.cpp \
+    src/core/HeightfieldLoader.cpp \
+    src/core/KdTree.cpp \
     src/core/Material.cpp \
     src/core/OrthographicCamera.cpp \
     src/core/PerspectiveCamera.cpp \
+    src/core/PolygonalTexture.cpp \
     src/core/Scene.cpp \
+    src/core/SceneCache.cpp \
     src/core/SceneLoader.cpp \
+    src/core/SceneSimplifier.cpp \
+    src/core/TerrainTileCache.cpp \
     src/core/Texture.cpp \
+    src/core/TextureCache.cpp \
     src/information-measures/PolygonalI1.cpp \
     src/information-measures/PolygonalI2.cpp \
     src/information-measures/PolygonalI3.cpp \
@@ -121,7 +132,10 @@ SOURCES +=\
     src/ModuleController.cpp \
     src/ModuleTabWidget.cpp \
     src/NBestViews.cpp \
+    src/NBestViewsWorker.cpp \
+    src/ObscuranceHeightfield.cpp \
     src/ObscuranceMap.cpp \
+    src/ObscuranceRayTracer.cpp \
     src/SphereOfViewpoints.cpp \
     src/SpherePointCloud.cpp \
     src/Tools.cpp \
@@ -131,7 +145,9 @@ SOURCES +=\
 HEADERS  += \
     inc/core/AxisAlignedBoundingBox.h \
     inc/core/BoundingSphere.h \
+    inc/core/BoundingVolumeHierarchy.h \
     inc/core/Camera.h \
+    inc/core/CameraGizmo.h \
     inc/core/Debug.h \
     inc/core/Geometry.h \
     inc/core/Gizmo.h \
@@ -139,12 +155,19 @@ HEADERS  += \
     inc/core/GLSLProgram.h \
     inc/core/GLSLShader.h \
     inc/core/GPUGeometry.h \
+    inc/core/HeightfieldLoader.h \
+    inc/core/KdTree.h \
     inc/core/Material.h \
     inc/core/OrthographicCamera.h \
     inc/core/PerspectiveCamera.h \
+    inc/core/PolygonalTexture.h \
     inc/core/Scene.h \
+    inc/core/SceneCache.h \
     inc/core/SceneLoader.h \
+    inc/core/SceneSimplifier.h \
+    inc/core/TerrainTileCache.h \
     inc/core/Texture.h \
+    inc/core/TextureCache.h \
     inc/information-measures/PolygonalI1.h \
     inc/information-measures/PolygonalI2.h \
     inc/information-measures/PolygonalI3.h \
@@ -157,7 +180,10 @@ HEADERS  += \
     inc/ModuleController.h \
     inc/ModuleTabWidget.h \
     inc/NBestViews.h \
+    inc/NBestViewsWorker.h \
+    inc/ObscuranceHeightfield.h \
     inc/ObscuranceMap.h \
+    inc/ObscuranceRayTracer.h \
     inc/SphereOfViewpoints.h \
     inc/SpherePointCloud.h \
     inc/Tools.h \
@@ -178,6 +204,7 @@ OTHER_FILES += \
     shaders/DualPeelingPeel.vert \
     shaders/Normalize.frag \
     shaders/Normalize.vert \
+    shaders/Opaque.frag \
     shaders/Projection.frag \
     shaders/Projection.vert \
     shaders/Reflect.frag \
@@ -186,6 +213,9 @@ OTHER_FILES += \
     shaders/ShadePerVertexColor.frag \
     shaders/ThermalScale.frag \
     shaders/Transfer.frag \
+    shaders/Transfer.geom \
     shaders/Transfer.vert \
+    shaders/WeightedBlendedAccumulation.frag \
+    shaders/WeightedBlendedComposite.frag \
     documentation/Quoniam.vpp \
     ../TODO.txt
@@ -18,8 +18,14 @@
 class HistogramBuilder
 {
 public:
-    /// Create an InformationChannelHistogram given the Scene and the ViewpointsMesh
-    static VisibilityChannelHistogram* CreateHistogram(Scene* pScene, ViewpointsMesh* pViewpointsMesh, int pWidthResolution, bool pFaceCulling, bool pIgnoreNormals = false);
+    /// Create an InformationChannelHistogram given the Scene and the ViewpointsMesh. If \param pPreviousHistogram is given,
+    /// its rows are copied for its first viewpoints and only the viewpoints added after them are rendered.
+    static VisibilityChannelHistogram* CreateHistogram(Scene* pScene, ViewpointsMesh* pViewpointsMesh, int pWidthResolution, bool pFaceCulling, bool pIgnoreNormals = false, const VisibilityChannelHistogram* pPreviousHistogram = NULL);
+    /// Create the histogram of the original polygons from \param pCoarseHistogram of a simplified scene. \param pCoarsePolygons
+    /// is the simplified polygon of every original polygon and \param pAreas the area of the original polygons.
+    /// The projected area of every simplified polygon is split between its original polygons proportionally to their area,
+    /// so they all have the same probabilities and the polygonal measures are the ones of the simplified polygon.
+    static VisibilityChannelHistogram* ProjectHistogram(const VisibilityChannelHistogram* pCoarseHistogram, const QVector<int>& pCoarsePolygons, const QVector<float>& pAreas);
 };
 
 #endif
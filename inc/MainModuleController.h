@@ -11,6 +11,7 @@
 
 //Qt includes
 #include <QSignalMapper>
+#include <QTime>
 
 //Dependency includes
 #include "VisibilityChannelHistogram.h"
@@ -19,14 +20,18 @@
 #include "GLCanvas.h"
 #include "ModuleController.h"
 #include "NBestViews.h"
+#include "NBestViewsWorker.h"
+#include "ObscuranceHeightfield.h"
 #include "ObscuranceMap.h"
+#include "ObscuranceRayTracer.h"
+#include "PolygonalTexture.h"
 
 namespace Ui {
     class MainModule;
 }
 
 /// Controller for the view of the main module
-class MainModuleController : public ModuleController
+class MainModuleController : public ModuleController, public ObscuranceMapListener
 {
     Q_OBJECT
 public:
@@ -36,21 +41,34 @@ public:
     void CreateModuleMenus();
     void ActiveModule();
 
+    /// Show the intermediate obscurances of the progressive computation
+    void ObscurancesUpdated(const float* pObscurances, int pIterations, float pError);
+
 protected:
     void keyPressEvent(QKeyEvent *pEvent);
     void mouseMoveEvent(QMouseEvent *pEvent);
     void wheelEvent(QWheelEvent *pEvent);
     void mousePressEvent(QMouseEvent *pEvent);
+    /// Select the viewpoint nearest to where the clicked ray hits the sphere of viewpoints
+    void mouseDoubleClickEvent(QMouseEvent *pEvent);
 
 private:
     /// Scene related methods
     void LoadScene(const QString &pFileName);
     void ComputeObscurances();
+    /// Upload the obscurances per polygon to its texture and make them available as polygonal information
+    void SetObscurances(const float* pObscurances);
 
     /// Mesh of viewpoints related methods
-    void LoadViewpoints();
+    /// \param pVisibilityHistogram is the histogram of mViewpointsMesh in GetVisibilityScene() if it has already been computed, it is taken
+    void LoadViewpoints(VisibilityChannelHistogram* pVisibilityHistogram = NULL);
     void LoadViewpointsFromFile(const QString &pFileName);
     void LoadViewpointsFromSphere(float pRadius, float pAngle, int pSubdivision);
+    /// Subdivide \param pSphere where the viewpoint polygonal I2 changes more than the threshold of the interface and create
+    /// mViewpointsMesh from it. Only the new viewpoints of every level are rendered, the histogram of the last level is returned.
+    VisibilityChannelHistogram* RefineViewpointsSphere(SpherePointCloud& pSphere, const glm::vec3& pCenter, float pRadius, float pAngle);
+    /// Get the scene used to compute the histogram, the simplified one if the level of detail is below 100%
+    Scene* GetVisibilityScene();
     void ChangeNumberOfViewpoints(int pNumberOfViewpoints);
     void SaveViewpointMeasuresInformation(const QString &pFileName);
     int NextViewpoint();
@@ -64,33 +82,50 @@ private:
     void UpdateRenderingGUI();
     void UpdateOthersGUI();
     QString GetScreenshotName(int pViewpoint);
+    /// Stop the N best views selection running in background, if any, and wait for it
+    void StopNBestViews();
 
     QMenu* mMenuVisualization;
     QAction* mActionExport;
     QAction* mActionViewpointsSphere;
+    QAction* mActionViewpointsFrustums;
 
 
     Ui::MainModule* mUi;
 
     GLCanvas *mOpenGLCanvas;
     Scene *mScene;
+    /// Simplified scene used to compute the histogram, NULL if it has not been created
+    Scene *mVisibilityLOD;
+    /// Percentage of the polygons of the scene kept by mVisibilityLOD
+    int mVisibilityLODPercentage;
+    /// Polygon of mVisibilityLOD that covers every polygon of the scene
+    QVector<int> mVisibilityLODPolygons;
+    /// Normal of the dominant plane of the scene, used as the up direction of the elevation of the viewpoints
+    glm::vec3 mSceneUp;
     QVector<unsigned int> mMaxAreaPolygon;
     ViewpointsMesh *mViewpointsMesh;
     VisibilityChannelHistogram* mHistogram;
     NBestViews* mNBestViews;
+    NBestViewsWorker* mNBestViewsWorker;
+    QString mNBestViewsMeasure;
+    QTime mNBestViewsTime;
 
     bool mUpdateView;
     bool mFullScreen;
 
     int mCurrentViewpoint;
 
-    GLuint mPolygonalTexture;
-    GLuint mPolygonalVisibilityTexture;
+    PolygonalTexture* mPolygonalTexture;
+    PolygonalTexture* mPolygonalVisibilityTexture;
     ObscuranceMap* mObscurancesGenerator;
+    ObscuranceRayTracer* mObscurancesRayTracer;
+    ObscuranceHeightfield* mObscurancesHeightfield;
     bool mObscurancesComputed;
     GLuint mObscurancesTexture;
     QVector<float> mObscurancesPerPolygon;
-    GLuint mObscurancesPerPolygonTexture;
+    PolygonalTexture* mObscurancesPerPolygonTexture;
+    /// Size of the pages of the polygonal textures
     unsigned int mPolygonalTexturesSize;
 
     bool mViewPolygonalVisibility;
@@ -116,7 +151,10 @@ private slots:
     //Menu
     void OpenModel();
     void ExportInformation();
+    void ConvertViewpointsToBinary();
+    void SetVerboseLog(bool pVerbose);
     void WillDrawViewpointsSphere(bool pDraw);
+    void WillDrawViewpointsFrustums(bool pDraw);
 
     //Right panel
     void on_measureInViewpointSphereList_currentIndexChanged(int pValue);
@@ -134,6 +172,9 @@ private slots:
 
     void on_nBestViewsComputeButton_clicked();
     void on_nBestViewsComputeAllButton_clicked();
+    /// Show and save a screenshot of every viewpoint as soon as it is selected
+    void NBestViewSelected(int pPosition, int pViewpoint, float pCoverage, float pLastVQ);
+    void NBestViewsFinished();
 
     void SliderChanged(int pMeasure, int pValue);
 
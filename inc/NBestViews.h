@@ -16,6 +16,16 @@
 #include "VisibilityChannelHistogram.h"
 #include "ProjectedLocalMeasurePVO.h"
 
+/// Interface to receive every viewpoint as soon as it is selected
+class NBestViewsListener
+{
+public:
+    virtual ~NBestViewsListener() {}
+    /// Called after each selection step with the position in the selection, the viewpoint and the stats so far.
+    /// Returning false stops the selection, keeping the views already selected
+    virtual bool ViewSelected(int pPosition, int pViewpoint, float pCoverage, float pLastVQ) = 0;
+};
+
 class NBestViews
 {
 public:
@@ -29,13 +39,40 @@ public:
     void SetDependencyProjectedI3(ProjectedLocalMeasurePVO* pProjectedI3);
     void SetDependencyPolygonalI3(PolygonalI3* pPolygonalI3);
 
+    /// Set the listener notified during the selection, NULL to disable the notifications
+    void SetListener(NBestViewsListener* pListener);
+    /// Set the seed of the stochastic selection to make it reproducible, 0 to use a different random seed every run
+    void SetRandomSeed(unsigned int pSeed);
+
     /// Method to get the best n views
     /// \pre 1 <= pNumberOfViews <= mNumberOfViewpoints && 0 <= pDiscardingCriteria <= 1
     QVector< int > GetBestNViewsProjectedI1DiscardingPolygons(int pNumberOfViews, float pPercent, int pDiscardingCriteria) const;
     QVector< int > GetBestNViewsProjectedI2DiscardingPolygons(int pNumberOfViews, float pPercent, int pDiscardingCriteria) const;
     QVector< int > GetBestNViewsProjectedI3DiscardingPolygons(int pNumberOfViews, float pPercent, int pDiscardingCriteria) const;
 
+    /// Method to get the best n views with stochastic greedy: every step only evaluates a random subset of
+    /// (mNumberOfViewpoints / pNumberOfViews) * ln(1 / pEpsilon) candidates, losing at most pEpsilon of the
+    /// (1 - 1/e) guarantee of the exact greedy
+    /// \pre 1 <= pNumberOfViews <= mNumberOfViewpoints && 0 <= pDiscardingCriteria <= 1 && 0 < pEpsilon < 1
+    QVector< int > GetBestNViewsProjectedI1DiscardingPolygonsStochastic(int pNumberOfViews, float pPercent, int pDiscardingCriteria, float pEpsilon) const;
+    QVector< int > GetBestNViewsProjectedI2DiscardingPolygonsStochastic(int pNumberOfViews, float pPercent, int pDiscardingCriteria, float pEpsilon) const;
+    QVector< int > GetBestNViewsProjectedI3DiscardingPolygonsStochastic(int pNumberOfViews, float pPercent, int pDiscardingCriteria, float pEpsilon) const;
+
+    /// Get the objective (sum of the VQ of the selected views) achieved by the last selection
+    float GetLastObjective() const;
+    /// Get the coverage (relative to mSumMaxArea) achieved by the last selection
+    float GetLastCoverage() const;
+
 private:
+    /// Greedy selection shared by all the measures, evaluating pSampleSize random candidates per step
+    QVector< int > GetBestNViewsDiscardingPolygons(const ProjectedLocalMeasurePVO* pProjected, const Measure* pPolygonal, int pNumberOfViews, float pPercent, int pDiscardingCriteria, int pSampleSize) const;
+    /// Add the viewpoint to the selection and discard the polygons that it covers
+    void SelectViewpoint(int pViewpoint, int pDiscardingCriteria, QVector< bool >& pSelectedPolygons, QVector< int >& pBestViews, unsigned int& pCovered) const;
+    /// Projected measure of the viewpoint taking into account only the polygons not discarded yet
+    float GetProjectedValue(int pViewpoint, const QVector< float >& pScaledPolygonalMeasure, const QVector< bool >& pSelectedPolygons, bool& pSeePolygons) const;
+    /// Number of candidates evaluated per step by the stochastic greedy
+    int GetSampleSize(int pNumberOfViews, float pEpsilon) const;
+
     const VisibilityChannelHistogram* mHistogram;
     int mNumberOfViewpoints;
     int mNumberOfPolygons;
@@ -48,8 +85,15 @@ private:
     ProjectedLocalMeasurePVO* mProjectedI3;
     PolygonalI3* mPolygonalI3;
 
+    NBestViewsListener* mListener;
+    unsigned int mRandomSeed;
+
     QVector< unsigned int > mMaxAreaPolygon;
     float mSumMaxArea;
+
+    /// Statistics of the last selection
+    mutable float mLastObjective;
+    mutable float mLastCoverage;
 };
 
 #endif
@@ -0,0 +1,54 @@
+/// \file NBestViewsWorker.h
+/// \class NBestViewsWorker
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _N_BEST_VIEWS_WORKER_H_
+#define _N_BEST_VIEWS_WORKER_H_
+
+//Qt includes
+#include <QAtomicInt>
+#include <QThread>
+
+//Project includes
+#include "NBestViews.h"
+
+/// Thread that runs the N best views selection and emits every viewpoint as soon as it is selected
+class NBestViewsWorker : public QThread, public NBestViewsListener
+{
+    Q_OBJECT
+public:
+    /// Measures that can be used for the selection
+    enum SelectionMeasure { PROJECTED_I1, PROJECTED_I2, PROJECTED_I3 };
+
+    /// \pre pNBestViews must not be modified or destroyed while the thread is running
+    NBestViewsWorker(NBestViews* pNBestViews, SelectionMeasure pMeasure, int pNumberOfViews, float pPercent, int pDiscardingCriteria, bool pStochastic, float pEpsilon, QObject* pParent = 0);
+
+    /// Ask the selection to stop after the current step
+    void Stop();
+    /// Returns the views selected, only valid when the thread has finished
+    QVector< int > GetBestViews() const;
+
+    bool ViewSelected(int pPosition, int pViewpoint, float pCoverage, float pLastVQ);
+
+protected:
+    void run();
+
+private:
+    NBestViews* mNBestViews;
+    SelectionMeasure mMeasure;
+    int mNumberOfViews;
+    float mPercent;
+    int mDiscardingCriteria;
+    bool mStochastic;
+    float mEpsilon;
+
+    QAtomicInt mStopRequested;
+    QVector< int > mBestViews;
+
+signals:
+    /// Emitted from the worker thread every time a viewpoint is selected
+    void viewSelected(int pPosition, int pViewpoint, float pCoverage, float pLastVQ);
+};
+
+#endif
@@ -0,0 +1,81 @@
+/// \file ObscuranceHeightfield.h
+/// \class ObscuranceHeightfield
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _OBSCURANCE_HEIGHTFIELD_H_
+#define _OBSCURANCE_HEIGHTFIELD_H_
+
+//Qt includes
+#include <QVector>
+
+//Dependency includes
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+
+//Project includes
+#include "Scene.h"
+
+/// Obscurances per polygon for 2.5D terrains computed on the CPU from the horizon angles of a height grid.
+/// The horizon of every cell along each azimuth is found with a sweep-line, so the cost is O(cells * azimuths).
+/// The result has one value per polygon like the one of ObscuranceMap.
+class ObscuranceHeightfield
+{
+public:
+    /// Constructor that builds the height grid of the scene
+    ObscuranceHeightfield(Scene *pScene);
+    /// Destructor
+    ~ObscuranceHeightfield();
+
+    /// Check if the scene is a heightfield (no polygon faces downwards along some axis) returning the up direction in \param pUp.
+    /// The terrains streamed as tiles are heightfields along Y and their tiles are not paged in.
+    static bool IsHeightfield(const Scene* pScene, glm::vec3& pUp);
+
+    /// Set the scene rebuilding its height grid
+    void SetScene(Scene* pScene);
+    /// Set the distance from which the occluders do not obscure, relative to the depth range used by ObscuranceMap (0.3 by default)
+    void SetMaxDistance(float pMaxDistance);
+    /// Compute the obscurances with the horizons of \param pIterations azimuths
+    void ComputeObscurances(int pIterations);
+    /// Get the obscurance of every polygon, one value per polygon
+    const float* GetObscurances() const;
+
+private:
+    /// Rasterize the polygons of the scene keeping the highest surface of every cell
+    void BuildHeightGrid();
+    /// Accumulate in mCellObscurances the obscurance of every cell along the azimuth \param pAngle
+    void SweepAzimuth(float pAngle, float pMaxDistance);
+    /// Get the height of the cell or -FLT_MAX if there is no polygon
+    float GetHeight(int pX, int pY) const;
+    /// Get the nearest cell to \param pX, \param pY that has height, -1 if there is none
+    int FindNearestCellWithHeight(int pX, int pY) const;
+
+    Scene* mScene;
+
+    /// Axes of the grid and the height
+    int mAxisX;
+    int mAxisY;
+    int mAxisUp;
+    float mUpSign;
+
+    /// Height grid
+    int mGridWidth;
+    int mGridHeight;
+    float mCellSize;
+    glm::vec2 mGridOrigin;
+    QVector< float > mHeights;
+    /// Slope of every cell along the axes of the grid
+    QVector< float > mGradientX;
+    QVector< float > mGradientY;
+    /// Accumulated obscurance of every cell
+    QVector< float > mCellObscurances;
+    /// Cell of the centroid of every polygon
+    QVector< int > mPolygonCells;
+
+    float mMaxDistance;
+    float mSceneRadius;
+
+    float* mObscurances;
+};
+
+#endif
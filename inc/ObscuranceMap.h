@@ -8,6 +8,9 @@
 #ifndef _OBSCURANCE_MAP_
 #define _OBSCURANCE_MAP_
 
+//Qt includes
+#include <QVector>
+
 //Dependency includes
 #include "glm/vec3.hpp"
 #include "glm/vec4.hpp"
@@ -16,6 +19,15 @@
 #include "GLSLProgram.h"
 #include "Scene.h"
 
+/// Interface to receive the intermediate obscurances of the progressive computation
+class ObscuranceMapListener
+{
+public:
+    virtual ~ObscuranceMapListener() {}
+    /// Called after every batch with the obscurances normalized so far, with the same layout than GetObscurances
+    virtual void ObscurancesUpdated(const float* pObscurances, int pIterations, float pError) = 0;
+};
+
 class ObscuranceMap
 {
 public:
@@ -23,8 +35,21 @@ public:
     ObscuranceMap(Scene *pScene, int pTextureSize);
     void SetScene(Scene* pScene);
     void SetTextureSize(int pTextureSize);
+    /// Set a fixed number of peels per direction, 0 to peel until the scene is exhausted. The layers deeper than the
+    /// budget are ignored, a warning tells in how many directions the peel after the budget still rendered something
+    void SetPeelBudget(int pPeelBudget);
     void ComputeObscurances(int pIterations);
-    const float* GetImgRgbBuffer() const;
+    /// Compute the obscurances in batches of \param pBatchSize directions until the standard error of every polygon is below
+    /// \param pTolerance, \param pMaxIterations directions are used or the user cancels. Returns the number of directions used
+    int ComputeObscurancesProgressive(int pMaxIterations, int pBatchSize, float pTolerance);
+    /// Set the listener notified after every batch of the progressive computation, NULL to disable the notifications
+    void SetListener(ObscuranceMapListener* pListener);
+    /// Set the folder where the accumulated lightmap is kept so a later computation of the same scene and settings
+    /// continues from the directions already done, an empty path disables the cache. The directions are always the
+    /// same sequence, so a cache is only used if it has at most the number of directions requested
+    void SetCacheDirectory(const QString& pDirectory);
+    /// Get the obscurance of every polygon, one value per polygon
+    const float* GetObscurances() const;
 
 private:
     //GLSL
@@ -38,6 +63,7 @@ private:
     glm::vec4 mPreviousClearColor;
     GLint mPreviousViewport[4];
     GLint mBinded2DTexture;
+    GLint mBinded2DArrayTexture;
     GLint mBindedReadFramebuffer;
     GLint mBindedDrawFramebuffer;
     GLint mBindedRenderbuffer;
@@ -45,14 +71,21 @@ private:
     GLint mPreviousProgram;
     GLfloat mPreviousPointSize;
 
-    float* mImgRgbBuffer;
+    float* mObscurances;
     int mResProjectionX;  //Resolution
     int mResProjectionY;  //Resolution
-    int mResLightmapX;    //Resolution
-    int mResLightmapY;    //Resolution
+    /// Paged layout of the lightmap, the same than the one of PolygonalTexture
+    int mPageSize;
+    int mNumberOfPages;
 
     int mCount;
 
+    /// Folder of the cached lightmaps and hash of the geometry of the scene used to identify them
+    QString mCacheDirectory;
+    QByteArray mSceneHash;
+
+    ObscuranceMapListener* mListener;
+
     //Textures and buffers
     GLuint mTexName;
     GLuint mTexProjeccions[2]; //Texture name
@@ -63,8 +96,13 @@ private:
     GLuint mFbLightmapNormalization; // Lightmap Normalization
     GLuint mProjectionsPBO[2];	// PBOs to store the projections.
 
-    GLuint mQueryId;
-    float* mBlueBuffer;
+    /// Ring of occlusion queries, one per peel, read with some peels of latency
+    static const int NUMBER_OF_QUERIES = 4;
+    GLuint mQueryIds[NUMBER_OF_QUERIES];
+    /// Peels issued without checking if the scene is exhausted, it grows with the depth complexity found
+    int mAdaptivePeelBudget;
+    /// Fixed number of peels per direction, 0 if it is adaptive
+    int mFixedPeelBudget;
 
     Scene* mScene;						// Mesh Data
     glm::vec3 mEsferaCenter;
@@ -75,11 +113,27 @@ private:
     void RestoreOpenGLStats();
     void InitializeProjection();
     void InitializeLightmap();
-    float VanDerCorput(int pI, int pBase) const;
     glm::vec3 RandomPoint(float pR, const glm::vec3& pC);
     void UpdateTexture(int pIterations);
+    /// Peel the scene along a new direction accumulating its obscurances into the lightmap,
+    /// \param pTruncatedDirections is incremented if the direction is cut by the fixed peel budget
+    void RenderDirection(int& pMaxPeels, int& pTruncatedDirections);
+    /// Warn if some directions have been cut by the fixed peel budget
+    void WarnTruncatedDirections(int pTruncatedDirections, int pDirections) const;
+    /// Update the statistics of the batch means of every polygon returning the maximum standard error of the estimates
+    float UpdateBatchStatistics(const float* pAccumulated, QVector< float >& pPreviousSum, QVector< float >& pPreviousSamples, QVector< int >& pBatches, QVector< float >& pMean, QVector< float >& pM2) const;
     void NormalizeLightmap();
-    unsigned int RenderProjeccions(const glm::vec3 &pCameraPosition, int pBuffer, int pFirst);
+    /// Read all the pages of the lightmap \param pTexture with the format \param pFormat into \param pData
+    void ReadLightmap(GLuint pTexture, GLenum pFormat, float* pData) const;
+    /// Get the cache file of the current scene and settings
+    QString GetCacheFileName() const;
+    /// Clear the lightmap and load into it the cached accumulation if there is one with at most \param pMaxIterations
+    /// directions. \param pAccumulated receives the accumulated lightmap and the number of directions already done is returned
+    int ResumeAccumulation(float* pAccumulated, int pMaxIterations);
+    /// Read the accumulated lightmap into \param pAccumulated and save it with the number of directions done,
+    /// unless the cache already has more directions
+    void SaveAccumulation(float* pAccumulated) const;
+    void RenderProjeccions(const glm::vec3 &pCameraPosition, int pBuffer, int pFirst, GLuint pQueryId);
     void RenderTransfer(int pBuffer, int pFirst);
 };
 
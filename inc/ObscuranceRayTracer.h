@@ -0,0 +1,50 @@
+/// \file ObscuranceRayTracer.h
+/// \class ObscuranceRayTracer
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _OBSCURANCE_RAY_TRACER_H_
+#define _OBSCURANCE_RAY_TRACER_H_
+
+//Project includes
+#include "BoundingVolumeHierarchy.h"
+#include "Scene.h"
+
+/// Obscurances per polygon computed on the CPU tracing rays against a bounding volume hierarchy of the scene.
+/// It does not need an OpenGL context and the result has one value per polygon like the one of ObscuranceMap.
+class ObscuranceRayTracer
+{
+public:
+    /// Constructor that builds the hierarchy of the scene
+    ObscuranceRayTracer(Scene *pScene);
+    /// Destructor
+    ~ObscuranceRayTracer();
+
+    /// Set the scene rebuilding its hierarchy
+    void SetScene(Scene* pScene);
+    /// Set the distance from which the occluders do not obscure, relative to the depth range used by ObscuranceMap (0.3 by default)
+    void SetMaxDistance(float pMaxDistance);
+    /// Compute the obscurances tracing \param pIterations rays from every polygon using all the threads of the processor.
+    /// The polygons whose rays only hit back faces take the mean obscurance of the polygons that share a vertex with them.
+    void ComputeObscurances(int pIterations);
+    /// Get the obscurance of every polygon, one value per polygon
+    const float* GetObscurances() const;
+
+private:
+    friend class ObscuranceRayTracerTask;
+
+    /// Compute the obscurances of the polygons [pFirstPolygon, pLastPolygon)
+    void ComputeObscurances(int pFirstPolygon, int pLastPolygon, int pIterations);
+    /// Give to the polygons marked as unresolved the mean obscurance of their neighbours
+    void FillUnresolvedObscurances();
+
+    Scene* mScene;
+    BoundingVolumeHierarchy* mHierarchy;
+
+    float mMaxDistance;
+    float mSceneRadius;
+
+    float* mObscurances;
+};
+
+#endif
@@ -9,6 +9,7 @@
 #define _SPHERE_POINT_CLOUD_H_
 
 //Qt includes
+#include <QHash>
 #include <QVector>
 
 //Dependency includes
@@ -37,6 +38,16 @@ public:
     /// Generate 10*4^depth+2 points quasi-uniformly distributed using the recursive
     /// subdivision of faces, starting from an icosahedron
     void SetToQuasiUniform(unsigned char pDepth);
+    /// Keep only the points with an elevation between \a pMinElevation and \a pMaxElevation degrees over the plane
+    /// perpendicular to \a pUp. The faces with a discarded point are removed and the neighbours are kept between the
+    /// remaining points, so a hemisphere has the same density as the whole sphere with half of the points.
+    void RestrictToElevationBand(const glm::vec3 &pUp, float pMinElevation, float pMaxElevation);
+    /// Subdivide the faces \a pFaces in four, the new points are added after the existing ones so their indices do not change.
+    /// The refinement is conforming: the faces with two or more split edges are subdivided in four too and the faces with one
+    /// are split in two, so no point is left in the middle of an edge and the sphere can be refined several times.
+    void SubdivideFaces(const QVector<int> &pFaces);
+    /// Return true if every edge is shared by exactly two faces with opposite orientations
+    bool IsWatertight() const;
 
     /// Return the faces of the triangles
     QVector<unsigned int> GetFaces() const;
@@ -61,6 +72,12 @@ private:
     void CreateIcosahedron();
     /// Find if a vertex already exists, if exists return the index
     bool FindSphereCloudVertex(const glm::vec3 &pV, unsigned int &pPosition) const;
+    /// Add the vertex \a pV to the point cloud and the spatial hash, return its index
+    unsigned int AddSphereCloudVertex(const glm::vec3 &pV);
+    /// Add the existing vertex \a pIndex to the spatial hash
+    void InsertInSpatialHash(unsigned int pIndex);
+    /// Add a new face with the existing vertices \a pV1, \a pV2 and \a pV3
+    void AddSphereCloudTriangle(unsigned int pV1, unsigned int pV2, unsigned int pV3);
     /// Create a new face with 3 vertex from the point cloud
     void CreateSphereCloudTriangle(const glm::vec3 &pV1, const glm::vec3 &pV2, const glm::vec3 &pV3);
     /// Subdivide the point cloud recursively until \a pDepth
@@ -87,6 +104,10 @@ protected:
     QVector< glm::vec2 > mVerticesInUVCoordinates;
     /// Neighbours of the vertexs
     QVector< QVector<int> > mNeighbours;
+    /// First vertex of every cell of the spatial hash used while the sphere is subdivided
+    QHash< quint64, int > mVertexCells;
+    /// Next vertex in the same cell of the spatial hash, -1 for the last one
+    QVector< int > mNextVertexInCell;
 };
 
 #endif
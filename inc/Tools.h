@@ -28,8 +28,13 @@ public:
     static float Mean(const QVector< float >& pValues, const QVector<float>& pWeights = QVector<float>(), float pPower = 1.0f);
 
     static float TriangleArea(const glm::vec3& pA, const glm::vec3& pB, const glm::vec3& pC);
+    /// Get the element \param pI of the Van der Corput sequence in base \param pBase, the result is in [0, 1)
+    static float VanDerCorput(int pI, int pBase);
 
     static QString GetProgramPath();
+
+    /// Parse a number at \param pText without allocations nor depending on the locale and move \param pText after it, return false if there is no number
+    static bool ParseFloat(const char*& pText, const char* pEnd, float& pValue);
 private:    
     static glm::vec4 ConvertNormalizedFloatToColor(float pValue, bool pInverted);
 };
@@ -14,7 +14,10 @@
 
 //Project includes
 #include "Camera.h"
+#include "CameraGizmo.h"
 #include "Geometry.h"
+#include "KdTree.h"
+#include "SpherePointCloud.h"
 
 /// Classe per crear una malla de punts de vista
 class ViewpointsMesh
@@ -23,8 +26,9 @@ public:
     /// Constructor de la malla de punts de vista donada una llista de cameres
     ViewpointsMesh(const QVector< Camera * >& pCameras);
     /// Constructor de la malla de punts de vista basada amb la descomposici del mxim slid platnic
-    ViewpointsMesh(const glm::vec3& pCenter, float pRadius, float pAngle, float pAspectRatio, int pSubdivision);
-    /// Constructor de la malla de punts de vista donat un fitxer xml o txt
+    /// Els punts de vista sn els punts de \a pSphere, en el mateix ordre
+    ViewpointsMesh(const SpherePointCloud& pSphere, const glm::vec3& pCenter, float pRadius, float pAngle, float pAspectRatio);
+    /// Constructor de la malla de punts de vista donat un fitxer xml, txt o binari (vpb)
     /// \param pCenter, pRadius Centre i radi de l'escena per tal d'ajustar el near plane i el far plane
     ViewpointsMesh(const glm::vec3& pCenter, float pRadius, const QString& pFileName);
     /// Copy constructor
@@ -32,6 +36,9 @@ public:
     /// Destructor de la malla de punts de vista
     ~ViewpointsMesh();
 
+    /// Converteix el fitxer de punts de vista xml o txt \a pFileName al format binari \a pBinaryFileName, que es llegeix molt ms rpid
+    static bool ConvertToBinary(const QString& pFileName, const QString& pBinaryFileName);
+
     /// S'assigna la llista de punts de vista
     void SetCameras(const QVector< Camera * >& pCameras);
     /// S'assigna la relaci de vens de cada punt de vista
@@ -43,6 +50,10 @@ public:
     Camera* GetViewpoint( int pIndex ) const;
     /// Retorna el punt de vista ms proper a \a pPoint.
     int GetNearestViewpoint( const glm::vec3& pPoint ) const;
+    /// Retorna els \a pNumberOfViewpoints punts de vista ms propers a \a pPoint, del ms proper al ms lluny
+    QVector< int > GetNearestViewpoints( const glm::vec3& pPoint, int pNumberOfViewpoints ) const;
+    /// Retorna els punts de vista a una distncia de \a pPoint menor o igual que \a pRadius
+    QVector< int > GetViewpointsInRadius( const glm::vec3& pPoint, float pRadius ) const;
     /// Retorna el nombre de punts de vista
     int GetNumberOfViewpoints() const;
     /// Retorna la relaci de vens de cada punt de vista
@@ -53,6 +64,10 @@ public:
     int GetNeighbour( int pViewpoint, int pNeighbourIndex ) const;
     /// Retorna la malla poligonal
     Geometry* GetMesh() const;
+    /// Retorna la malla amb els frustums de tots els punts de vista, es crea el primer cop que es demana
+    Geometry* GetCamerasMesh();
+    /// Retorna si la malla amb els frustums ja s'ha creat
+    bool HasCamerasMesh() const;
     /// Retorna la llista de posicions dels punts de vista
     QVector< glm::vec3 > GetVertices() const;
     /// Retorna la llista de cares de la malla poligonal
@@ -69,6 +84,10 @@ private:
     Geometry* mMesh;
     /// Llista de cares de la malla poligonal
     QVector< unsigned int > mFaces;
+    /// ndex espacial de les posicions dels punts de vista
+    KdTree* mKdTree;
+    /// Frustums de tots els punts de vista en una sola malla, NULL si encara no s'han demanat
+    CameraGizmo* mCamerasGizmo;
 };
 
 #endif
@@ -7,6 +7,7 @@
 #define _AXIS_ALIGNED_BOUNDING_BOX_H_
 
 //Dependency includes
+#include "glm/mat4x4.hpp"
 #include "glm/vec3.hpp"
 
 //Project includes
@@ -31,6 +32,10 @@ public:
     /// Get maximum of every axis
     glm::vec3 GetMax() const;
 
+    /// Return if the box is at least partially inside the frustum of the view-projection matrix \param pViewProjection.
+    /// It is conservative: some boxes near the corners of the frustum are considered inside.
+    bool Intersects(const glm::mat4& pViewProjection) const;
+
     /// Create the minimum axis-aligned bounding box that includes pAABB0 and pAABB1
     static AxisAlignedBoundingBox* Merge(AxisAlignedBoundingBox* pAABB0, AxisAlignedBoundingBox* pAABB1);
 
@@ -33,6 +33,8 @@ public:
 
     /// Create the minimum bounding sphere that includes pBS0 and pBS1
     static BoundingSphere* Merge(const BoundingSphere* pBS0, const BoundingSphere* pBS1);
+    /// Grow the sphere \param pCenter, \param pRadius to the minimum one that also includes \param pOtherCenter, \param pOtherRadius
+    static void Merge(glm::vec3& pCenter, float& pRadius, const glm::vec3& pOtherCenter, float pOtherRadius);
 
 protected:
     /// Center
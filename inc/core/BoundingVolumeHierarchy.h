@@ -0,0 +1,70 @@
+/// \file BoundingVolumeHierarchy.h
+/// \class BoundingVolumeHierarchy
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _BOUNDING_VOLUME_HIERARCHY_H_
+#define _BOUNDING_VOLUME_HIERARCHY_H_
+
+//Qt includes
+#include <QVector>
+
+//Dependency includes
+#include "glm/vec3.hpp"
+
+//Project includes
+#include "Scene.h"
+
+/// Bounding volume hierarchy over the triangles of a scene built with the surface area heuristic.
+/// The triangles keep the polygon numbering of the scene so ray hits can be used as polygon identifiers.
+class BoundingVolumeHierarchy
+{
+public:
+    /// Constructor that builds the hierarchy with all the polygons of \param pScene
+    BoundingVolumeHierarchy(const Scene* pScene);
+    /// Destructor
+    ~BoundingVolumeHierarchy();
+
+    /// Get the number of triangles
+    int GetNumberOfTriangles() const;
+    /// Get the vertex \param pVertex (0, 1 or 2) of the triangle \param pTriangle
+    glm::vec3 GetVertex(int pTriangle, int pVertex) const;
+    /// Get the normal of the triangle \param pTriangle given by the order of its vertices
+    glm::vec3 GetNormal(int pTriangle) const;
+    /// Get the closest triangle hit by the ray at a distance lower than \param pMaxDistance ignoring the triangle \param pIgnoredTriangle.
+    /// Returns -1 if there is no hit, otherwise \param pDistance is set to the distance of the hit
+    int Intersect(const glm::vec3& pOrigin, const glm::vec3& pDirection, float pMaxDistance, int pIgnoredTriangle, float& pDistance) const;
+
+private:
+    /// Node of the hierarchy stored in depth-first order, the left child of an inner node is the next node
+    struct Node
+    {
+        /// Bounding box of the node
+        glm::vec3 mMin;
+        glm::vec3 mMax;
+        /// First triangle of a leaf or right child of an inner node
+        int mOffset;
+        /// Number of triangles of a leaf, 0 for inner nodes
+        int mCount;
+        /// Axis used to split an inner node
+        int mAxis;
+    };
+
+    /// Build the subtree with the triangles [pFirst, pFirst + pCount) of mTriangleOrder
+    void Build(int pFirst, int pCount, int pDepth);
+    /// Test the ray against the triangle returning the distance of the hit or a negative value
+    float IntersectTriangle(int pTriangle, const glm::vec3& pOrigin, const glm::vec3& pDirection) const;
+
+    /// Vertices of the triangles, three per triangle
+    QVector< glm::vec3 > mVertices;
+    /// Bounding box and centroid of every triangle used during the build
+    QVector< glm::vec3 > mTriangleMin;
+    QVector< glm::vec3 > mTriangleMax;
+    QVector< glm::vec3 > mCentroids;
+    /// Triangles ordered by leaves
+    QVector< int > mTriangleOrder;
+    /// Nodes of the hierarchy
+    QVector< Node > mNodes;
+};
+
+#endif
@@ -9,16 +9,17 @@
 
 //Qt includes
 #include <QString>
+#include <QVector>
 
 //Dependency includes
 #include "glm/mat4x4.hpp"
 #include "glm/vec3.hpp"
+#include "glm/vec4.hpp"
 
-//Project includes
-#include "Gizmo.h"
-
-/// Abstract camera class with methods to configure a generic camera
-class Camera : public Gizmo
+/// Abstract camera class with methods to configure a generic camera.
+/// A camera is only the data to compute its matrices, so copying it is cheap. Its gizmo is not part of the camera,
+/// the gizmos of many cameras are drawn together with a CameraGizmo.
+class Camera
 {
 public:
     /// Constructor
@@ -67,6 +68,9 @@ public:
     /// Method to clone a camera
     virtual Camera* Clone() const = 0;
 
+    /// Add the vertices, the colors and the line indexs of the gizmo of the camera at the end of the vectors
+    virtual void AddGizmo(QVector<glm::vec4>& pVertices, QVector<glm::vec4>& pColors, QVector<unsigned int>& pIndexs) const = 0;
+
     /// Name of the camera
     QString mName;
 
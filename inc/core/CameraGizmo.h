@@ -0,0 +1,40 @@
+/// \file CameraGizmo.h
+/// \class CameraGizmo
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _CAMERA_GIZMO_H_
+#define _CAMERA_GIZMO_H_
+
+//Qt includes
+#include <QVector>
+
+//Project includes
+#include "Camera.h"
+#include "Gizmo.h"
+
+/// Gizmo that shows the frustums of a set of cameras. All the frustums are in one mesh, so they are drawn with a
+/// single draw call and only one buffer of the GPU whatever the number of cameras.
+class CameraGizmo : public Gizmo
+{
+public:
+    /// Constructor, the cameras are not owned by the gizmo and they have to exist while it is used
+    CameraGizmo(const QVector< Camera* >& pCameras);
+    /// Destructor
+    ~CameraGizmo();
+
+    /// Set the cameras and update the mesh, it also has to be called after changes in the cameras
+    void SetCameras(const QVector< Camera* >& pCameras);
+
+protected:
+    /// Cameras
+    QVector< Camera* > mCameras;
+
+    /// Create the mesh of the gizmo with the indexs, positions and colors
+    void CreateMesh();
+
+    /// Update the positions of the vertices of the mesh
+    void UpdatePositions();
+};
+
+#endif
@@ -13,6 +13,9 @@
 class Debug
 {
 public:
+    /// Amount of log messages, warnings and errors are always shown
+    enum Verbosity{ Quiet, Normal, Verbose };
+
     /// Output a log message
     static void Log(const QString& pMessage);
     /// Output a warning message
@@ -20,6 +23,11 @@ public:
     /// Output a error message
     static void Error(const QString& pMessage);
 
+    /// Set the verbosity, with Quiet the log messages are discarded
+    static void SetVerbosity(Verbosity pVerbosity);
+    /// Get the verbosity, messages of every item of big inputs should only be logged when it is Verbose
+    static Verbosity GetVerbosity();
+
     /// Set the console
     static void SetConsole(QPlainTextEdit * pConsole);
 
@@ -40,6 +48,8 @@ private:
 
     /// Console
     static QPlainTextEdit* mConsole;
+    /// Verbosity
+    static Verbosity mVerbosity;
 
 };
 #endif
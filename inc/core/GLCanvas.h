@@ -42,11 +42,11 @@ public:
     /// Add a mesh that will be render with the color per vertex
     void AddPerVertexMesh(Geometry* pPerVertexMesh);
 
-    /// Set the polygonal visibility texture
+    /// Set the polygonal visibility texture, a texture array with the layout of PolygonalTexture
     void SetPolygonalVisibilityTexture(GLuint pPolygonalVisibilityTexture);
-    /// Set the polygonal texture of the scene
+    /// Set the polygonal texture of the scene, a texture array with the layout of PolygonalTexture
     void SetPolygonalTexture(GLuint pPolygonalTexture);
-    /// Set the size of  the polygonal texture
+    /// Set the size of the pages of the polygonal textures
     void SetPolygonalTextureSize(unsigned int pPolygonalTextureSize);
 
     /// Get the program used to do the rendering
@@ -56,6 +56,8 @@ public:
 
     /// Set the camera used to render
     void SetCamera(const Camera* pCamera);
+    /// Move the camera used to render without replacing it
+    void SetCameraView(const glm::vec3& pPosition, const glm::vec3& pLookAt, const glm::vec3& pUp);
     /// Get the camera used to render
     const Camera* GetCamera();
     /// Get the scene rendered
@@ -68,6 +70,9 @@ public slots:
     void WillDrawBoundingSphere(bool pDraw);
     /// Set if the materials will be applied for the rendering
     void ApplyMaterials(bool pApplyMaterials);
+    /// Set if the translucent geometry is drawn with weighted blended transparency instead of dual depth peeling.
+    /// It is approximated but it has a fixed cost of two passes whatever the depth complexity
+    void UseWeightedBlendedTransparency(bool pWeightedBlended);
 
 protected:
     /// Initialize the OpenGL
@@ -80,6 +85,10 @@ protected:
     void keyPressEvent(QKeyEvent *pEvent);
 
 private:
+    /// Get if there is geometry to draw with transparency: visible meshes with per vertex color or bounding volumes
+    bool HasTranslucentGeometry() const;
+    /// Draw the geometry with transparency, the scene is opaque and it is drawn apart
+    void DrawTranslucentGeometry();
     /// Draw the bounding volumes
     void DrawGeometryBoundingVolumes();
 
@@ -104,6 +113,8 @@ private:
     bool mDrawWireframe;
     /// Boolean to know if the materials will be applied for the rendering
     bool mApplyMaterials;
+    /// Boolean to know if the translucent geometry is drawn with weighted blended transparency
+    bool mWeightedBlendedTransparency;
 
     /// Camera used for the rendering
     Camera* mFreeCamera;
@@ -115,14 +126,18 @@ private:
 
     /// Shader used to initialize the min-max depth buffer for the dual depth peeling
     GLSLProgram *mShaderDualInit;
-    /// Shader used to do the main pass of the renderer
-    GLSLProgram *mShaderDualPeel;
+    /// Shader used to draw the opaque scene in a single pass with the depth test
+    GLSLProgram *mShaderOpaque;
     /// Shader used to do the main pass of the renderer for the gizmos
     GLSLProgram *mShaderDualPeelPerVertexColor;
     /// Shader used to alpha-blend the back color for the dual depth peeling
     GLSLProgram *mShaderDualBlend;
     /// Shader used to combinte the color of the front and the back buffer for the dual depth peeling
     GLSLProgram *mShaderDualFinal;
+    /// Shader used to accumulate the translucent geometry for the weighted blended transparency
+    GLSLProgram *mShaderWeightedBlendedAccumulation;
+    /// Shader used to blend the accumulated translucent geometry over the opaque one
+    GLSLProgram *mShaderWeightedBlendedComposite;
 
     /// Variable used for the dual deep peeling
     GLuint mQueryId;
@@ -138,6 +153,14 @@ private:
     GLuint mDualBackTempTexId[2];
     /// Variable used for the dual deep peeling
     GLuint mDualBackBlenderTexId;
+    /// Depth buffer of the opaque geometry, the translucent geometry behind it is not peeled
+    GLuint mOpaqueDepthId;
+    /// Framebuffer of the weighted blended transparency
+    GLuint mWeightedBlendedFboId;
+    /// Weighted sum of the colors and product of the transparencies for the weighted blended transparency
+    GLuint mWeightedAccumulationTexId;
+    /// Sum of the weights for the weighted blended transparency
+    GLuint mWeightedWeightTexId;
     /// Variable used for the dual deep peeling
     GLenum mDrawBuffers[7];
 
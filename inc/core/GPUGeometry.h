@@ -23,8 +23,12 @@ public:
 
     /// Set the vertices of the mesh
     void SetVerticesData(unsigned int pSize, unsigned int pStride, const float *pData);
+    /// Set the vertices of the mesh quantized to 16 bits, the position is \param pOffset + value / 65535 * \param pScale
+    void SetVerticesData(unsigned int pSize, const unsigned short *pData, const glm::vec3& pOffset, const glm::vec3& pScale);
     /// Set the normals of the mesh
     void SetNormalsData(unsigned int pSize, const float *pData);
+    /// Set the normals of the mesh encoded in two components with an octahedral mapping
+    void SetNormalsData(unsigned int pSize, const short *pData);
     /// Set the colors of the mesh
     void SetColorData(unsigned int pSize, unsigned int pStride, const float *pData);
     /// Set the tangents of the mesh
@@ -35,6 +39,8 @@ public:
     void SetTextCoordsData(unsigned int pSize, const float *pData);
     /// Set the information of connectivities between vertices of the mesh
     void SetIndexsData(unsigned int pSize, Geometry::Topology pTopology, const unsigned int *pData);
+    /// Set the information of connectivities between vertices of the mesh with 16-bit indices
+    void SetIndexsData(unsigned int pSize, Geometry::Topology pTopology, const unsigned short *pData);
 
     /// Draw the mesh
     void Draw() const;
@@ -42,6 +48,13 @@ public:
     /// Configure the vertex array object
     void ConfigureVAO();
 
+    /// Add a reference of another Geometry that draws with the same buffers
+    void AddReference();
+    /// Remove a reference to \param pGPUGeometry, it is deleted when there are no more references
+    static void Release(GPUGeometry* pGPUGeometry);
+    /// Is it used by more than one Geometry?
+    bool IsShared() const;
+
 private:
     /// We don't want a default copy constructor because it will not work due to it will not duplicate the memory in the gpu
     GPUGeometry(GPUGeometry const&){}
@@ -55,12 +68,19 @@ private:
     unsigned int mVerticesId;
     /// Stride of the vertices
     unsigned int mVerticesStride;
+    /// Type of the components of the vertices
+    GLenum mVerticesType;
+    /// Offset and scale to decode the quantized vertices
+    glm::vec3 mPositionOffset;
+    glm::vec3 mPositionScale;
     /// Id of the vertex buffer object that stores the color of the vertices
     unsigned int mColorsId;
     /// Stride of the colors
     unsigned int mColorsStride;
     /// Id of the vertex buffer object that stores the normal of the vertices
     unsigned int mNormalsId;
+    /// Boolean to know if the normals are octahedral encoded
+    bool mOctNormals;
     /// Id of the vertex buffer object that stores the tangent of the vertices
     unsigned int mTangentsId;
     /// Id of the vertex buffer object that stores the bitangent of the vertices
@@ -71,7 +91,11 @@ private:
     unsigned int mIndexsId;
     /// Number of elements of the mesh
     unsigned int mIndexsSize;
+    /// Type of the indices
+    GLenum mIndexsType;
     /// Topology of the mesh
     Geometry::Topology mMeshTopology;
+    /// Number of Geometry objects that use the buffers
+    int mReferences;
 };
 #endif
@@ -6,6 +6,9 @@
 #ifndef _GEOMETRY_H_
 #define _GEOMETRY_H_
 
+//Qt includes
+#include <QCryptographicHash>
+
 //Dependency includes
 #include "glm/mat4x4.hpp"
 #include "glm/vec2.hpp"
@@ -19,6 +22,7 @@
 
 class Scene;
 class GPUGeometry;
+class TerrainTileCache;
 
 /// Class to wrap a 3d mesh that is not stored into the GPU until the GetGPUGeometry method is called.
 class Geometry
@@ -35,7 +39,9 @@ public:
     };
     /// Constructor
     Geometry(const QString &pName, Topology pT);
-    /// Copy constructor (vertex neighbours have to be set again)
+    /// Copy constructor (vertex neighbours have to be set again and a tile of a TerrainTileCache has to be resident,
+    /// the copy is always in memory). If the original has released its attributes the copy draws with the same
+    /// GPU buffers instead, so it has the normals and texture coordinates when rendered but not in the CPU.
     Geometry(const Geometry& pGeometry);
     /// Destructor
     ~Geometry();
@@ -62,11 +68,22 @@ public:
     /// Set the information of connectivities between vertices of the mesh
     void SetIndexsData(unsigned int pSize, const unsigned int *pData);
 
-    QVector<float> GetVerticesData() const;
+    /// Adopt the vertices \param pData with \param pStride components, the buffer is shared instead of copied
+    void SetVerticesData(const QVector<float>& pData, unsigned int pStride);
+    /// Adopt the normals \param pData, the buffer is shared instead of copied
+    void SetNormalsData(const QVector<float>& pData);
+    /// Adopt the texture coordinates \param pData, the buffer is shared instead of copied
+    void SetTextCoordsData(const QVector<float>& pData);
+    /// Adopt the indices \param pData, the buffer is shared instead of copied
+    void SetIndexsData(const QVector<unsigned int>& pData);
+
+    const QVector<float>& GetVerticesData() const;
     unsigned int GetVerticesStride() const;
 
     /// Set the name of the mesh
     void SetName(const QString &pName);
+    /// Get the name of the mesh
+    QString GetName() const;
     /// Set the topology
     void SetTopology( Topology pTopology );
 
@@ -77,8 +94,30 @@ public:
 
     /// Have to be rendered?
     void SetVisible(bool pVisible);
-
-    /// Compute the bounding volumes
+    /// Get if it has to be rendered
+    bool IsVisible() const;
+
+    /// Store the mesh in the GPU with 16-bit positions relative to the bounding box, octahedral encoded normals,
+    /// 16-bit indices if there are less than 65536 vertices and without tangents and bitangents
+    void SetCompactStorage(bool pCompactStorage);
+    /// Is the mesh stored in the GPU with the compact format?
+    bool IsCompactStorage() const;
+    /// Free the normals, colors, texture coordinates, tangents and bitangents in the CPU once they are in the GPU.
+    /// The positions and the indices are kept because they are used to compute the measures and the obscurances.
+    /// If the positions or the indices change while the buffers are shared with a copy, the mesh gets its own
+    /// buffers and the released attributes are lost.
+    void SetReleaseAttributesAfterUpload(bool pRelease);
+
+    /// Page in the buffers of the mesh if it is a tile of a TerrainTileCache that is not in memory,
+    /// it has to be called before reading the positions or the indices of a tile
+    void MakeResident();
+
+    /// Compute the bounding sphere with a single pass that grows the minimum sphere of the extremal vertices instead of
+    /// the exact minimum sphere. The bound of the error of the radius is shown with the information of the mesh.
+    void SetApproximateBoundingSphere(bool pApproximate);
+    /// Compute the bounding volumes. The bounding box and the extremal vertices along 13 directions are found in a single pass,
+    /// with several threads for big meshes. The exact bounding sphere is the minimum sphere of the extremal vertices
+    /// extended with the vertices that are outside until all of them are inside.
     void ComputeBoundingVolumes();
     /// Show information of the mesh like faces, vertices and diameter of the bounding sphere
     void ShowInformation() const;
@@ -109,13 +148,24 @@ public:
     glm::vec3 GetVertexByIndexPosition(int pIndex) const;
     /// Get the index value givent the position in the array
     unsigned int GetValueOfIndex(int pPosition) const;
+    /// Add the topology, the positions and the indices of the mesh to \param pHash
+    void AddContentToHash(QCryptographicHash& pHash) const;
 
     void Normalize(const glm::vec3& pCenter, float pRadius);
     void Transform(const glm::mat4 &pTransform);
 
 private:
+    /// The cache of scenes reads and writes the buffers directly
+    friend class SceneCache;
+    /// The cache of terrain tiles pages the buffers in and out directly
+    friend class TerrainTileCache;
+
     /// Get the GPUGeometry creating it if it's necessary
     const GPUGeometry* GetGPUGeometry();
+    /// Upload the positions, normals and indices to the GPUGeometry with the compact format
+    void UploadCompactGPUGeometry();
+    /// Stop using the GPUGeometry, it is deleted if no copy shares it
+    void ReleaseGPUGeometry();
 
     /// Data of the positions of the vertices
     QVector<float> mVertexData;
@@ -143,6 +193,16 @@ private:
     Material* mMaterial;
     /// Have to be rendered?
     bool mVisible;
+    /// Is the mesh stored in the GPU with the compact format?
+    bool mCompactStorage;
+    /// Have to be released the attributes once they are in the GPU?
+    bool mReleaseAttributesAfterUpload;
+    /// Are the attributes only in the buffers of the GPUGeometry?
+    bool mAttributesReleased;
+    /// Is the bounding sphere approximate?
+    bool mApproximateBoundingSphere;
+    /// Upper bound of the relative error of the radius of the approximate bounding sphere
+    float mBoundingSphereErrorBound;
 
     /// Name of the mesh
     QString mName;
@@ -157,5 +217,14 @@ private:
     GPUGeometry* mGPUGeometry;
     /// Boolean to know if the GPUGeometry needs to be updated
     bool mNeedGPUGeometryUpdate;
+
+    /// Cache of terrain tiles the mesh belongs to, NULL if it is always in memory
+    TerrainTileCache* mTileCache;
+    /// Are the buffers of the mesh in memory?
+    bool mResident;
+    /// Number of indices of the mesh when it is paged out
+    int mNumberOfIndicesOnDisk;
+    /// Number of vertices of the mesh when it is paged out
+    int mNumberOfVerticesOnDisk;
 };
 #endif
@@ -0,0 +1,55 @@
+/// \file HeightfieldLoader.h
+/// \class HeightfieldLoader
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _HEIGHTFIELD_LOADER_H_
+#define _HEIGHTFIELD_LOADER_H_
+
+//Qt includes
+#include <QFileInfo>
+#include <QString>
+#include <QVector>
+
+//Project includes
+#include "Scene.h"
+
+/// Class to load digital elevation models without Assimp. Supported formats: ESRI ASCII grid (.asc),
+/// SRTM (.hgt) and square tiles of little-endian 32-bit floats (.f32, .raw).
+/// The grid is converted directly into a mesh with Y up, one vertex per sample and two triangles per cell.
+/// The grids bigger than the memory are split into tiles that are streamed from disk by a TerrainTileCache.
+class HeightfieldLoader
+{
+public:
+    /// Return if the file \param pPath has the extension of a supported elevation model
+    static bool IsHeightfield(const QString& pPath);
+    /// Create a scene from the elevation model \param pPath, NULL if it can not be read
+    static Scene* LoadScene(const QString& pPath);
+
+private:
+    /// Elevation grid read from a file, the rows go from north to south
+    struct Grid
+    {
+        int columns;
+        int rows;
+        float cellSize;
+        float noData;
+        QVector< float > heights;
+    };
+
+    /// Get the folder of the tiles of the elevation model, named by a hash of its path, size and modification time
+    static QString GetTileDirectory(const QFileInfo& pFileInfo);
+    /// Read an ESRI ASCII grid
+    static bool ReadAsciiGrid(const QString& pPath, Grid& pGrid);
+    /// Read an SRTM tile of big-endian 16-bit integers
+    static bool ReadHgt(const QString& pPath, Grid& pGrid);
+    /// Read a square tile of 32-bit floats
+    static bool ReadRawFloat(const QString& pPath, Grid& pGrid);
+    /// Return if the sample \param pSample of the grid has elevation
+    static bool IsValid(const Grid& pGrid, int pSample);
+    /// Create the mesh of the \param pColumns x \param pRows samples of the grid starting at \param pFirstColumn, \param pFirstRow.
+    /// The samples without elevation get the height \param pLowest.
+    static Geometry* CreateGeometry(const QString& pName, const Grid& pGrid, float pLowest, int pFirstColumn, int pFirstRow, int pColumns, int pRows);
+};
+
+#endif
@@ -0,0 +1,52 @@
+/// \file KdTree.h
+/// \class KdTree
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _KD_TREE_H_
+#define _KD_TREE_H_
+
+//Qt includes
+#include <QPair>
+#include <QVector>
+
+//Dependency includes
+#include "glm/vec3.hpp"
+
+/// Balanced k-d tree over a set of points to find the nearest ones without visiting all of them.
+/// The tree is implicit: the points are reordered so the median of every range splits it, and the small ranges are
+/// leaves that are checked linearly. The queries return the indices of the points in the vector given to the constructor.
+class KdTree
+{
+public:
+    /// Constructor that builds the tree with \param pPoints
+    KdTree(const QVector< glm::vec3 >& pPoints);
+
+    /// Get the number of points
+    int GetNumberOfPoints() const;
+    /// Get the point nearest to \param pPoint, -1 if there are no points
+    int GetNearest(const glm::vec3& pPoint) const;
+    /// Get the \param pK points nearest to \param pPoint ordered from the nearest one
+    QVector<int> GetKNearest(const glm::vec3& pPoint, int pK) const;
+    /// Get the points at a distance lower or equal than \param pRadius from \param pPoint, in no particular order
+    QVector<int> GetInRadius(const glm::vec3& pPoint, float pRadius) const;
+
+private:
+    /// Build the subtree of the points [pBegin, pEnd) of mOrder
+    void Build(int pBegin, int pEnd);
+    /// Search the nearest point in the subtree [pBegin, pEnd) updating \param pNearest and its squared distance \param pDistance
+    void SearchNearest(int pBegin, int pEnd, const glm::vec3& pPoint, int& pNearest, float& pDistance) const;
+    /// Search the \param pK nearest points in the subtree [pBegin, pEnd), \param pNearest is a max-heap by squared distance
+    void SearchKNearest(int pBegin, int pEnd, const glm::vec3& pPoint, int pK, QVector< QPair<float, int> >& pNearest) const;
+    /// Search the points in the subtree [pBegin, pEnd) with a squared distance lower or equal than \param pSquaredRadius
+    void SearchInRadius(int pBegin, int pEnd, const glm::vec3& pPoint, float pSquaredRadius, QVector<int>& pResult) const;
+
+    /// Points
+    QVector< glm::vec3 > mPoints;
+    /// Indices of the points ordered by the tree
+    QVector< int > mOrder;
+    /// Split axis of the median of every inner range, stored at the position of the median
+    QVector< unsigned char > mAxes;
+};
+
+#endif
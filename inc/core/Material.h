@@ -23,9 +23,14 @@ public:
     /// Constructor
     /// \param pName Name of the material
     Material(const QString &pName);
+    /// Copy constructor, the textures are shared
+    Material(const Material& pMaterial);
     /// Destructor
     ~Material();
 
+    /// Get the name of the material
+    QString GetName() const;
+
     /// Get the ambient color
     glm::vec3 GetKa() const;
     /// Set the ambient color
@@ -45,8 +50,14 @@ public:
     Texture* GetKdTexture() const;
     /// Set the diffuse texture
     void SetKdTexture(QImage* pKdTexture);
+    /// Set the diffuse texture \param pKdTexture acquired from the TextureCache, the material keeps its reference
+    void SetKdTexture(Texture* pKdTexture);
     /// Return if the material has a diffuse texture
     bool HasKdTexture() const;
+    /// Get the file of the diffuse texture, empty if it is unknown
+    QString GetKdTextureFileName() const;
+    /// Set the file of the diffuse texture
+    void SetKdTextureFileName(const QString& pFileName);
 
     /// Get the specular color
     glm::vec3 GetKs() const;
@@ -74,6 +85,8 @@ private:
     glm::vec3 mKd;
     /// Diffuse texture
     Texture* mKdTexture;
+    /// File of the diffuse texture
+    QString mKdTextureFileName;
     /// Specular color
     glm::vec3 mKs;
     /// Specular texture
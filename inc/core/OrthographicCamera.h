@@ -30,6 +30,9 @@ public:
     /// Method to clone the camera
     OrthographicCamera* Clone() const;
 
+    /// Add the vertices, the colors and the line indexs of the gizmo of the camera at the end of the vectors
+    void AddGizmo(QVector<glm::vec4>& pVertices, QVector<glm::vec4>& pColors, QVector<unsigned int>& pIndexs) const;
+
     /// Set the top value
     void SetTop(float pTop);
     /// Set the bottom value
@@ -48,12 +51,6 @@ private:
     float mLeft;
     /// Right value
     float mRight;
-
-    /// Create the mesh of the gizmo with the indexs, positions and colors
-    void CreateMesh();
-
-    /// Update the positions of the vertices of the mesh
-    void UpdatePositions();
 };
 
 #endif
@@ -30,6 +30,9 @@ public:
     /// Method to clone the camera
     PerspectiveCamera* Clone() const;
 
+    /// Add the vertices, the colors and the line indexs of the gizmo of the camera at the end of the vectors
+    void AddGizmo(QVector<glm::vec4>& pVertices, QVector<glm::vec4>& pColors, QVector<unsigned int>& pIndexs) const;
+
     /// Set the field of view angle
     void SetAngle(float pAngle);
     /// Get the field of view angle
@@ -38,12 +41,6 @@ public:
 protected:
     /// Field of view angle
     float mAngle;
-
-    /// Create the mesh of the gizmo with the indexs, positions and colors
-    void CreateMesh();
-
-    /// Update the positions of the vertices of the mesh
-    void UpdatePositions();
 };
 
 #endif
@@ -0,0 +1,48 @@
+/// \file PolygonalTexture.h
+/// \class PolygonalTexture
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _POLYGONAL_TEXTURE_H_
+#define _POLYGONAL_TEXTURE_H_
+
+//GLEW has to be included before any OpenGL include
+#include "glew.h"
+
+/// Class to wrap a single channel texture array with one texel per polygon.
+/// The polygon i is at the texel (i % size, (i % size²) / size) of the page i / size², so the shaders address it
+/// with texelFetch from the polygon id and the number of polygons is not limited by the maximum texture size.
+class PolygonalTexture
+{
+public:
+    /// Constructor that allocates the pages for \param pNumberOfPolygons with the internal format \param pInternalFormat
+    PolygonalTexture(int pNumberOfPolygons, GLenum pInternalFormat = GL_R32F);
+    /// Destructor
+    ~PolygonalTexture();
+
+    /// Upload the values of the polygons, \param pValues has one value per polygon
+    void SetValues(const float* pValues);
+    /// Get the texture id in the GPU
+    GLuint GetGLId() const;
+    /// Get the side of the square pages
+    int GetPageSize() const;
+    /// Get the number of pages
+    int GetNumberOfPages() const;
+
+    /// Get the side of the square pages used for \param pNumberOfPolygons
+    static int GetPageSize(int pNumberOfPolygons);
+    /// Get the number of pages used for \param pNumberOfPolygons
+    static int GetNumberOfPages(int pNumberOfPolygons);
+
+private:
+    /// Number of polygons
+    int mNumberOfPolygons;
+    /// Side of the pages
+    int mPageSize;
+    /// Number of pages
+    int mNumberOfPages;
+    /// Id of the texture in the GPU
+    GLuint mGLId;
+};
+
+#endif
@@ -14,6 +14,8 @@
 #include "BoundingSphere.h"
 #include "Geometry.h"
 
+class TerrainTileCache;
+
 /// Class representing a scene made of different meshes
 class Scene
 {
@@ -42,14 +44,26 @@ public:
     int GetNumberOfVertices() const;
     /// Get the number of meshes
     int GetNumberOfMeshes() const;
+    /// Get a hash of the geometry of all the meshes, equal for scenes with the same content
+    QByteArray GetContentHash() const;
     /// Show the information of the scene
     void ShowInformation() const;
     /// Get the polygon offset of the given mesh
     int GetPolygonOffset(Geometry* pMesh) const;
+    /// Get the polygon offset of the mesh at the position \param pIndex
+    int GetPolygonOffsetOfMesh(int pIndex) const;
+    /// Get the positions of the meshes in the order that a pass over all of them has to follow. With a tile cache
+    /// the direction alternates between calls, so a pass starts with the tiles that the previous one left resident
+    /// instead of evicting all of them before they are used again
+    QVector<int> GetMeshTraversalOrder() const;
     /// Get the list of vertices of the given polygon
     QVector< glm::vec3 > GetVerticesOfPolygon( int pPolygon ) const;
     /// Get the area of the polygons serialized
     QVector< float > GetSerializedPolygonAreas() const;
+    /// Set the cache of the tiles of the meshes, the scene takes its ownership
+    void SetTileCache(TerrainTileCache* pTileCache);
+    /// Get the cache of the tiles of the meshes, NULL if all the meshes are always in memory
+    TerrainTileCache* GetTileCache() const;
     /// Normalize the scene to center (0, 0, 0) and radius 1
     void Normalize();
     void Transform(const glm::mat4 &pTransform);
@@ -61,12 +75,18 @@ private:
     QVector<Geometry *> mMeshes;
     /// Bounding sphere
     BoundingSphere* mBoundingSphere;
+    /// Polygon offset of every mesh
+    QVector<int> mPolygonOffsets;
     /// Number of meshes
     int mNumberOfMeshes;
     /// Number of polygons
     int mNumberOfPolygons;
     /// Number of vertices
     int mNumberOfVertices;
+    /// Cache of the tiles of the meshes
+    TerrainTileCache* mTileCache;
+    /// If the next pass over the meshes goes from the last one to the first one
+    mutable bool mReversedTraversal;
 };
 
 #endif
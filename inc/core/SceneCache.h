@@ -0,0 +1,35 @@
+/// \file SceneCache.h
+/// \class SceneCache
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _SCENE_CACHE_H_
+#define _SCENE_CACHE_H_
+
+//Qt includes
+#include <QString>
+#include <QStringList>
+
+//Project includes
+#include "Scene.h"
+
+/// Class to keep the scenes already imported in a binary file, so loading them again does not need Assimp.
+/// The file has the post-processed buffers, the materials, the bounding volumes and the areas of the polygons
+/// of every mesh, it is memory-mapped and copied directly into the meshes. It is only used while the model and the
+/// files it depends on (material libraries and textures) keep the size and the modification time they had when saved.
+class SceneCache
+{
+public:
+    /// Load the cached scene of the model \param pPath, NULL if there is no cache or the model has changed
+    static Scene* Load(const QString& pPath);
+    /// Save the scene \param pScene loaded from the model \param pPath
+    static void Save(const QString& pPath, const Scene* pScene);
+
+private:
+    /// Get the cache file of the model \param pPath
+    static QString GetCacheFileName(const QString& pPath);
+    /// Get the files that the scene \param pScene loaded from the model \param pPath depends on
+    static QStringList GetDependencies(const QString& pPath, const Scene* pScene);
+};
+
+#endif
@@ -23,8 +23,10 @@ public:
     /// Create a scene from the given file
     static Scene * LoadScene(const QString &pPath);
 private:
-    /// Convert a aiMaterial to a Material
-    static Material* LoadMaterial(const aiMaterial* pAiMaterial, const QString& pScenePath);
+    /// Convert a aiMaterial to a Material, the path of the diffuse texture is returned in \param pKdTexturePath to be loaded later
+    static Material* LoadMaterial(const aiMaterial* pAiMaterial, const QString& pScenePath, QString& pKdTexturePath);
+    /// Show why the image \param pPath could not be loaded
+    static void ShowImageError(const QString& pPath);
 
     /// Show the information of the material
     static void ShowMaterialInformation(const aiMaterial* pMaterial);
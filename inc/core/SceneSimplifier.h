@@ -0,0 +1,32 @@
+/// \file SceneSimplifier.h
+/// \class SceneSimplifier
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _SCENE_SIMPLIFIER_H_
+#define _SCENE_SIMPLIFIER_H_
+
+//Qt includes
+#include <QVector>
+
+//Project includes
+#include "Scene.h"
+
+/// Class to create levels of detail of a scene with the quadric error metric of Garland and Heckbert.
+/// The edges with the lowest error are collapsed while the normals of the triangles do not flip, and the border
+/// edges are kept by perpendicular constraint planes. Every polygon of the original scene is mapped to the polygon
+/// of the simplified scene that covers it, so the information computed with the simplified scene can be projected
+/// back onto the original polygons.
+class SceneSimplifier
+{
+public:
+    /// Create a scene with around \param pRatio of the triangles of \param pScene. The polygon of the simplified
+    /// scene that covers every polygon of \param pScene is stored in \param pCoarsePolygons.
+    static Scene* Simplify(const Scene* pScene, float pRatio, QVector<int>& pCoarsePolygons);
+
+private:
+    /// Simplify the triangles of \param pMesh, the face of the simplified mesh of every face is stored in \param pCoarseFaces
+    static Geometry* SimplifyMesh(const Geometry* pMesh, float pRatio, QVector<int>& pCoarseFaces);
+};
+
+#endif
@@ -0,0 +1,81 @@
+/// \file TerrainTileCache.h
+/// \class TerrainTileCache
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _TERRAIN_TILE_CACHE_H_
+#define _TERRAIN_TILE_CACHE_H_
+
+//Qt includes
+#include <QHash>
+#include <QLinkedList>
+#include <QPair>
+#include <QString>
+
+//Project includes
+#include "Geometry.h"
+
+/// Class to keep the tiles of a terrain bigger than the memory on disk and page them in when they are used.
+/// Every tile is a mesh stored in its own file named by its position in the grid of tiles. The tiles that are not
+/// resident only keep the number of vertices and indices, the areas of the polygons and the bounding volumes,
+/// so the polygon offsets of the scene do not change. When the resident tiles use more memory than the budget,
+/// the least recently used ones are paged out from the CPU and the GPU.
+class TerrainTileCache
+{
+public:
+    /// Constructor with the folder \param pDirectory of the tile files and the memory budget in bytes
+    TerrainTileCache(const QString& pDirectory, qint64 pMemoryBudget);
+    /// Destructor, the tile files are removed
+    ~TerrainTileCache();
+
+    /// Add the mesh \param pMesh as the tile at \param pRow, \param pColumn of the grid of tiles.
+    /// It is written to disk and paged out, so it has to be added before it is uploaded to the GPU.
+    void AddTile(Geometry* pMesh, int pRow, int pColumn);
+    /// Page in the tile \param pMesh if it is not resident and mark it as the most recently used one
+    void Request(Geometry* pMesh);
+    /// Get the tile at \param pRow, \param pColumn of the grid of tiles, NULL if there is no tile
+    Geometry* GetTile(int pRow, int pColumn) const;
+
+    /// Get the number of tiles
+    int GetNumberOfTiles() const;
+    /// Get the number of resident tiles
+    int GetNumberOfResidentTiles() const;
+    /// Get the memory used by the resident tiles in bytes
+    qint64 GetResidentMemory() const;
+
+private:
+    /// Information of a tile
+    struct Tile
+    {
+        QString fileName;
+        int row;
+        int column;
+        qint64 memorySize;
+        bool resident;
+        QLinkedList<Geometry*>::iterator position;
+    };
+
+    /// Write the buffers of the tile \param pMesh into \param pFileName
+    bool WriteTile(const QString& pFileName, const Geometry* pMesh) const;
+    /// Read the buffers of the tile \param pMesh from its file
+    bool PageIn(Geometry* pMesh, const QString& pFileName) const;
+    /// Free the buffers of the tile \param pMesh in the CPU and the GPU
+    void PageOut(Geometry* pMesh) const;
+    /// Get the memory used by the buffers of the tile \param pMesh in bytes
+    static qint64 GetMemorySize(const Geometry* pMesh);
+
+    /// Folder of the tile files
+    QString mDirectory;
+    /// Memory budget in bytes
+    qint64 mMemoryBudget;
+    /// Memory used by the resident tiles in bytes
+    qint64 mResidentMemory;
+    /// Information of every tile
+    QHash<Geometry*, Tile> mTiles;
+    /// Tiles by their position in the grid of tiles
+    QHash<QPair<int, int>, Geometry*> mGrid;
+    /// Resident tiles from the most recently used to the least recently used
+    QLinkedList<Geometry*> mResidentTiles;
+};
+
+#endif
@@ -16,18 +16,21 @@
 class Texture
 {
 public:
-    /// Constructor
-    Texture(QImage* pTexture, bool pRectangle = false);
+    /// Constructor, the image \param pTexture is freed once it is in the GPU.
+    /// The 2D textures have mipmaps, that are generated by the GPU.
+    Texture(QImage* pTexture, bool pRectangle = false, GLenum pInternalFormat = GL_RGBA8);
     /// Destructor
     ~Texture();
     /// Get the texture id in the GPU
     GLuint GetGLId() const;
+    /// Get the approximated memory used in the GPU in bytes
+    qint64 GetMemorySize() const;
 
 private:
-    /// Image of the texture
-    QImage* mTexture;
     /// Id of the texture in the GPU
     GLuint mGLId;
+    /// Approximated memory used in the GPU in bytes
+    qint64 mMemorySize;
 };
 
 #endif
@@ -0,0 +1,50 @@
+/// \file TextureCache.h
+/// \class TextureCache
+/// \author Xavier Bonaventura
+/// \author Copyright: (c) Universitat de Girona
+
+#ifndef _TEXTURE_CACHE_H_
+#define _TEXTURE_CACHE_H_
+
+//Qt includes
+#include <QHash>
+#include <QImage>
+#include <QString>
+
+//Project includes
+#include "Texture.h"
+
+/// Class to share the textures loaded from a file between all the materials that use them.
+/// Every texture has a counter of references and it is deleted when the last material releases it.
+/// The textures are compressed with S3TC if it is supported, otherwise they are stored with 8 bits per channel.
+/// It has to be used from the thread of the OpenGL context.
+class TextureCache
+{
+public:
+    /// Get a reference to the texture of the file \param pPath. If it is not in the cache it is created
+    /// from \param pImage, and NULL is returned if there is no image. Without a path the texture is not shared.
+    static Texture* Acquire(const QString& pPath, const QImage* pImage = NULL);
+    /// Add a reference to the texture \param pTexture
+    static void AddReference(Texture* pTexture);
+    /// Remove a reference to the texture \param pTexture, it is deleted if it was the last one
+    static void Release(Texture* pTexture);
+    /// Return if the texture of the file \param pPath is in the cache
+    static bool Contains(const QString& pPath);
+
+    /// Enable the S3TC compression of the new textures, it is enabled by default
+    static void SetCompression(bool pCompression);
+    /// Get the memory used by all the textures in bytes
+    static qint64 GetMemoryUsage();
+
+private:
+    /// Textures that have a file
+    static QHash<QString, Texture*> mTextures;
+    /// References of every texture
+    static QHash<Texture*, int> mReferences;
+    /// Have to be compressed the new textures?
+    static bool mCompression;
+    /// Memory used by all the textures in bytes
+    static qint64 mMemoryUsage;
+};
+
+#endif
@@ -22,6 +22,7 @@ public:
     unsigned int GetTotalSum() const;
     void SetValues(int pViewpoint, const QVector< unsigned int > &pValues);
     unsigned int GetValue(int pViewpoint, int pPolygon) const;
+    QVector< unsigned int > GetValues(int pViewpoint) const;
     void Compute();
 private:
     QVector< QVector< unsigned int > > mValues;
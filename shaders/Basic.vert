@@ -2,13 +2,17 @@
 
 #extension GL_ARB_explicit_attrib_location : enable
 
-#define POSITION 0
+#define POSITION        0
+#define POSITION_OFFSET 6
+#define POSITION_SCALE  7
 
-layout(location = POSITION) in vec3 Position;
+layout(location = POSITION)        in vec3 Position;
+layout(location = POSITION_OFFSET) in vec3 PositionOffset;
+layout(location = POSITION_SCALE)  in vec3 PositionScale;
 
 uniform mat4 modelViewProjection;
 
 void main()
 {
-	gl_Position = modelViewProjection * vec4(Position, 1.0);
+	gl_Position = modelViewProjection * vec4(PositionOffset + Position * PositionScale, 1.0);
 }
@@ -2,15 +2,21 @@
 
 #extension GL_ARB_explicit_attrib_location : enable
 
-#define POSITION  0
-#define NORMAL    1
-#define COLOR     2
-#define TEXTCOORD 3
+#define POSITION        0
+#define NORMAL          1
+#define COLOR           2
+#define TEXTCOORD       3
+#define POSITION_OFFSET 6
+#define POSITION_SCALE  7
+#define OCT_NORMALS     8
 
-layout(location = POSITION)  in vec3  vi_PositionOS;
-layout(location = NORMAL)    in vec3    vi_NormalOS;
-layout(location = COLOR)     in vec4       vi_Color;
-layout(location = TEXTCOORD) in vec2   vi_TextCoord;
+layout(location = POSITION)        in vec3     vi_PositionOS;
+layout(location = NORMAL)          in vec3       vi_NormalOS;
+layout(location = COLOR)           in vec4          vi_Color;
+layout(location = TEXTCOORD)       in vec2      vi_TextCoord;
+layout(location = POSITION_OFFSET) in vec3 vi_PositionOffset;
+layout(location = POSITION_SCALE)  in vec3  vi_PositionScale;
+layout(location = OCT_NORMALS)     in float    vi_OctNormals;
 
 out vec3         vo_NormalWS; // Vector normal en espai de mn
 out vec3       vo_PositionWS; // Posici en espai de mn
@@ -20,12 +26,29 @@ out vec2        vo_TextCoord; // Coordenades de textura
 uniform mat4 modelViewProjection; // World view projection matrix
 uniform mat4               world; // World matrix
 
+// Octahedral decoding of the normals stored in two components
+vec3 DecodeNormal(vec3 normal)
+{
+    if(vi_OctNormals == 0.0)
+    {
+        return normal;
+    }
+    vec3 decoded = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+    if(decoded.z < 0.0)
+    {
+        vec2 signs = vec2(decoded.x >= 0.0 ? 1.0 : -1.0, decoded.y >= 0.0 ? 1.0 : -1.0);
+        decoded.xy = (1.0 - abs(decoded.yx)) * signs;
+    }
+    return normalize(decoded);
+}
+
 void main(void)
 {
-    gl_Position = modelViewProjection *  vec4(vi_PositionOS, 1.0);
+    vec3 position = vi_PositionOffset + vi_PositionOS * vi_PositionScale;
+    gl_Position = modelViewProjection *  vec4(position, 1.0);
 
-    vo_NormalWS = mat3(world) * vi_NormalOS;
-    vo_PositionWS = mat3(world) * vi_PositionOS;
+    vo_NormalWS = mat3(world) * DecodeNormal(vi_NormalOS);
+    vo_PositionWS = mat3(world) * position;
     vo_Color = vi_Color;
     vo_TextCoord = vi_TextCoord;
 }
@@ -1,83 +1,45 @@
 #version 150
 
-uniform sampler2D texture;
-uniform float res;
+uniform sampler2DArray texture;
+uniform int pageSize;
+uniform int layer;
 
-varying vec2 texCoord;
+// Accumulated obscurance and number of samples of the texel at the given offset of the current one
+vec2 Accumulated(int dx, int dy)
+{
+	ivec2 texel = clamp(ivec2(gl_FragCoord.xy) + ivec2(dx, dy), ivec2(0, 0), ivec2(pageSize - 1, pageSize - 1));
+	return texelFetch(texture, ivec3(texel, layer), 0).rg;
+}
 
 void main()
 {
-	vec4 aux1 = texture2D(texture,texCoord);
-	if(aux1.a > 10.0)
+	vec2 aux1 = Accumulated(0, 0);
+	if(aux1.g > 10.0)
 	{
-		gl_FragColor = vec4(aux1.rgb/aux1.a,1.0);
+		gl_FragColor.r = aux1.r/aux1.g;
 	}
 	else
 	{
-//		float res = 256.0;
-		float dif = 1.0/res;
-
 		float counter = 0.0;
-		vec4 aux = vec4(0.0,0.0,0.0,0.0);
+		vec2 aux = vec2(0.0,0.0);
 
-		vec4 aux2 = texture2D(texture,vec2(texCoord.r+dif,texCoord.g));
-		vec4 aux3 = texture2D(texture,vec2(texCoord.r+dif,texCoord.g+dif));
-		vec4 aux4 = texture2D(texture,vec2(texCoord.r,texCoord.g+dif));
-		vec4 aux5 = texture2D(texture,vec2(texCoord.r-dif,texCoord.g+dif));
-		vec4 aux6 = texture2D(texture,vec2(texCoord.r-dif,texCoord.g));
-		vec4 aux7 = texture2D(texture,vec2(texCoord.r-dif,texCoord.g-dif));
-		vec4 aux8 = texture2D(texture,vec2(texCoord.r,texCoord.g-dif));
-		vec4 aux9 = texture2D(texture,vec2(texCoord.r+dif,texCoord.g-dif));
-//		if(aux1.a>0.0)
-//		{
-//			aux += aux1;
-//			counter += 1.0;
-//		}
-		if(aux2.a>10.0)
-		{
-			aux += aux2;
-			counter += 1.0;
-		}
-		if(aux3.a>10.0)
-		{
-			aux += aux3;
-			counter += 1.0;
-		}
-		if(aux4.a>10.0)
-		{
-			aux += aux4;
-			counter += 1.0;
-		}
-		if(aux5.a>10.0)
-		{
-			aux += aux5;
-			counter += 1.0;
-		}
-		if(aux6.a>10.0)
-		{
-			aux += aux6;
-			counter += 1.0;
-		}
-		if(aux7.a>10.0)
-		{
-			aux += aux7;
-			counter += 1.0;
-		}
-		if(aux8.a>10.0)
-		{
-			aux += aux8;
-			counter += 1.0;
-		}
-		if(aux9.a>10.0)
-		{
-			aux += aux9;
-			counter += 1.0;
-		}
-		if(counter < 1.0) gl_FragColor = vec4(0.0,0.0,0.0,0.0);
+		for(int dy = -1; dy <= 1; dy++)
+		{
+			for(int dx = -1; dx <= 1; dx++)
+			{
+				vec2 neighbour = Accumulated(dx, dy);
+				if((dx != 0 || dy != 0) && neighbour.g>10.0)
+				{
+					aux += neighbour;
+					counter += 1.0;
+				}
+			}
+		}
+		if(counter < 1.0) gl_FragColor.r = 0.0;
 		else
 		{
 			aux /= counter;
-			gl_FragColor = vec4(aux.rgb/aux.a,1.0);
-		};
+			gl_FragColor.r = aux.r/aux.g;
+		}
 	}
 }
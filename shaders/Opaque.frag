@@ -0,0 +1,9 @@
+#version 150
+
+vec4 ShadeFragment();
+
+void main(void)
+{
+    // The opaque geometry is drawn once with the depth test, without peeling
+    gl_FragColor = vec4(ShadeFragment().rgb, 1.0);
+}
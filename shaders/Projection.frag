@@ -16,9 +16,9 @@ void main()
 		float depth = texture2D(ztex,gl_FragCoord.xy/res).a;
 		if (gl_FragCoord.z < (depth + 0.000001)) discard;
 	}
+        // Column and row of the polygon in texels, the rows continue through the pages of the lightmap
         gl_FragColor.rg = vec2( ((gl_PrimitiveID + offset) % polygonalTexturesSize), ((gl_PrimitiveID + offset) / polygonalTexturesSize) );
         gl_FragColor.rg += 0.5f;
-        gl_FragColor.rg /= float(polygonalTexturesSize);
 
 	gl_FragColor.b = cosine;
 	gl_FragColor.a = gl_FragCoord.z;
@@ -2,13 +2,19 @@
 
 #extension GL_ARB_explicit_attrib_location : enable
 
-#define POSITION  0
-#define NORMAL    1
-#define TEXTCOORD 3
+#define POSITION        0
+#define NORMAL          1
+#define TEXTCOORD       3
+#define POSITION_OFFSET 6
+#define POSITION_SCALE  7
+#define OCT_NORMALS     8
 
-layout(location = POSITION)  in vec3  vi_PositionOS;
-layout(location = NORMAL)    in vec3    vi_NormalOS;
-layout(location = TEXTCOORD) in vec2   vi_TextCoord;
+layout(location = POSITION)        in vec3     vi_PositionOS;
+layout(location = NORMAL)          in vec3       vi_NormalOS;
+layout(location = TEXTCOORD)       in vec2      vi_TextCoord;
+layout(location = POSITION_OFFSET) in vec3 vi_PositionOffset;
+layout(location = POSITION_SCALE)  in vec3  vi_PositionScale;
+layout(location = OCT_NORMALS)     in float    vi_OctNormals;
 
 out float cosine;
 out vec2 texCoord;
@@ -16,9 +22,25 @@ out vec2 texCoord;
 uniform mat4       modelViewProjection;
 uniform mat4 modelViewInverseTranspose;
 
+// Octahedral decoding of the normals stored in two components
+vec3 DecodeNormal(vec3 normal)
+{
+    if(vi_OctNormals == 0.0)
+    {
+        return normal;
+    }
+    vec3 decoded = vec3(normal.xy, 1.0 - abs(normal.x) - abs(normal.y));
+    if(decoded.z < 0.0)
+    {
+        vec2 signs = vec2(decoded.x >= 0.0 ? 1.0 : -1.0, decoded.y >= 0.0 ? 1.0 : -1.0);
+        decoded.xy = (1.0 - abs(decoded.yx)) * signs;
+    }
+    return normalize(decoded);
+}
+
 void main()
 {
-    gl_Position = modelViewProjection * vec4(vi_PositionOS,1.0);
+    gl_Position = modelViewProjection * vec4(vi_PositionOffset + vi_PositionOS * vi_PositionScale,1.0);
     texCoord = vi_TextCoord;
-    cosine = (modelViewInverseTranspose * vec4(vi_NormalOS,1.0)).z;
+    cosine = (modelViewInverseTranspose * vec4(DecodeNormal(vi_NormalOS),1.0)).z;
 }
@@ -3,8 +3,8 @@
 #extension GL_EXT_gpu_shader4 : enable
 
 uniform sampler2D       diffuseTexture;
-uniform sampler2D     polygonalTexture;
-uniform sampler2D    visibilityTexture;
+uniform sampler2DArray polygonalTexture;
+uniform sampler2DArray visibilityTexture;
 
 uniform bool               faceCulling;
 uniform bool       applyDiffuseTexture;
@@ -30,13 +30,14 @@ vec4 ShadeFragment()
 
     if( gl_FrontFacing )
     {
-        vec2 textCoord = vec2( ((gl_PrimitiveID + offset) % polygonalTexturesSize), ((gl_PrimitiveID + offset) / polygonalTexturesSize) );
-        textCoord += 0.5f;
-        textCoord /= float(polygonalTexturesSize);
+        // Texel of the polygon in the pages of the polygonal textures
+        int polygon = gl_PrimitiveID + offset;
+        int pageTexels = polygonalTexturesSize * polygonalTexturesSize;
+        ivec3 texel = ivec3( polygon % polygonalTexturesSize, (polygon % pageTexels) / polygonalTexturesSize, polygon / pageTexels );
 
         if(onlyPolygonalInformation)
         {
-            vec3 value = texture(polygonalTexture, textCoord).rgb;
+            vec3 value = vec3(texelFetch(polygonalTexture, texel, 0).r);
 
             value = 1.0f - value;
             value = vec3(pow(value.r, power), pow(value.g, power), pow(value.b, power));
@@ -73,7 +74,7 @@ vec4 ShadeFragment()
             vec3 intensityAmbientLight = vec3(1.0f, 1.0f, 1.0f);
             if(applyPolygonalInformation)
             {
-                vec3 value = texture(polygonalTexture, textCoord).rgb;
+                vec3 value = vec3(texelFetch(polygonalTexture, texel, 0).r);
 
                 value = 1.0f - value;
                 value = vec3(pow(value.r, power), pow(value.g, power), pow(value.b, power));
@@ -96,7 +97,7 @@ vec4 ShadeFragment()
 
             if(viewPolygonalVisibility)
             {
-                returnColor = vec4( texture(visibilityTexture, textCoord).x, returnColor.y, returnColor.z, 1.0f );
+                returnColor = vec4( texelFetch(visibilityTexture, texel, 0).r, returnColor.y, returnColor.z, 1.0f );
             }
         }
     }
@@ -2,21 +2,18 @@
 
 uniform float dmax;
 
-in vec2 p1;
-in vec2 p2;
 in float factor;
 
 void main()
 {
-    vec3 color = vec3(1.0f, 1.0f, 1.0f);
-
+    // Obscurance of the sample and number of samples
     if(factor>=dmax)
     {
-        gl_FragColor.rgb = vec3(1.0f, 1.0f, 1.0f);
+        gl_FragColor.r = 1.0f;
     }
     else
     {
-        gl_FragColor.rgb = color * sqrt(factor/dmax);
+        gl_FragColor.r = sqrt(factor/dmax);
     }
-    gl_FragColor.a = 1.0;
+    gl_FragColor.g = 1.0;
 }
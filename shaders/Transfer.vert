@@ -9,10 +9,10 @@ layout(location = POSITION)  in vec4  vi_PositionOS;
 layout(location = TEXTCOORD) in vec4   vi_TextCoord;
 
 uniform float direction;
+uniform int    pageSize;
 
-out vec2 p1;
-out vec2 p2;
-out float factor;
+out float vertexFactor;
+flat out int vertexLayer;
 
 void main()
 {
@@ -21,20 +21,20 @@ void main()
 	if(((direction == 0) && (position.b != 1.0) && (position.b < 0.0) && ((texCoord.b > 0.0) || (texCoord.b == 1)))
 	|| ((direction == 1) && (position.b != 1.0) && (position.b > 0.0) && ((texCoord.b < 0.0) || (texCoord.b == 1))))
 	{
+		// The row of the polygon goes through the pages of the lightmap
+		vec2 p1 = vec2(position.r, position.g);
+		vertexLayer = int(p1.y) / pageSize;
+		p1.y -= float(vertexLayer * pageSize);
 
-		p1 = vec2(position.r, position.g);
+		gl_Position = vec4(((p1 / float(pageSize)) * 2.0) - vec2(1.0,1.0), 0.0,1.0);
 
-		p2 = vec2(texCoord.r, texCoord.g);
-
-		gl_Position = vec4((p1 * 2.0) - vec2(1.0,1.0), 0.0,1.0);
-
-		if (texCoord.b == 1) factor = 1;
-		else factor = abs(texCoord.a - position.a);
+		if (texCoord.b == 1) vertexFactor = 1;
+		else vertexFactor = abs(texCoord.a - position.a);
 	}
 	else
 	{
 		gl_Position = vec4( 0.0,0.0, 2.0, 1.0 );
-		p1 = p2 = vec2(1.0,1.0);
-		factor = 0.5;
+		vertexLayer = 0;
+		vertexFactor = 0.5;
 	}
 }
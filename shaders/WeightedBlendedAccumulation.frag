@@ -0,0 +1,16 @@
+#version 150
+
+vec4 ShadeFragment();
+
+void main(void)
+{
+    vec4 color = ShadeFragment();
+
+    // Weight that gives more importance to the fragments near the camera (McGuire and Bavoil, 2013)
+    float weight = clamp(color.a * max(1e-2, 3e3 * pow(1.0 - gl_FragCoord.z, 3.0)), 1e-2, 3e3);
+
+    // Render target 0: weighted sum of the premultiplied colors in rgb and product of (1 - alpha) in a
+    // Render target 1: sum of the weights
+    gl_FragData[0] = vec4(color.rgb * color.a * weight, color.a);
+    gl_FragData[1] = vec4(color.a * weight);
+}
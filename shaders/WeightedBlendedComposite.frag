@@ -0,0 +1,15 @@
+#version 150
+
+uniform sampler2DRect AccumulationTex;
+uniform sampler2DRect WeightTex;
+
+void main(void)
+{
+    vec4 accumulation = texture(AccumulationTex, gl_FragCoord.xy);
+    float revealage = accumulation.a;
+    if (revealage == 1.0) discard;
+
+    // Average color of the translucent fragments blended with their total coverage over the opaque color
+    float weight = texture(WeightTex, gl_FragCoord.xy).r;
+    gl_FragColor = vec4(accumulation.rgb / max(weight, 1e-5), 1.0 - revealage);
+}
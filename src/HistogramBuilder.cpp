@@ -22,9 +22,9 @@
 #include "GPUGeometry.h"
 #include "MainWindow.h"
 
-VisibilityChannelHistogram* HistogramBuilder::CreateHistogram(Scene* pScene, ViewpointsMesh* pViewpointsMesh, int pWidthResolution, bool pFaceCulling, bool pIgnoreNormals)
+VisibilityChannelHistogram* HistogramBuilder::CreateHistogram(Scene* pScene, ViewpointsMesh* pViewpointsMesh, int pWidthResolution, bool pFaceCulling, bool pIgnoreNormals, const VisibilityChannelHistogram* pPreviousHistogram)
 {
-    int windowHeight;
+    int windowHeight = 0;
     unsigned int j, totalNumberOfPixels;
     GLuint renderBuffer, frameBuffer, depthRenderBuffer;
     QVector< unsigned int > facesAreas;
@@ -37,6 +37,17 @@ VisibilityChannelHistogram* HistogramBuilder::CreateHistogram(Scene* pScene, Vie
     int numberOfViewpoints = pViewpointsMesh->GetNumberOfViewpoints();
 
     VisibilityChannelHistogram* histogram = new VisibilityChannelHistogram(numberOfViewpoints, numberOfPolygons);
+    //The viewpoints of the previous histogram keep their rows
+    int firstViewpoint = 0;
+    if( pPreviousHistogram != NULL )
+    {
+        Q_ASSERT( pPreviousHistogram->GetNumberOfPolygons() == numberOfPolygons );
+        firstViewpoint = glm::min( pPreviousHistogram->GetNumberOfViewpoints(), numberOfViewpoints );
+        for( int i = 0; i < firstViewpoint; i++ )
+        {
+            histogram->SetValues( i, pPreviousHistogram->GetValues(i) );
+        }
+    }
     GLSLShader* basicVS = new GLSLShader("shaders/Basic.vert", GL_VERTEX_SHADER);
     if( basicVS->HasErrors() )
     {
@@ -59,7 +70,7 @@ VisibilityChannelHistogram* HistogramBuilder::CreateHistogram(Scene* pScene, Vie
     QProgressDialog progress(MainWindow::GetInstance());
     progress.setLabelText("Projecting scene to viewpoint sphere...");
     progress.setCancelButton(0);
-    progress.setRange(0, numberOfViewpoints);
+    progress.setRange(firstViewpoint, numberOfViewpoints);
     progress.show();
 
     //Guardem els estats abans del mtode
@@ -98,7 +109,7 @@ VisibilityChannelHistogram* HistogramBuilder::CreateHistogram(Scene* pScene, Vie
     int previousHeight = -1;
     float* storedPixels = NULL;
     //Recorrem els viewpoints de l'esfera
-    for( int i = 0; i < numberOfViewpoints; i++ )
+    for( int i = firstViewpoint; i < numberOfViewpoints; i++ )
     {
         currentViewpoint = pViewpointsMesh->GetViewpoint(i);
         windowHeight = (int)(windowWidth / currentViewpoint->GetAspectRatio());
@@ -149,18 +160,21 @@ VisibilityChannelHistogram* HistogramBuilder::CreateHistogram(Scene* pScene, Vie
         //Calculem la matriu de la cmera
         glm::mat4 viewCamera = currentViewpoint->GetViewMatrix();
         glm::mat4 projectionCamera = currentViewpoint->GetProjectionMatrix();
-        glUniformMatrix4fv( shaderColorPerFace->GetUniformLocation("modelViewProjection"), 1, GL_FALSE, glm::value_ptr(projectionCamera * viewCamera));
+        glm::mat4 viewProjectionCamera = projectionCamera * viewCamera;
+        glUniformMatrix4fv( shaderColorPerFace->GetUniformLocation("modelViewProjection"), 1, GL_FALSE, glm::value_ptr(viewProjectionCamera));
         CHECK_GL_ERROR();
 
-        //Inicialitzem el nombre de poligons processats
-        int processedPolygons = 0;
-
         //Recorrem els meshos
-        for( int k = 0; k < pScene->GetNumberOfMeshes(); k++ )
+        QVector<int> meshOrder = pScene->GetMeshTraversalOrder();
+        for( int k = 0; k < meshOrder.size(); k++ )
         {
-            glUniform1i( shaderColorPerFace->GetUniformLocation("offset"), processedPolygons);
-            pScene->GetMesh(k)->Draw();
-            processedPolygons += pScene->GetMesh(k)->GetNumFaces();
+            //Only the meshes inside the frustum of the viewpoint are drawn, so only their tiles are paged in
+            Geometry* currentMesh = pScene->GetMesh(meshOrder.at(k));
+            if( currentMesh->GetBoundingBox()->Intersects(viewProjectionCamera) )
+            {
+                glUniform1i( shaderColorPerFace->GetUniformLocation("offset"), pScene->GetPolygonOffsetOfMesh(meshOrder.at(k)) );
+                currentMesh->Draw();
+            }
         }
         glFlush();
 
@@ -194,7 +208,7 @@ VisibilityChannelHistogram* HistogramBuilder::CreateHistogram(Scene* pScene, Vie
     glDeleteRenderbuffers( 1, &renderBuffer );
 
     histogram->Compute();
-    Debug::Log( QString("GLCanvas::ComputeViewpointsProbabilities %1x%2 - Time elapsed: %3 ms").arg(windowWidth).arg(windowHeight).arg(t.elapsed()) );
+    Debug::Log( QString("GLCanvas::ComputeViewpointsProbabilities %1x%2, %3 viewpoints rendered - Time elapsed: %4 ms").arg(windowWidth).arg(windowHeight).arg(numberOfViewpoints - firstViewpoint).arg(t.elapsed()) );
 
     //Restaurem els estats abans del mtode
     if(previousDepthTest)
@@ -230,3 +244,59 @@ VisibilityChannelHistogram* HistogramBuilder::CreateHistogram(Scene* pScene, Vie
 
     return histogram;
 }
+
+VisibilityChannelHistogram* HistogramBuilder::ProjectHistogram(const VisibilityChannelHistogram* pCoarseHistogram, const QVector<int>& pCoarsePolygons, const QVector<float>& pAreas)
+{
+    QTime t;
+    t.start();
+
+    int numberOfPolygons = pCoarsePolygons.size();
+    int numberOfCoarsePolygons = pCoarseHistogram->GetNumberOfPolygons();
+    int numberOfViewpoints = pCoarseHistogram->GetNumberOfViewpoints();
+
+    //Part of every simplified polygon that corresponds to each original polygon, equal parts if they have no area
+    QVector<double> coarseAreas(numberOfCoarsePolygons, 0.0);
+    QVector<int> coarseCounts(numberOfCoarsePolygons, 0);
+    for( int i = 0; i < numberOfPolygons; i++ )
+    {
+        coarseAreas[pCoarsePolygons.at(i)] += pAreas.at(i);
+        coarseCounts[pCoarsePolygons.at(i)]++;
+    }
+    QVector<double> weights(numberOfPolygons);
+    for( int i = 0; i < numberOfPolygons; i++ )
+    {
+        int coarsePolygon = pCoarsePolygons.at(i);
+        if( coarseAreas.at(coarsePolygon) > 0.0 )
+        {
+            weights[i] = pAreas.at(i) / coarseAreas.at(coarsePolygon);
+        }
+        else
+        {
+            weights[i] = 1.0 / coarseCounts.at(coarsePolygon);
+        }
+    }
+
+    //The pixels are distributed with the accumulated part rounded, so every simplified polygon keeps its total
+    VisibilityChannelHistogram* histogram = new VisibilityChannelHistogram(numberOfViewpoints, numberOfPolygons);
+    QVector< unsigned int > values(numberOfPolygons);
+    QVector< double > accumulated(numberOfCoarsePolygons);
+    QVector< unsigned int > distributed(numberOfCoarsePolygons);
+    for( int i = 0; i < numberOfViewpoints; i++ )
+    {
+        accumulated.fill(0.0);
+        distributed.fill(0);
+        for( int j = 0; j < numberOfPolygons; j++ )
+        {
+            int coarsePolygon = pCoarsePolygons.at(j);
+            accumulated[coarsePolygon] += pCoarseHistogram->GetValue(i, coarsePolygon) * weights.at(j);
+            unsigned int total = (unsigned int)glm::round( accumulated.at(coarsePolygon) );
+            values[j] = total - distributed.at(coarsePolygon);
+            distributed[coarsePolygon] = total;
+        }
+        histogram->SetValues(i, values);
+    }
+    histogram->Compute();
+    Debug::Log( QString("HistogramBuilder::ProjectHistogram %1 polygons projected onto %2 - Time elapsed: %3 ms").arg(numberOfCoarsePolygons).arg(numberOfPolygons).arg(t.elapsed()) );
+
+    return histogram;
+}
@@ -3,6 +3,7 @@
 
 //Qt includes
 #include <QColorDialog>
+#include <QDir>
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QProgressDialog>
@@ -24,11 +25,16 @@
 #include "HistogramBuilder.h"
 #include "MainWindow.h"
 #include "OrthographicCamera.h"
+#include "PolygonalI2.h"
 #include "ProjectedLocalMeasurePVO.h"
 #include "SceneLoader.h"
+#include "SceneSimplifier.h"
 #include "Tools.h"
 #include "ViewpointMeasureSlider.h"
 
+/// Directions per batch of the progressive computation of the obscurances
+const int OBSCURANCES_BATCH_SIZE = 16;
+
 MainModuleController::MainModuleController(QWidget *pParent) :
     ModuleController(pParent), mUi(new Ui::MainModule)
 {
@@ -70,7 +76,11 @@ MainModuleController::MainModuleController(QWidget *pParent) :
     mFullScreen = false;
 
     mNBestViews = NULL;
+    mNBestViewsWorker = NULL;
     mScene = NULL;
+    mVisibilityLOD = NULL;
+    mVisibilityLODPercentage = 100;
+    mSceneUp = glm::vec3(0.0f, 1.0f, 0.0f);
     mViewpointsMesh = NULL;
     mHistogram = NULL;
 
@@ -152,11 +162,13 @@ MainModuleController::MainModuleController(QWidget *pParent) :
     mUi->bestNViewsByThresholdSlider->setRange( 0, 100 );
     mUi->bestNViewsByThresholdSpinBox->setRange( 0, 100 );
 
-    mPolygonalTexture = 0;
-    mPolygonalVisibilityTexture = 0;
+    mPolygonalTexture = NULL;
+    mPolygonalVisibilityTexture = NULL;
     mObscurancesGenerator = NULL;
+    mObscurancesRayTracer = NULL;
+    mObscurancesHeightfield = NULL;
     mObscurancesTexture = 0;
-    mObscurancesPerPolygonTexture = 0;
+    mObscurancesPerPolygonTexture = NULL;
     mObscurancesComputed = false;
 
     mViewPolygonalVisibility = false;
@@ -175,6 +187,8 @@ MainModuleController::MainModuleController(QWidget *pParent) :
 
 MainModuleController::~MainModuleController()
 {
+    StopNBestViews();
+
     for( int i = 0; i < mPolygonalMeasures.size(); i++ )
     {
         delete mPolygonalMeasures.at(i);
@@ -184,11 +198,14 @@ MainModuleController::~MainModuleController()
         delete mViewpointMeasures.at(i);
     }
     //Destrucci de les textures de saliency i obscurances
-    glDeleteTextures(1, &mPolygonalTexture);
-    glDeleteTextures(1, &mPolygonalVisibilityTexture);
+    delete mPolygonalTexture;
+    delete mPolygonalVisibilityTexture;
     glDeleteTextures(1, &mObscurancesTexture);
-    glDeleteTextures(1, &mObscurancesPerPolygonTexture);
+    delete mObscurancesPerPolygonTexture;
 
+    delete mObscurancesRayTracer;
+    delete mObscurancesHeightfield;
+    delete mVisibilityLOD;
     delete mOpenGLCanvas;
     delete mUi;
 
@@ -219,6 +236,15 @@ void MainModuleController::CreateModuleMenus()
     menuFile->addAction(mActionExport);
     connect(mActionExport, SIGNAL(triggered()), this, SLOT(ExportInformation()));
 
+    QAction* actionConvertViewpoints = new QAction("&Convert viewpoints to binary...", this);
+    menuFile->addAction(actionConvertViewpoints);
+    connect(actionConvertViewpoints, SIGNAL(triggered()), this, SLOT(ConvertViewpointsToBinary()));
+
+    QAction* actionVerboseLog = new QAction("Verbose &log", this);
+    actionVerboseLog->setCheckable(true);
+    menuFile->addAction(actionVerboseLog);
+    connect(actionVerboseLog, SIGNAL(triggered(bool)), this, SLOT(SetVerboseLog(bool)));
+
     QAction* actionQuit = new QAction("&Quit", this);
     actionQuit->setShortcut(Qt::CTRL + Qt::Key_Q);
     menuFile->addAction(actionQuit);
@@ -238,12 +264,23 @@ void MainModuleController::CreateModuleMenus()
     mMenuVisualization->addAction(actionBoundingSpheres);
     connect(actionBoundingSpheres, SIGNAL(triggered(bool)), mOpenGLCanvas, SLOT(WillDrawBoundingSphere(bool)));
 
+    QAction* actionWeightedBlendedTransparency = new QAction("&Weighted Blended Transparency", this);
+    actionWeightedBlendedTransparency->setCheckable(true);
+    mMenuVisualization->addAction(actionWeightedBlendedTransparency);
+    connect(actionWeightedBlendedTransparency, SIGNAL(triggered(bool)), mOpenGLCanvas, SLOT(UseWeightedBlendedTransparency(bool)));
+
     mActionViewpointsSphere = new QAction("&Viewpoints Sphere", this);
     mActionViewpointsSphere->setCheckable(true);
     mActionViewpointsSphere->setShortcut(Qt::CTRL + Qt::Key_V);
     mMenuVisualization->addAction(mActionViewpointsSphere);
     connect(mActionViewpointsSphere, SIGNAL(triggered(bool)), this, SLOT(WillDrawViewpointsSphere(bool)));
 
+    mActionViewpointsFrustums = new QAction("Viewpoints &Frustums", this);
+    mActionViewpointsFrustums->setCheckable(true);
+    mActionViewpointsFrustums->setShortcut(Qt::CTRL + Qt::Key_F);
+    mMenuVisualization->addAction(mActionViewpointsFrustums);
+    connect(mActionViewpointsFrustums, SIGNAL(triggered(bool)), this, SLOT(WillDrawViewpointsFrustums(bool)));
+
     mMenus.push_back(menuFile);
     mMenus.push_back(mMenuVisualization);
 
@@ -287,6 +324,13 @@ void MainModuleController::keyPressEvent(QKeyEvent *pEvent)
     {
         ShowViewpointInformation(mCurrentViewpoint);
     }
+    else if( pEvent->key() == Qt::Key_C && mViewpointsMesh != NULL && mViewpointsMesh->GetNumberOfViewpoints() > 0 && mOpenGLCanvas->GetCamera() != NULL )
+    {
+        //Snap the free camera to the closest viewpoint
+        int viewpoint = mViewpointsMesh->GetNearestViewpoint( mOpenGLCanvas->GetCamera()->GetPosition() );
+        Debug::Log(QString("Viewpoint %1 selected").arg(mViewpointsMesh->GetViewpoint(viewpoint)->mName));
+        SetViewpoint(viewpoint);
+    }
     else if( pEvent->key() == Qt::Key_P )
     {
         QString fileName = mUi->polygonalInformationComboBox->currentText();
@@ -325,22 +369,18 @@ void MainModuleController::mouseMoveEvent(QMouseEvent *pEvent)
             if( movimentX != 0 || movimentY != 0 )
             {
                 QCursor cursor(Qt::BlankCursor);
-                Camera* newCamera = camera->Clone();
                 float rotationAmount = glm::sqrt(movimentX*(float)movimentX + movimentY*movimentY) / 5.0f;
                 glm::vec3 leftVector = glm::normalize( glm::cross(prevCamUpVector, prevCamFrontVector) );
                 glm::mat4 transform = glm::translate(glm::mat4(1.0f), centerScene);
                 glm::vec3 rotationVector = glm::normalize(prevCamUpVector*-(float)movimentX + leftVector*(float)movimentY);
                 transform = glm::rotate(transform, glm::radians(rotationAmount), rotationVector);
                 transform = glm::translate(transform, -centerScene);
-                glm::vec4 aux = transform * glm::vec4(prevCamUpVector, 0.0f);
-                newCamera->SetUp(glm::vec3(aux.x, aux.y, aux.z));
-                aux = transform * glm::vec4(prevCamPosition, 1.0f);
-                newCamera->SetPosition(glm::vec3(aux.x, aux.y, aux.z));
+                glm::vec4 up = transform * glm::vec4(prevCamUpVector, 0.0f);
+                glm::vec4 position = transform * glm::vec4(prevCamPosition, 1.0f);
 
                 cursor.setPos(mOpenGLCanvas->mapToGlobal(QPoint(glWidth / 2, glHeight / 2)));
                 setCursor(cursor);
-                mOpenGLCanvas->SetCamera(newCamera);
-                delete newCamera;
+                mOpenGLCanvas->SetCameraView(glm::vec3(position), prevCamLookAtPoint, glm::vec3(up));
             }
         }
         else
@@ -349,12 +389,10 @@ void MainModuleController::mouseMoveEvent(QMouseEvent *pEvent)
             setCursor(cursor);
             if( pEvent->buttons() & Qt::RightButton )
             {
-                Camera* newCamera = camera->Clone();
                 glm::vec2 initVector(mLastMousePosition.x()-glWidth/2, mLastMousePosition.y()-glHeight/2);
                 glm::vec2 finalVector(pEvent->pos().x()-glWidth/2, pEvent->pos().y()-glHeight/2);
-                newCamera->SetUp( glm::rotate(prevCamUpVector, glm::atan(initVector.y, initVector.x) - glm::atan(finalVector.y, finalVector.x), prevCamFrontVector ) );
-                mOpenGLCanvas->SetCamera(newCamera);
-                delete newCamera;
+                glm::vec3 up = glm::rotate(prevCamUpVector, glm::atan(initVector.y, initVector.x) - glm::atan(finalVector.y, finalVector.x), prevCamFrontVector );
+                mOpenGLCanvas->SetCameraView(prevCamPosition, prevCamLookAtPoint, up);
             }
 
             if( pEvent->buttons() & Qt::LeftButton )
@@ -363,19 +401,15 @@ void MainModuleController::mouseMoveEvent(QMouseEvent *pEvent)
                 int movimentY = pEvent->pos().y() - mLastMousePosition.y();
                 if( movimentX != 0 || movimentY != 0 )
                 {
-                    Camera* newCamera = camera->Clone();
                     float rotationAmount = glm::sqrt((float)movimentX*movimentX + movimentY*movimentY) / 5.0f;
                     glm::vec3 leftVector = glm::normalize( glm::cross(prevCamUpVector, prevCamFrontVector) );
                     glm::mat4 transform = glm::translate(glm::mat4(1.0f), centerScene);
                     glm::vec3 rotationVector = glm::normalize(prevCamUpVector*-(float)movimentX + leftVector*(float)movimentY);
                     transform = glm::rotate(transform, glm::radians(rotationAmount), rotationVector);
                     transform = glm::translate(transform, -centerScene);
-                    glm::vec4 aux = transform * glm::vec4(prevCamUpVector, 0.0f);
-                    newCamera->SetUp(glm::vec3(aux.x, aux.y, aux.z));
-                    aux = transform * glm::vec4(prevCamPosition, 1.0f);
-                    newCamera->SetPosition(glm::vec3(aux.x, aux.y, aux.z));
-                    mOpenGLCanvas->SetCamera(newCamera);
-                    delete newCamera;
+                    glm::vec4 up = transform * glm::vec4(prevCamUpVector, 0.0f);
+                    glm::vec4 position = transform * glm::vec4(prevCamPosition, 1.0f);
+                    mOpenGLCanvas->SetCameraView(glm::vec3(position), prevCamLookAtPoint, glm::vec3(up));
                 }
             }
         }
@@ -389,8 +423,6 @@ void MainModuleController::wheelEvent(QWheelEvent *pEvent)
     Scene* scene = mOpenGLCanvas->GetScene();
     if( camera != NULL && scene != NULL )
     {
-        Camera* newCamera = camera->Clone();
-
         BoundingSphere* boundingSphere = scene->GetBoundingSphere();
         glm::vec3 prevCamPosition = camera->GetPosition();
         glm::vec3 prevCamLookAtPoint = camera->GetLookAt();
@@ -404,17 +436,15 @@ void MainModuleController::wheelEvent(QWheelEvent *pEvent)
         {
             if( numDegrees != 0 )
             {
-                newCamera->SetUp( glm::rotate(prevCamUpVector, glm::radians(numDegrees/4.0f), prevCamFrontVector ) );
-                mOpenGLCanvas->SetCamera(newCamera);
+                glm::vec3 up = glm::rotate(prevCamUpVector, glm::radians(numDegrees/4.0f), prevCamFrontVector );
+                mOpenGLCanvas->SetCameraView(prevCamPosition, prevCamLookAtPoint, up);
             }
         }
         else
         {
             glm::vec3 position = prevCamPosition + prevCamFrontVector * boundingSphere->GetRadius() * deltaFactor;
-            newCamera->SetPosition( position );
-            mOpenGLCanvas->SetCamera(newCamera);
+            mOpenGLCanvas->SetCameraView(position, prevCamLookAtPoint, camera->GetUp());
         }
-        delete newCamera;
     }
 }
 
@@ -424,10 +454,48 @@ void MainModuleController::mousePressEvent(QMouseEvent *pEvent)
     mLastMousePosition = pEvent->pos();
 }
 
+void MainModuleController::mouseDoubleClickEvent(QMouseEvent *pEvent)
+{
+    const Camera* camera = mOpenGLCanvas->GetCamera();
+    if( camera == NULL || mViewpointsMesh == NULL || mViewpointsMesh->GetMesh() == NULL || mViewpointsMesh->GetNumberOfViewpoints() == 0 )
+    {
+        return;
+    }
+
+    //Ray from the near plane to the far plane through the clicked pixel
+    QPoint position = mOpenGLCanvas->mapFrom(this, pEvent->pos());
+    glm::vec4 viewport( 0.0f, 0.0f, mOpenGLCanvas->width(), mOpenGLCanvas->height() );
+    glm::mat4 view = camera->GetViewMatrix();
+    glm::mat4 projection = camera->GetProjectionMatrix();
+    glm::vec3 origin = glm::unProject( glm::vec3(position.x(), viewport[3] - position.y(), 0.0f), view, projection, viewport );
+    glm::vec3 end = glm::unProject( glm::vec3(position.x(), viewport[3] - position.y(), 1.0f), view, projection, viewport );
+    glm::vec3 direction = glm::normalize(end - origin);
+
+    //First hit with the sphere of viewpoints, or the point of the ray nearest to it if there is no hit
+    const BoundingSphere* sphere = mViewpointsMesh->GetMesh()->GetBoundingSphere();
+    glm::vec3 toCenter = sphere->GetCenter() - origin;
+    float alongRay = glm::dot(toCenter, direction);
+    float squaredDistance = glm::dot(toCenter, toCenter) - alongRay * alongRay;
+    float squaredRadius = sphere->GetRadius() * sphere->GetRadius();
+    float t = alongRay;
+    if( squaredDistance <= squaredRadius )
+    {
+        float halfChord = glm::sqrt(squaredRadius - squaredDistance);
+        t = ( alongRay - halfChord >= 0.0f ) ? alongRay - halfChord : alongRay + halfChord;
+    }
+    glm::vec3 point = origin + direction * glm::max(t, 0.0f);
+
+    int viewpoint = mViewpointsMesh->GetNearestViewpoint(point);
+    Debug::Log(QString("Viewpoint %1 selected").arg(mViewpointsMesh->GetViewpoint(viewpoint)->mName));
+    SetViewpoint(viewpoint);
+}
+
 void MainModuleController::LoadScene(const QString &pFileName)
 {
     QTime t;
 
+    StopNBestViews();
+
     QApplication::setOverrideCursor( Qt::WaitCursor );
     t.start();
     Debug::Log(QString("Carregant %1").arg(pFileName));
@@ -436,6 +504,7 @@ void MainModuleController::LoadScene(const QString &pFileName)
     mMenuVisualization->setEnabled(true);
     mActionExport->setEnabled(false);
     mActionViewpointsSphere->setEnabled(false);
+    mActionViewpointsFrustums->setEnabled(false);
     mUi->shadingFrame->setEnabled(false);
     mUi->rightTabWidget->show();
     mUi->leftTabWidget->hide();
@@ -454,17 +523,40 @@ void MainModuleController::LoadScene(const QString &pFileName)
     {
         delete mScene;
     }
+    delete mVisibilityLOD;
+    mVisibilityLOD = NULL;
     mScene = SceneLoader::LoadScene(pFileName);
     mScene->ShowInformation();
     mOpenGLCanvas->LoadScene(mScene);
     Debug::Log( QString("MainWindow::LoadScene - Total time elapsed: %1 ms").arg( t.elapsed() ) );
 
-    mPolygonalTexturesSize = glm::ceil( glm::sqrt( (float)mScene->GetNumberOfPolygons() ) );
+    //The polygonal textures depend on the number of polygons
+    delete mPolygonalTexture;
+    delete mPolygonalVisibilityTexture;
+    delete mObscurancesPerPolygonTexture;
+    mPolygonalTexture = NULL;
+    mPolygonalVisibilityTexture = NULL;
+    mObscurancesPerPolygonTexture = NULL;
+    mOpenGLCanvas->SetPolygonalTexture(0);
+    mOpenGLCanvas->SetPolygonalVisibilityTexture(0);
+    mPolygonalTexturesSize = PolygonalTexture::GetPageSize( mScene->GetNumberOfPolygons() );
     mOpenGLCanvas->SetPolygonalTextureSize(mPolygonalTexturesSize);
     mObscurancesComputed = false;
     mUi->polygonalInformationCheckBox->setChecked(false);
     mUi->polygonalInformationComboBox->clear();
 
+    //Terrains without overhangs use the horizons of the heightfield and the viewpoints above them by default
+    if( ObscuranceHeightfield::IsHeightfield(mScene, mSceneUp) )
+    {
+        Debug::Log( QString("The scene is a heightfield with up direction (%1, %2, %3)").arg(mSceneUp.x).arg(mSceneUp.y).arg(mSceneUp.z) );
+        mUi->obscurancesMethodComboBox->setCurrentIndex(2);
+        mUi->viewpointsMinElevationSpinBox->setValue(0);
+    }
+    else
+    {
+        mUi->viewpointsMinElevationSpinBox->setValue(-90);
+    }
+
     on_polygonalInformationCheckBox_clicked( mUi->polygonalInformationCheckBox->isChecked() );
     mUi->texturedCheckBox->setChecked(true);
     on_texturedCheckBox_clicked( mUi->texturedCheckBox->isChecked() );
@@ -473,36 +565,90 @@ void MainModuleController::LoadScene(const QString &pFileName)
 
 void MainModuleController::ComputeObscurances()
 {
-    int textureSize = mUi->textureSizeSpinBox->value();
-    if(mObscurancesGenerator == NULL)
+    const float *obscurances;
+    if( mUi->obscurancesMethodComboBox->currentIndex() == 1 )
     {
-        mObscurancesGenerator = new ObscuranceMap(mScene, textureSize);
+        if(mObscurancesRayTracer == NULL)
+        {
+            mObscurancesRayTracer = new ObscuranceRayTracer(mScene);
+        }
+        else
+        {
+            mObscurancesRayTracer->SetScene(mScene);
+        }
+
+        // Create obscurances per polygon on the CPU
+        mObscurancesRayTracer->ComputeObscurances(mUi->numberOfIterationsSpinBox->value());
+        obscurances = mObscurancesRayTracer->GetObscurances();
+    }
+    else if( mUi->obscurancesMethodComboBox->currentIndex() == 2 )
+    {
+        if(mObscurancesHeightfield == NULL)
+        {
+            mObscurancesHeightfield = new ObscuranceHeightfield(mScene);
+        }
+        else
+        {
+            mObscurancesHeightfield->SetScene(mScene);
+        }
+
+        // Create obscurances per polygon from the horizons of the terrain
+        mObscurancesHeightfield->ComputeObscurances(mUi->numberOfIterationsSpinBox->value());
+        obscurances = mObscurancesHeightfield->GetObscurances();
     }
     else
     {
-        mObscurancesGenerator->SetScene(mScene);
-        mObscurancesGenerator->SetTextureSize(textureSize);
+        int textureSize = mUi->textureSizeSpinBox->value();
+        if(mObscurancesGenerator == NULL)
+        {
+            mObscurancesGenerator = new ObscuranceMap(mScene, textureSize);
+            mObscurancesGenerator->SetCacheDirectory( QDir( Tools::GetProgramPath() ).filePath("ObscurancesCache") );
+        }
+        else
+        {
+            mObscurancesGenerator->SetScene(mScene);
+            mObscurancesGenerator->SetTextureSize(textureSize);
+        }
+        mObscurancesGenerator->SetPeelBudget( mUi->obscurancesPeelBudgetSpinBox->value() );
+
+        // Create obscurances per polygon
+        if( mUi->obscurancesProgressiveCheckBox->isChecked() )
+        {
+            mObscurancesGenerator->SetListener(this);
+            mObscurancesGenerator->ComputeObscurancesProgressive(mUi->numberOfIterationsSpinBox->value(), OBSCURANCES_BATCH_SIZE, mUi->obscurancesToleranceSpinBox->value());
+            mObscurancesGenerator->SetListener(NULL);
+        }
+        else
+        {
+            mObscurancesGenerator->ComputeObscurances(mUi->numberOfIterationsSpinBox->value());
+        }
+        obscurances = mObscurancesGenerator->GetObscurances();
     }
 
-    // Create obscurances per polygon
-    mObscurancesGenerator->ComputeObscurances(mUi->numberOfIterationsSpinBox->value());
-    const float *obscurances = mObscurancesGenerator->GetImgRgbBuffer();
+    SetObscurances(obscurances);
+}
+
+void MainModuleController::ObscurancesUpdated(const float* pObscurances, int pIterations, float pError)
+{
+    Debug::Log( QString("Obscurances after %1 directions, maximum standard error %2").arg(pIterations).arg(pError) );
+    SetObscurances(pObscurances);
+    mOpenGLCanvas->updateGL();
+}
 
-    glDeleteTextures(1, &mObscurancesPerPolygonTexture);
-    glGenTextures(1, &mObscurancesPerPolygonTexture);
-    glBindTexture( GL_TEXTURE_2D, mObscurancesPerPolygonTexture );
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, mPolygonalTexturesSize, mPolygonalTexturesSize, 0, GL_RGBA, GL_FLOAT, obscurances);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture( GL_TEXTURE_2D, 0 );
+void MainModuleController::SetObscurances(const float* pObscurances)
+{
+    //The texture is kept so the canvas can show it while it is updated
+    if(mObscurancesPerPolygonTexture == NULL)
+    {
+        mObscurancesPerPolygonTexture = new PolygonalTexture( mScene->GetNumberOfPolygons() );
+    }
+    mObscurancesPerPolygonTexture->SetValues(pObscurances);
     CHECK_GL_ERROR();
 
     mObscurancesPerPolygon.resize(mScene->GetNumberOfPolygons());
     for( int i = 0; i < mObscurancesPerPolygon.size(); i++ )
     {
-        mObscurancesPerPolygon[i] = obscurances[i*4];
+        mObscurancesPerPolygon[i] = pObscurances[i];
     }
 
     if(!mObscurancesComputed)
@@ -514,10 +660,12 @@ void MainModuleController::ComputeObscurances()
     UpdateRenderingGUI();
 }
 
-void MainModuleController::LoadViewpoints()
+void MainModuleController::LoadViewpoints(VisibilityChannelHistogram* pVisibilityHistogram)
 {
     QTime t;
 
+    StopNBestViews();
+
     bool recomputePolygonalInformation = true;
     //Creaci del canal d'informaci
     if(mHistogram != NULL)
@@ -529,7 +677,22 @@ void MainModuleController::LoadViewpoints()
             recomputePolygonalInformation = false;
         }
     }
-    mHistogram = HistogramBuilder::CreateHistogram(mScene, mViewpointsMesh, mUi->widthResolutionSpinBox->value(), mUi->faceCullingCheckBox->isChecked());
+    Scene* visibilityScene = GetVisibilityScene();
+    VisibilityChannelHistogram* visibilityHistogram = pVisibilityHistogram;
+    if( visibilityHistogram == NULL )
+    {
+        visibilityHistogram = HistogramBuilder::CreateHistogram(visibilityScene, mViewpointsMesh, mUi->widthResolutionSpinBox->value(), mUi->faceCullingCheckBox->isChecked());
+    }
+    if( visibilityScene != mScene )
+    {
+        //The histogram of the simplified scene is projected back onto the polygons of the scene
+        mHistogram = HistogramBuilder::ProjectHistogram(visibilityHistogram, mVisibilityLODPolygons, mScene->GetSerializedPolygonAreas());
+        delete visibilityHistogram;
+    }
+    else
+    {
+        mHistogram = visibilityHistogram;
+    }
 
     mMaxAreaPolygon.fill( 0, mScene->GetNumberOfPolygons() );
     for ( int currentViewpoint = 0; currentViewpoint < mViewpointsMesh->GetNumberOfViewpoints(); currentViewpoint++ )
@@ -544,9 +707,15 @@ void MainModuleController::LoadViewpoints()
     }
 
     mOpenGLCanvas->SetPerVertexMesh(mViewpointsMesh->GetMesh());
+    //The frustums are only built when they are shown
+    if( mActionViewpointsFrustums->isChecked() )
+    {
+        mOpenGLCanvas->AddPerVertexMesh(mViewpointsMesh->GetCamerasMesh());
+    }
     mOpenGLCanvas->GetShaderProgram()->UseProgram();
     mOpenGLCanvas->GetShaderProgram()->SetUniform("faceCulling", mUi->faceCullingCheckBox->isChecked());
     mActionViewpointsSphere->setEnabled(true);
+    mActionViewpointsFrustums->setEnabled(true);
 
     QApplication::setOverrideCursor( Qt::WaitCursor );
     t.start();
@@ -657,9 +826,100 @@ void MainModuleController::LoadViewpointsFromSphere(float pRadius, float pAngle,
     {
         delete mViewpointsMesh;
     }
-    mViewpointsMesh = new ViewpointsMesh(center, radius * pRadius, pAngle, mUi->cameraAspectRatioSpinBox->value(), pSubdivision );
+    int minElevation = mUi->viewpointsMinElevationSpinBox->value();
+    int maxElevation = mUi->viewpointsMaxElevationSpinBox->value();
+    if( minElevation > maxElevation )
+    {
+        Debug::Warning( QString("The minimum elevation %1 is over the maximum %2, the whole sphere is used").arg(minElevation).arg(maxElevation) );
+        minElevation = -90;
+        maxElevation = 90;
+    }
+    SpherePointCloud sphere;
+    sphere.SetToQuasiUniform(pSubdivision);
+    if( minElevation > -90 || maxElevation < 90 )
+    {
+        sphere.RestrictToElevationBand(mSceneUp, minElevation, maxElevation);
+    }
 
-    LoadViewpoints();
+    VisibilityChannelHistogram* visibilityHistogram = NULL;
+    if( mUi->adaptiveViewpointsCheckBox->isChecked() )
+    {
+        mViewpointsMesh = NULL;
+        visibilityHistogram = RefineViewpointsSphere(sphere, center, radius * pRadius, pAngle);
+    }
+    else
+    {
+        mViewpointsMesh = new ViewpointsMesh(sphere, center, radius * pRadius, pAngle, mUi->cameraAspectRatioSpinBox->value());
+    }
+
+    LoadViewpoints(visibilityHistogram);
+}
+
+VisibilityChannelHistogram* MainModuleController::RefineViewpointsSphere(SpherePointCloud& pSphere, const glm::vec3& pCenter, float pRadius, float pAngle)
+{
+    Scene* visibilityScene = GetVisibilityScene();
+    float threshold = mUi->adaptiveViewpointsThresholdSpinBox->value();
+    int levels = mUi->adaptiveViewpointsLevelsSpinBox->value();
+
+    VisibilityChannelHistogram* histogram = NULL;
+    for( int level = 0; ; level++ )
+    {
+        //The viewpoints keep their indices, so only the new ones are rendered
+        delete mViewpointsMesh;
+        mViewpointsMesh = new ViewpointsMesh(pSphere, pCenter, pRadius, pAngle, mUi->cameraAspectRatioSpinBox->value());
+        VisibilityChannelHistogram* refinedHistogram = HistogramBuilder::CreateHistogram(visibilityScene, mViewpointsMesh, mUi->widthResolutionSpinBox->value(), mUi->faceCullingCheckBox->isChecked(), false, histogram);
+        delete histogram;
+        histogram = refinedHistogram;
+        if( level == levels )
+        {
+            break;
+        }
+
+        //The triangles of the sphere where the measure of the viewpoints changes more than the threshold are subdivided
+        PolygonalI2 polygonalI2("Polygonal I2");
+        ProjectedLocalMeasurePVO projectedI2("Viewpoint polygonal I2 p(v|o)");
+        projectedI2.AddDpendencyLocalMeasure(&polygonalI2);
+        projectedI2.SetScaleDependencyLocalMeasure(0.0f, 1.0f);
+        projectedI2.Compute(histogram);
+        QVector<float> values = projectedI2.GetScaledValues();
+
+        QVector<unsigned int> faces = pSphere.GetFaces();
+        QVector<int> facesToSubdivide;
+        for( int i = 0; i < faces.size(); i += 3 )
+        {
+            float value1 = values.at( faces.at(i) );
+            float value2 = values.at( faces.at(i + 1) );
+            float value3 = values.at( faces.at(i + 2) );
+            float variation = glm::max( value1, glm::max(value2, value3) ) - glm::min( value1, glm::min(value2, value3) );
+            if( variation > threshold )
+            {
+                facesToSubdivide.push_back(i / 3);
+            }
+        }
+        Debug::Log( QString("Adaptive sphere of viewpoints - Level %1: %2 of %3 triangles subdivided").arg(level + 1).arg(facesToSubdivide.size()).arg(faces.size() / 3) );
+        if( facesToSubdivide.isEmpty() )
+        {
+            break;
+        }
+        pSphere.SubdivideFaces(facesToSubdivide);
+    }
+    return histogram;
+}
+
+Scene* MainModuleController::GetVisibilityScene()
+{
+    int visibilityLODPercentage = mUi->visibilityLODSpinBox->value();
+    if( visibilityLODPercentage >= 100 )
+    {
+        return mScene;
+    }
+    if( mVisibilityLOD == NULL || mVisibilityLODPercentage != visibilityLODPercentage )
+    {
+        delete mVisibilityLOD;
+        mVisibilityLOD = SceneSimplifier::Simplify(mScene, visibilityLODPercentage / 100.0f, mVisibilityLODPolygons);
+        mVisibilityLODPercentage = visibilityLODPercentage;
+    }
+    return mVisibilityLOD;
 }
 
 void MainModuleController::ChangeNumberOfViewpoints(int pNumberOfViewpoints)
@@ -817,27 +1077,21 @@ QVector<bool> MainModuleController::GetPolygonalVisibility( int pViewpoint, int
 void MainModuleController::ReloadVisibilityTexture(int pViewpoint, int pVisibilityCriteria)
 {
     QVector<bool> visibility = GetPolygonalVisibility( pViewpoint, pVisibilityCriteria );
-    QVector<float> visibilityFloat( mPolygonalTexturesSize * mPolygonalTexturesSize * 4, 0.0f );
+    QVector<float> visibilityFloat( mScene->GetNumberOfPolygons(), 0.0f );
     for( int i = 0; i < visibility.size(); i++ )
     {
         if( visibility.at(i) )
         {
-            visibilityFloat[ i * 4 + 0] = 1.0f;
-            visibilityFloat[ i * 4 + 1] = 1.0f;
-            visibilityFloat[ i * 4 + 2] = 1.0f;
-            visibilityFloat[ i * 4 + 3] = 1.0f;
+            visibilityFloat[i] = 1.0f;
         }
     }
 
-    glDeleteTextures(1, &mPolygonalVisibilityTexture);
-    glGenTextures(1, &mPolygonalVisibilityTexture);
-    glBindTexture(GL_TEXTURE_2D, mPolygonalVisibilityTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mPolygonalTexturesSize, mPolygonalTexturesSize, 0, GL_RGBA, GL_FLOAT, visibilityFloat.data());
-    mOpenGLCanvas->SetPolygonalVisibilityTexture(mPolygonalVisibilityTexture);
+    if(mPolygonalVisibilityTexture == NULL)
+    {
+        mPolygonalVisibilityTexture = new PolygonalTexture( mScene->GetNumberOfPolygons(), GL_R8 );
+    }
+    mPolygonalVisibilityTexture->SetValues(visibilityFloat.data());
+    mOpenGLCanvas->SetPolygonalVisibilityTexture(mPolygonalVisibilityTexture->GetGLId());
 }
 
 void MainModuleController::UpdateRenderingGUI()
@@ -898,7 +1152,7 @@ QString MainModuleController::GetScreenshotName(int pViewpoint)
 
 void MainModuleController::OpenModel()
 {
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Choose a model"), "./models", tr("Supported models (*.obj *.3ds *.dae *.ply);;Wavefront Object (*.obj);;3ds Max 3DS (*.3ds);;Collada (*.dae);;Stanford Polygon Library (*.ply);;All files (*.*)"));
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Choose a model"), "./models", tr("Supported models (*.obj *.3ds *.dae *.ply *.asc *.hgt *.f32 *.raw);;Wavefront Object (*.obj);;3ds Max 3DS (*.3ds);;Collada (*.dae);;Stanford Polygon Library (*.ply);;Digital elevation model (*.asc *.hgt *.f32 *.raw);;All files (*.*)"));
     if(!fileName.isNull())
     {
         QFileInfo fileInfo(fileName);
@@ -916,6 +1170,25 @@ void MainModuleController::ExportInformation()
     }
 }
 
+void MainModuleController::ConvertViewpointsToBinary()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Choose a file with viewpoints"), "./models", tr("Supported files (*.xml *.txt);;XML file (*.xml);;Text file (*.txt);;All files (*.*)"));
+    if(!fileName.isNull())
+    {
+        QFileInfo fileInfo(fileName);
+        QString binaryFileName = QFileDialog::getSaveFileName(this, tr("Choose a binary file of viewpoints"), fileInfo.absolutePath() + "/" + fileInfo.completeBaseName() + ".vpb", tr("Binary viewpoints (*.vpb);;All files (*.*)"));
+        if(!binaryFileName.isEmpty())
+        {
+            ViewpointsMesh::ConvertToBinary(fileName, binaryFileName);
+        }
+    }
+}
+
+void MainModuleController::SetVerboseLog(bool pVerbose)
+{
+    Debug::SetVerbosity( pVerbose ? Debug::Verbose : Debug::Normal );
+}
+
 void MainModuleController::WillDrawViewpointsSphere(bool pDraw)
 {
     if(mViewpointsMesh != NULL)
@@ -925,6 +1198,22 @@ void MainModuleController::WillDrawViewpointsSphere(bool pDraw)
     }
 }
 
+void MainModuleController::WillDrawViewpointsFrustums(bool pDraw)
+{
+    if(mViewpointsMesh != NULL)
+    {
+        if( mViewpointsMesh->HasCamerasMesh() )
+        {
+            mViewpointsMesh->GetCamerasMesh()->SetVisible(pDraw);
+        }
+        else if( pDraw )
+        {
+            mOpenGLCanvas->AddPerVertexMesh(mViewpointsMesh->GetCamerasMesh());
+        }
+        mOpenGLCanvas->updateGL();
+    }
+}
+
 void MainModuleController::on_measureInViewpointSphereList_currentIndexChanged(int pValue)
 {
     if( mHistogram != NULL )
@@ -952,7 +1241,7 @@ void MainModuleController::on_polygonalInformationComboBox_currentIndexChanged(i
         {//Obscurances
             if(pIndex == 0)
             {
-                mOpenGLCanvas->SetPolygonalTexture(mObscurancesPerPolygonTexture);
+                mOpenGLCanvas->SetPolygonalTexture(mObscurancesPerPolygonTexture->GetGLId());
             }
         }
         else if( mHistogram != NULL )
@@ -978,27 +1267,22 @@ void MainModuleController::on_polygonalInformationComboBox_currentIndexChanged(i
                 }
 
                 //Assignem la informaci per polgon
-                QVector<float> floatColors( mPolygonalTexturesSize * mPolygonalTexturesSize * 4, 0.0f );
+                QVector<float> floatColors( mScene->GetNumberOfPolygons(), 0.0f );
                 for( int i = 0; i < scaledPolygonalSceneValues.size(); i++ )
                 {
-                    floatColors[ i * 4 + 0] = scaledPolygonalSceneValues.at(i);
-                    floatColors[ i * 4 + 1] = scaledPolygonalSceneValues.at(i);
-                    floatColors[ i * 4 + 2] = scaledPolygonalSceneValues.at(i);
-                    floatColors[ i * 4 + 3] = scaledPolygonalSceneValues.at(i);
+                    floatColors[i] = scaledPolygonalSceneValues.at(i);
                 }
 
-                glDeleteTextures(1, &mPolygonalTexture);
-                glGenTextures(1, &mPolygonalTexture);
-                glBindTexture(GL_TEXTURE_2D, mPolygonalTexture);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, mPolygonalTexturesSize, mPolygonalTexturesSize, 0, GL_RGBA, GL_FLOAT, floatColors.data());
+                //The scaled values are in [0, 1] so 8 bits are enough
+                if(mPolygonalTexture == NULL)
+                {
+                    mPolygonalTexture = new PolygonalTexture( mScene->GetNumberOfPolygons(), GL_R8 );
+                }
+                mPolygonalTexture->SetValues(floatColors.data());
 
                 CHECK_GL_ERROR();
 
-                mOpenGLCanvas->SetPolygonalTexture(mPolygonalTexture);
+                mOpenGLCanvas->SetPolygonalTexture(mPolygonalTexture->GetGLId());
             }
         }
     }
@@ -1148,35 +1432,89 @@ void MainModuleController::on_takeScreenshotsFromAllViewpointsButton_clicked()
 
 void MainModuleController::on_nBestViewsComputeButton_clicked()
 {
-    QVector< int > bestViews;
-    QString measure = mUi->nBestViewsSelectionMeasuresComboBox->currentText();
+    if( mNBestViewsWorker != NULL )
+    {//Selection running, the button stops it keeping the views already selected
+        mNBestViewsWorker->Stop();
+        return;
+    }
 
-    Debug::Log( QString("N Best Views with %1").arg( measure ) );
+    QString measure = mUi->nBestViewsSelectionMeasuresComboBox->currentText();
+    int numberOfViews = mUi->bestNViewsSlider->value();
+    float percent = mUi->bestNViewsByThresholdSlider->value() / 100.0f;
+    int discardingCriteria = mUi->nBestViewsCriteriaForDiscardingComboBox->currentIndex();
+    bool stochastic = mUi->nBestViewsStochasticCheckBox->isChecked();
+    float epsilon = mUi->nBestViewsEpsilonSpinBox->value();
 
+    NBestViewsWorker::SelectionMeasure selectionMeasure;
     if( measure.compare( QString("%1 (discarding triangles)").arg( "Projected I1" ) ) == 0 )
     {
-        bestViews = mNBestViews->GetBestNViewsProjectedI1DiscardingPolygons( mUi->bestNViewsSlider->value(), mUi->bestNViewsByThresholdSlider->value() / 100.0f, mUi->nBestViewsCriteriaForDiscardingComboBox->currentIndex() );
+        selectionMeasure = NBestViewsWorker::PROJECTED_I1;
     }
     else if( measure.compare( QString("%1 (discarding triangles)").arg( "Projected I2" ) ) == 0 )
     {
-        bestViews = mNBestViews->GetBestNViewsProjectedI2DiscardingPolygons( mUi->bestNViewsSlider->value(), mUi->bestNViewsByThresholdSlider->value() / 100.0f, mUi->nBestViewsCriteriaForDiscardingComboBox->currentIndex() );
+        selectionMeasure = NBestViewsWorker::PROJECTED_I2;
     }
     else if( measure.compare( QString("%1 (discarding triangles)").arg( "Projected I3" ) ) == 0 )
     {
-        bestViews = mNBestViews->GetBestNViewsProjectedI3DiscardingPolygons( mUi->bestNViewsSlider->value(), mUi->bestNViewsByThresholdSlider->value() / 100.0f, mUi->nBestViewsCriteriaForDiscardingComboBox->currentIndex() );
+        selectionMeasure = NBestViewsWorker::PROJECTED_I3;
     }
     else
     {
         Debug::Error( QString("Mesura %1 not implemented!").arg( measure ) );
+        return;
     }
 
-    for( int i = 0; i < bestViews.size(); i++ )
+    Debug::Log( QString("N Best Views with %1").arg( measure ) );
+
+    //The selection runs in background and every view is shown while the next one is computed
+    mNBestViewsMeasure = measure;
+    mNBestViews->SetRandomSeed( mUi->nBestViewsSeedSpinBox->value() );
+    mNBestViewsWorker = new NBestViewsWorker( mNBestViews, selectionMeasure, numberOfViews, percent, discardingCriteria, stochastic, epsilon, this );
+    connect( mNBestViewsWorker, SIGNAL(viewSelected(int, int, float, float)), this, SLOT(NBestViewSelected(int, int, float, float)) );
+    connect( mNBestViewsWorker, SIGNAL(finished()), this, SLOT(NBestViewsFinished()) );
+    mUi->nBestViewsComputeButton->setText( tr("Stop N best views selection method") );
+    mUi->nBestViewsComputeAllButton->setEnabled(false);
+    mNBestViewsTime.start();
+    mNBestViewsWorker->start();
+}
+
+void MainModuleController::NBestViewSelected(int pPosition, int pViewpoint, float pCoverage, float pLastVQ)
+{
+    if( mNBestViewsWorker == NULL || sender() != mNBestViewsWorker )
+    {//Notification of a selection already stopped
+        return;
+    }
+    SetViewpoint( pViewpoint );
+    QString name = QString("%1_%2_%3.png").arg( mScene->GetName() ).arg( mNBestViewsMeasure ).arg( pPosition + 1 );
+    name.replace(" ", "_");
+    mOpenGLCanvas->SaveScreenshot( name );
+    Debug::Log( QString("%1 - coverage: %2%, last VQ: %3").arg( mViewpointsMesh->GetViewpoint( pViewpoint )->mName ).arg( 100.0f * pCoverage ).arg( pLastVQ ) );
+}
+
+void MainModuleController::NBestViewsFinished()
+{
+    if( mNBestViewsWorker == NULL || sender() != mNBestViewsWorker )
     {
-        SetViewpoint( bestViews[i] );
-        QString name = QString("%1_%2_%3.png").arg( mScene->GetName() ).arg( measure ).arg( i + 1 );
-        name.replace(" ", "_");
-        mOpenGLCanvas->SaveScreenshot( name );
-        Debug::Log( mViewpointsMesh->GetViewpoint( bestViews[i] )->mName );
+        return;
+    }
+    Debug::Log( QString("N Best Views - %1 views, objective: %2, coverage: %3% - Time elapsed: %4 ms").arg( mNBestViewsWorker->GetBestViews().size() ).arg( mNBestViews->GetLastObjective() ).arg( 100.0f * mNBestViews->GetLastCoverage() ).arg( mNBestViewsTime.elapsed() ) );
+
+    mNBestViewsWorker->deleteLater();
+    mNBestViewsWorker = NULL;
+    mUi->nBestViewsComputeButton->setText( tr("Run N best views selection method") );
+    mUi->nBestViewsComputeAllButton->setEnabled(true);
+}
+
+void MainModuleController::StopNBestViews()
+{
+    if( mNBestViewsWorker != NULL )
+    {
+        mNBestViewsWorker->Stop();
+        mNBestViewsWorker->wait();
+        mNBestViewsWorker->deleteLater();
+        mNBestViewsWorker = NULL;
+        mUi->nBestViewsComputeButton->setText( tr("Run N best views selection method") );
+        mUi->nBestViewsComputeAllButton->setEnabled(true);
     }
 }
 
@@ -1275,7 +1613,7 @@ void MainModuleController::on_loadViewpointsSphereButton_clicked()
 void MainModuleController::on_loadFreeViewpointsMeshButton_clicked()
 {
     //Load viewpoints from file
-    QString fileName = QFileDialog::getOpenFileName(this, tr("Choose a file with viewpoints"), "./models", tr("Supported files (*.xml *.txt);;XML file (*.xml);;Text file (*.txt);;All files (*.*)"));
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Choose a file with viewpoints"), "./models", tr("Supported files (*.xml *.txt *.vpb);;XML file (*.xml);;Text file (*.txt);;Binary viewpoints (*.vpb);;All files (*.*)"));
     if(!fileName.isEmpty())
     {
         LoadViewpointsFromFile(fileName);
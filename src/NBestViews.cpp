@@ -1,6 +1,13 @@
 //Definition include
 #include "NBestViews.h"
 
+//System includes
+#include <random>
+
+//Dependency includes
+#include "glm/common.hpp"
+#include "glm/exponential.hpp"
+
 //Project includes
 #include "Debug.h"
 #include "Tools.h"
@@ -8,7 +15,8 @@
 NBestViews::NBestViews(const VisibilityChannelHistogram *pVisibilityChannelHistogram):
     mHistogram(pVisibilityChannelHistogram), mNumberOfViewpoints(pVisibilityChannelHistogram->GetNumberOfViewpoints()),
     mNumberOfPolygons(pVisibilityChannelHistogram->GetNumberOfPolygons()),
-    mProjectedI1(NULL), mPolygonalI1(NULL), mProjectedI2(NULL), mPolygonalI2(NULL), mProjectedI3(NULL), mPolygonalI3(NULL)
+    mProjectedI1(NULL), mPolygonalI1(NULL), mProjectedI2(NULL), mPolygonalI2(NULL), mProjectedI3(NULL), mPolygonalI3(NULL),
+    mListener(NULL), mRandomSeed(0), mLastObjective(0.0f), mLastCoverage(0.0f)
 {
     mSumMaxArea = 0.0f;
     mMaxAreaPolygon.fill( 0, mNumberOfPolygons );
@@ -61,176 +69,144 @@ void NBestViews::SetDependencyPolygonalI3(PolygonalI3 *pPolygonalI3)
     mPolygonalI3 = pPolygonalI3;
 }
 
+void NBestViews::SetListener(NBestViewsListener* pListener)
+{
+    mListener = pListener;
+}
+
+void NBestViews::SetRandomSeed(unsigned int pSeed)
+{
+    mRandomSeed = pSeed;
+}
+
 QVector< int > NBestViews::GetBestNViewsProjectedI1DiscardingPolygons(int pNumberOfViews, float pPercent, int pDiscardingCriteria ) const
 {
-    QVector< bool > selectedViews( mNumberOfViewpoints, false );
-    QVector< bool > selectedPolygons( mNumberOfPolygons, false );
-    QVector< int > bestViews;
+    return GetBestNViewsDiscardingPolygons( mProjectedI1, mPolygonalI1, pNumberOfViews, pPercent, pDiscardingCriteria, mNumberOfViewpoints );
+}
 
-    QVector<float> scaledPolygonalMeasure;
-    if(mProjectedI1->IsLocalMeasureScaled())
-    {
-        scaledPolygonalMeasure = Tools::ScaleValues(mPolygonalI1->GetValues(), mProjectedI1->GetScaleLowerBound(), mProjectedI1->GetScaleUpperBound() );
-    }
-    else
-    {
-        scaledPolygonalMeasure = mPolygonalI1->GetValues();
-    }
+QVector< int > NBestViews::GetBestNViewsProjectedI2DiscardingPolygons(int pNumberOfViews, float pPercent, int pDiscardingCriteria) const
+{
+    return GetBestNViewsDiscardingPolygons( mProjectedI2, mPolygonalI2, pNumberOfViews, pPercent, pDiscardingCriteria, mNumberOfViewpoints );
+}
 
-    int viewpointToAdd = mProjectedI1->GetNth(mNumberOfViewpoints - 1);
-    bool viewpointFound = true;
+QVector< int > NBestViews::GetBestNViewsProjectedI3DiscardingPolygons(int pNumberOfViews, float pPercent, int pDiscardingCriteria ) const
+{
+    return GetBestNViewsDiscardingPolygons( mProjectedI3, mPolygonalI3, pNumberOfViews, pPercent, pDiscardingCriteria, mNumberOfViewpoints );
+}
 
-    int i = 1;
-    float lastVQ = mProjectedI1->GetValue(viewpointToAdd);
-    unsigned int covered = 0;
-    while( i < pNumberOfViews && ( covered / (float)mSumMaxArea ) < pPercent )
-    {
-        bestViews.push_back(viewpointToAdd);
-        selectedViews[viewpointToAdd] = true;
-        for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
-        {
-            int value = mHistogram->GetValue(viewpointToAdd, currentPolygon);
-            if(!selectedPolygons.at(currentPolygon) && value != 0 )
-            {
-                bool discard = (pDiscardingCriteria == 0) || (value > mMaxAreaPolygon.at(currentPolygon) * 0.50f);
-                selectedPolygons[currentPolygon] = discard;
-                if(discard)
-                {
-                    covered += mMaxAreaPolygon.at(currentPolygon);
-                }
-            }
-        }
-        Debug::Log(QString("%1 views selected, %2 covered, last VQ %3").arg(bestViews.size()).arg(100.0f*(covered / (float)mSumMaxArea)).arg(lastVQ));
+QVector< int > NBestViews::GetBestNViewsProjectedI1DiscardingPolygonsStochastic(int pNumberOfViews, float pPercent, int pDiscardingCriteria, float pEpsilon) const
+{
+    return GetBestNViewsDiscardingPolygons( mProjectedI1, mPolygonalI1, pNumberOfViews, pPercent, pDiscardingCriteria, GetSampleSize(pNumberOfViews, pEpsilon) );
+}
 
-        float max = -FLT_MAX;
-        viewpointFound = false;
-        for( int currentViewpoint = 0; currentViewpoint < mNumberOfViewpoints; currentViewpoint++ )
-        {
-            if( !selectedViews.at(currentViewpoint) )
-            {
-                float currentProjectedI1 = 0.0f;
-                bool seePolygons = false;
-                for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
-                {
-                    unsigned int a_z = mHistogram->GetValue(currentViewpoint, currentPolygon);
-
-                    if( a_z != 0 && !selectedPolygons.at(currentPolygon) )
-                    {
-                        seePolygons = true;
-
-                        float aux = a_z / (float)mHistogram->GetSumPerPolygon(currentPolygon);
-
-                        currentProjectedI1 += aux * scaledPolygonalMeasure.at(currentPolygon);
-                    }
-                }
-                if( currentProjectedI1 > max && seePolygons )
-                {
-                    max = currentProjectedI1;
-                    lastVQ = max;
-                    viewpointToAdd = currentViewpoint;
-                    viewpointFound = true;
-                }
-            }
-        }
-        if(!viewpointFound)
-        {
-            break;
-        }
-        i++;
-    }
-    if(viewpointFound)
-    {
-        bestViews.push_back(viewpointToAdd);
-        selectedViews[viewpointToAdd] = true;
-        for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
-        {
-            int value = mHistogram->GetValue(viewpointToAdd, currentPolygon);
-            if(!selectedPolygons.at(currentPolygon) && value != 0 )
-            {
-                bool discard = (pDiscardingCriteria == 0) || (value > mMaxAreaPolygon.at(currentPolygon) * 0.50f);
-                selectedPolygons[currentPolygon] = discard;
-                if(discard)
-                {
-                    covered += mMaxAreaPolygon.at(currentPolygon);
-                }
-            }
-        }
-        Debug::Log(QString("%1 views selected, %2 covered, last VQ %3").arg(bestViews.size()).arg(100.0f*(covered / (float)mSumMaxArea)).arg(lastVQ));
-    }
+QVector< int > NBestViews::GetBestNViewsProjectedI2DiscardingPolygonsStochastic(int pNumberOfViews, float pPercent, int pDiscardingCriteria, float pEpsilon) const
+{
+    return GetBestNViewsDiscardingPolygons( mProjectedI2, mPolygonalI2, pNumberOfViews, pPercent, pDiscardingCriteria, GetSampleSize(pNumberOfViews, pEpsilon) );
+}
 
-    return bestViews;
+QVector< int > NBestViews::GetBestNViewsProjectedI3DiscardingPolygonsStochastic(int pNumberOfViews, float pPercent, int pDiscardingCriteria, float pEpsilon) const
+{
+    return GetBestNViewsDiscardingPolygons( mProjectedI3, mPolygonalI3, pNumberOfViews, pPercent, pDiscardingCriteria, GetSampleSize(pNumberOfViews, pEpsilon) );
 }
 
-QVector< int > NBestViews::GetBestNViewsProjectedI2DiscardingPolygons(int pNumberOfViews, float pPercent, int pDiscardingCriteria) const
+float NBestViews::GetLastObjective() const
+{
+    return mLastObjective;
+}
+
+float NBestViews::GetLastCoverage() const
+{
+    return mLastCoverage;
+}
+
+QVector< int > NBestViews::GetBestNViewsDiscardingPolygons(const ProjectedLocalMeasurePVO* pProjected, const Measure* pPolygonal, int pNumberOfViews, float pPercent, int pDiscardingCriteria, int pSampleSize) const
 {
-    QVector< bool > selectedViews( mNumberOfViewpoints, false );
     QVector< bool > selectedPolygons( mNumberOfPolygons, false );
     QVector< int > bestViews;
 
     QVector<float> scaledPolygonalMeasure;
-    if(mProjectedI2->IsLocalMeasureScaled())
+    if(pProjected->IsLocalMeasureScaled())
     {
-        scaledPolygonalMeasure = Tools::ScaleValues(mPolygonalI2->GetValues(), mProjectedI2->GetScaleLowerBound(), mProjectedI2->GetScaleUpperBound() );
+        scaledPolygonalMeasure = Tools::ScaleValues(pPolygonal->GetValues(), pProjected->GetScaleLowerBound(), pProjected->GetScaleUpperBound() );
     }
     else
     {
-        scaledPolygonalMeasure = mPolygonalI2->GetValues();
+        scaledPolygonalMeasure = pPolygonal->GetValues();
     }
 
-    int viewpointToAdd = mProjectedI2->GetNth(mNumberOfViewpoints - 1);
+    //The generator is seeded once per selection so a given seed always gives the same views
+    std::mt19937 generator;
+    if( pSampleSize < mNumberOfViewpoints )
+    {
+        unsigned int seed = mRandomSeed;
+        if( seed == 0 )
+        {
+            std::random_device randomDevice;
+            seed = randomDevice();
+        }
+        generator.seed(seed);
+        Debug::Log( QString("Stochastic selection with seed %1").arg(seed) );
+    }
+
+    //Viewpoints not selected yet, kept in increasing order while every candidate is evaluated
+    QVector< int > candidates(mNumberOfViewpoints);
+    for( int currentViewpoint = 0; currentViewpoint < mNumberOfViewpoints; currentViewpoint++ )
+    {
+        candidates[currentViewpoint] = currentViewpoint;
+    }
+
+    int viewpointToAdd = pProjected->GetNth(mNumberOfViewpoints - 1);
     bool viewpointFound = true;
 
     int i = 1;
-    float lastVQ = mProjectedI2->GetValue(viewpointToAdd);
+    float lastVQ = pProjected->GetValue(viewpointToAdd);
+    float objective = 0.0f;
     unsigned int covered = 0;
     while( i < pNumberOfViews && ( covered / (float)mSumMaxArea ) < pPercent )
     {
-        bestViews.push_back(viewpointToAdd);
-        selectedViews[viewpointToAdd] = true;
-        for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
+        SelectViewpoint(viewpointToAdd, pDiscardingCriteria, selectedPolygons, bestViews, covered);
+        candidates.remove(candidates.indexOf(viewpointToAdd));
+        objective += lastVQ;
+        Debug::Log(QString("%1 views selected, %2 covered, last VQ %3").arg(bestViews.size()).arg(100.0f*(covered / (float)mSumMaxArea)).arg(lastVQ));
+        if( mListener != NULL && !mListener->ViewSelected(bestViews.size() - 1, viewpointToAdd, covered / (float)mSumMaxArea, lastVQ) )
         {
-            int value = mHistogram->GetValue(viewpointToAdd, currentPolygon);
-            if(!selectedPolygons.at(currentPolygon) && value != 0 )
+            viewpointFound = false;
+            break;
+        }
+
+        //Random subset of the candidates moved to the front (partial Fisher-Yates shuffle)
+        int numberOfCandidates = candidates.size();
+        int sampleSize = numberOfCandidates;
+        if( pSampleSize < numberOfCandidates )
+        {
+            sampleSize = pSampleSize;
+            for( int j = 0; j < sampleSize; j++ )
             {
-                bool discard = (pDiscardingCriteria == 0) || (value > mMaxAreaPolygon.at(currentPolygon) * 0.50f);
-                selectedPolygons[currentPolygon] = discard;
-                if(discard)
-                {
-                    covered += mMaxAreaPolygon.at(currentPolygon);
-                }
+                std::uniform_int_distribution<int> distribution(j, numberOfCandidates - 1);
+                int k = distribution(generator);
+                int aux = candidates.at(j);
+                candidates[j] = candidates.at(k);
+                candidates[k] = aux;
             }
         }
-        Debug::Log(QString("%1 views selected, %2 covered, last VQ %3").arg(bestViews.size()).arg(100.0f*(covered / (float)mSumMaxArea)).arg(lastVQ));
 
         float max = -FLT_MAX;
         viewpointFound = false;
-        for( int currentViewpoint = 0; currentViewpoint < mNumberOfViewpoints; currentViewpoint++ )
+        int currentCandidate = 0;
+        while( currentCandidate < numberOfCandidates && ( currentCandidate < sampleSize || !viewpointFound ) )
         {
-            if( !selectedViews.at(currentViewpoint) )
+            //If no sampled candidate sees an uncovered polygon the rest of candidates are also evaluated
+            int currentViewpoint = candidates.at(currentCandidate);
+            bool seePolygons = false;
+            float currentProjected = GetProjectedValue(currentViewpoint, scaledPolygonalMeasure, selectedPolygons, seePolygons);
+            if( seePolygons && ( currentProjected > max || ( currentProjected == max && currentViewpoint < viewpointToAdd ) ) )
             {
-                float currentProjectedI2 = 0.0f;
-                bool seePolygons = false;
-                for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
-                {
-                    unsigned int a_z = mHistogram->GetValue(currentViewpoint, currentPolygon);
-
-                    if( a_z != 0 && !selectedPolygons.at(currentPolygon) )
-                    {
-                        seePolygons = true;
-
-                        float aux = a_z / (float)mHistogram->GetSumPerPolygon(currentPolygon);
-
-                        currentProjectedI2 += aux * scaledPolygonalMeasure.at(currentPolygon);
-                    }
-                }
-                if( currentProjectedI2 > max && seePolygons )
-                {
-                    max = currentProjectedI2;
-                    lastVQ = max;
-                    viewpointToAdd = currentViewpoint;
-                    viewpointFound = true;
-                }
+                max = currentProjected;
+                lastVQ = max;
+                viewpointToAdd = currentViewpoint;
+                viewpointFound = true;
             }
+            currentCandidate++;
         }
         if(!viewpointFound)
         {
@@ -240,124 +216,61 @@ QVector< int > NBestViews::GetBestNViewsProjectedI2DiscardingPolygons(int pNumbe
     }
     if(viewpointFound)
     {
-        bestViews.push_back(viewpointToAdd);
-        selectedViews[viewpointToAdd] = true;
-        for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
+        SelectViewpoint(viewpointToAdd, pDiscardingCriteria, selectedPolygons, bestViews, covered);
+        objective += lastVQ;
+        Debug::Log(QString("%1 views selected, %2 covered, last VQ %3").arg(bestViews.size()).arg(100.0f*(covered / (float)mSumMaxArea)).arg(lastVQ));
+        if( mListener != NULL )
         {
-            int value = mHistogram->GetValue(viewpointToAdd, currentPolygon);
-            if(!selectedPolygons.at(currentPolygon) && value != 0 )
-            {
-                bool discard = (pDiscardingCriteria == 0) || (value > mMaxAreaPolygon.at(currentPolygon) * 0.50f);
-                selectedPolygons[currentPolygon] = discard;
-                if(discard)
-                {
-                    covered += mMaxAreaPolygon.at(currentPolygon);
-                }
-            }
+            mListener->ViewSelected(bestViews.size() - 1, viewpointToAdd, covered / (float)mSumMaxArea, lastVQ);
         }
-        Debug::Log(QString("%1 views selected, %2 covered, last VQ %3").arg(bestViews.size()).arg(100.0f*(covered / (float)mSumMaxArea)).arg(lastVQ));
     }
 
+    mLastObjective = objective;
+    mLastCoverage = covered / (float)mSumMaxArea;
+
     return bestViews;
 }
 
-QVector< int > NBestViews::GetBestNViewsProjectedI3DiscardingPolygons(int pNumberOfViews, float pPercent, int pDiscardingCriteria ) const
+void NBestViews::SelectViewpoint(int pViewpoint, int pDiscardingCriteria, QVector< bool >& pSelectedPolygons, QVector< int >& pBestViews, unsigned int& pCovered) const
 {
-    QVector< bool > selectedViews( mNumberOfViewpoints, false );
-    QVector< bool > selectedPolygons( mNumberOfPolygons, false );
-    QVector< int > bestViews;
-
-    QVector<float> scaledPolygonalMeasure;
-    if(mProjectedI3->IsLocalMeasureScaled())
-    {
-        scaledPolygonalMeasure = Tools::ScaleValues(mPolygonalI3->GetValues(), mProjectedI3->GetScaleLowerBound(), mProjectedI3->GetScaleUpperBound() );
-    }
-    else
-    {
-        scaledPolygonalMeasure = mPolygonalI3->GetValues();
-    }
-
-    int viewpointToAdd = mProjectedI3->GetNth(mNumberOfViewpoints - 1);
-    bool viewpointFound = true;
-
-    int i = 1;
-    float lastVQ = mProjectedI3->GetValue(viewpointToAdd);
-    unsigned int covered = 0;
-    while( i < pNumberOfViews && ( covered / (float)mSumMaxArea ) < pPercent )
+    pBestViews.push_back(pViewpoint);
+    for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
     {
-        bestViews.push_back(viewpointToAdd);
-        selectedViews[viewpointToAdd] = true;
-        for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
+        int value = mHistogram->GetValue(pViewpoint, currentPolygon);
+        if(!pSelectedPolygons.at(currentPolygon) && value != 0 )
         {
-            int value = mHistogram->GetValue(viewpointToAdd, currentPolygon);
-            if(!selectedPolygons.at(currentPolygon) && value != 0 )
+            bool discard = (pDiscardingCriteria == 0) || (value > mMaxAreaPolygon.at(currentPolygon) * 0.50f);
+            pSelectedPolygons[currentPolygon] = discard;
+            if(discard)
             {
-                bool discard = (pDiscardingCriteria == 0) || (value > mMaxAreaPolygon.at(currentPolygon) * 0.50f);
-                selectedPolygons[currentPolygon] = discard;
-                if(discard)
-                {
-                    covered += mMaxAreaPolygon.at(currentPolygon);
-                }
+                pCovered += mMaxAreaPolygon.at(currentPolygon);
             }
         }
-        Debug::Log(QString("%1 views selected, %2 covered, last VQ %3").arg(bestViews.size()).arg(100.0f*(covered / (float)mSumMaxArea)).arg(lastVQ));
-
-        float max = -FLT_MAX;
-        viewpointFound = false;
-        for( int currentViewpoint = 0; currentViewpoint < mNumberOfViewpoints; currentViewpoint++ )
-        {
-            if( !selectedViews.at(currentViewpoint) )
-            {
-                float currentProjectedI3 = 0.0f;
-                bool seePolygons = false;
-                for( int k = 0; k < mNumberOfPolygons; k++ )
-                {
-                    unsigned int a_z = mHistogram->GetValue(currentViewpoint, k);
-
-                    if( a_z != 0 && !selectedPolygons.at(k) )
-                    {
-                        seePolygons = true;
-
-                        float aux = a_z / (float)mHistogram->GetSumPerPolygon(k);
-
-                        currentProjectedI3 += aux * scaledPolygonalMeasure.at(k);
-                    }
-                }
-                if( currentProjectedI3 > max && seePolygons )
-                {
-                    max = currentProjectedI3;
-                    lastVQ = max;
-                    viewpointToAdd = currentViewpoint;
-                    viewpointFound = true;
-                }
-            }
-        }
-        if(!viewpointFound)
-        {
-            break;
-        }
-        i++;
     }
-    if(viewpointFound)
+}
+
+float NBestViews::GetProjectedValue(int pViewpoint, const QVector< float >& pScaledPolygonalMeasure, const QVector< bool >& pSelectedPolygons, bool& pSeePolygons) const
+{
+    float projectedValue = 0.0f;
+    pSeePolygons = false;
+    for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
     {
-        bestViews.push_back(viewpointToAdd);
-        selectedViews[viewpointToAdd] = true;
-        for( int currentPolygon = 0; currentPolygon < mNumberOfPolygons; currentPolygon++ )
+        unsigned int a_z = mHistogram->GetValue(pViewpoint, currentPolygon);
+
+        if( a_z != 0 && !pSelectedPolygons.at(currentPolygon) )
         {
-            int value = mHistogram->GetValue(viewpointToAdd, currentPolygon);
-            if(!selectedPolygons.at(currentPolygon) && value != 0 )
-            {
-                bool discard = (pDiscardingCriteria == 0) || (value > mMaxAreaPolygon.at(currentPolygon) * 0.50f);
-                selectedPolygons[currentPolygon] = discard;
-                if(discard)
-                {
-                    covered += mMaxAreaPolygon.at(currentPolygon);
-                }
-            }
-        }
-        Debug::Log(QString("%1 views selected, %2 covered, last VQ %3").arg(bestViews.size()).arg(100.0f*(covered / (float)mSumMaxArea)).arg(lastVQ));
+            pSeePolygons = true;
+
+            float aux = a_z / (float)mHistogram->GetSumPerPolygon(currentPolygon);
 
+            projectedValue += aux * pScaledPolygonalMeasure.at(currentPolygon);
+        }
     }
+    return projectedValue;
+}
 
-    return bestViews;
+int NBestViews::GetSampleSize(int pNumberOfViews, float pEpsilon) const
+{
+    float sampleSize = ( mNumberOfViewpoints / (float)pNumberOfViews ) * glm::log( 1.0f / glm::clamp(pEpsilon, FLT_EPSILON, 1.0f) );
+    return glm::clamp( (int)glm::ceil(sampleSize), 1, mNumberOfViewpoints );
 }
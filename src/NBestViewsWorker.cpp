@@ -0,0 +1,64 @@
+//Definition include
+#include "NBestViewsWorker.h"
+
+NBestViewsWorker::NBestViewsWorker(NBestViews* pNBestViews, SelectionMeasure pMeasure, int pNumberOfViews, float pPercent, int pDiscardingCriteria, bool pStochastic, float pEpsilon, QObject* pParent):
+    QThread(pParent), mNBestViews(pNBestViews), mMeasure(pMeasure), mNumberOfViews(pNumberOfViews), mPercent(pPercent),
+    mDiscardingCriteria(pDiscardingCriteria), mStochastic(pStochastic), mEpsilon(pEpsilon), mStopRequested(0)
+{
+
+}
+
+void NBestViewsWorker::Stop()
+{
+    mStopRequested.store(1);
+}
+
+QVector< int > NBestViewsWorker::GetBestViews() const
+{
+    return mBestViews;
+}
+
+bool NBestViewsWorker::ViewSelected(int pPosition, int pViewpoint, float pCoverage, float pLastVQ)
+{
+    emit viewSelected(pPosition, pViewpoint, pCoverage, pLastVQ);
+    return mStopRequested.load() == 0;
+}
+
+void NBestViewsWorker::run()
+{
+    mNBestViews->SetListener(this);
+    switch(mMeasure)
+    {
+        case PROJECTED_I1:
+            if( mStochastic )
+            {
+                mBestViews = mNBestViews->GetBestNViewsProjectedI1DiscardingPolygonsStochastic( mNumberOfViews, mPercent, mDiscardingCriteria, mEpsilon );
+            }
+            else
+            {
+                mBestViews = mNBestViews->GetBestNViewsProjectedI1DiscardingPolygons( mNumberOfViews, mPercent, mDiscardingCriteria );
+            }
+            break;
+        case PROJECTED_I2:
+            if( mStochastic )
+            {
+                mBestViews = mNBestViews->GetBestNViewsProjectedI2DiscardingPolygonsStochastic( mNumberOfViews, mPercent, mDiscardingCriteria, mEpsilon );
+            }
+            else
+            {
+                mBestViews = mNBestViews->GetBestNViewsProjectedI2DiscardingPolygons( mNumberOfViews, mPercent, mDiscardingCriteria );
+            }
+            break;
+        case PROJECTED_I3:
+            if( mStochastic )
+            {
+                mBestViews = mNBestViews->GetBestNViewsProjectedI3DiscardingPolygonsStochastic( mNumberOfViews, mPercent, mDiscardingCriteria, mEpsilon );
+            }
+            else
+            {
+                mBestViews = mNBestViews->GetBestNViewsProjectedI3DiscardingPolygons( mNumberOfViews, mPercent, mDiscardingCriteria );
+            }
+            break;
+    }
+    mNBestViews->SetListener(NULL);
+}
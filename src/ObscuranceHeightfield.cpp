@@ -0,0 +1,411 @@
+//Definition include
+#include "ObscuranceHeightfield.h"
+
+//System includes
+#include <float.h>
+#include <limits.h>
+
+//Qt includes
+#include <QTime>
+
+//Dependency includes
+#include "glm/common.hpp"
+#include "glm/exponential.hpp"
+#include "glm/geometric.hpp"
+#include "glm/trigonometric.hpp"
+
+//Project includes
+#include "Debug.h"
+
+/// Maximum number of cells of the height grid along each axis
+const int MAX_GRID_SIZE = 8192;
+/// Polygons whose normal points downwards more than this are considered overhangs
+const float OVERHANG_TOLERANCE = 1e-3f;
+
+ObscuranceHeightfield::ObscuranceHeightfield(Scene *pScene):
+    mScene(NULL), mAxisX(0), mAxisY(2), mAxisUp(1), mUpSign(1.0f), mGridWidth(0), mGridHeight(0), mCellSize(1.0f),
+    mMaxDistance(0.3f), mSceneRadius(0.0f), mObscurances(NULL)
+{
+    SetScene(pScene);
+}
+
+ObscuranceHeightfield::~ObscuranceHeightfield()
+{
+    delete[] mObscurances;
+}
+
+bool ObscuranceHeightfield::IsHeightfield(const Scene* pScene, glm::vec3& pUp)
+{
+    //The terrains streamed as tiles are regular elevation grids along Y, reading all their tiles to check it would flush the cache
+    if( pScene->GetTileCache() != NULL )
+    {
+        pUp = glm::vec3(0.0f, 1.0f, 0.0f);
+        return true;
+    }
+
+    //For every axis and orientation: polygons facing downwards and projected area facing upwards
+    int overhangs[6] = { 0, 0, 0, 0, 0, 0 };
+    float projectedArea[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    QVector<int> meshOrder = pScene->GetMeshTraversalOrder();
+    for( int i = 0; i < meshOrder.size(); i++ )
+    {
+        Geometry* currentMesh = pScene->GetMesh(meshOrder.at(i));
+        if( currentMesh->GetTopology() != Geometry::Triangles )
+        {
+            continue;
+        }
+        for( int j = 0; j < currentMesh->GetNumFaces(); j++ )
+        {
+            glm::vec3 v0 = currentMesh->GetVertexByIndexPosition(j * 3);
+            glm::vec3 normal = glm::cross( currentMesh->GetVertexByIndexPosition(j * 3 + 1) - v0, currentMesh->GetVertexByIndexPosition(j * 3 + 2) - v0 );
+            float length = glm::length(normal);
+            if( length == 0.0f )
+            {
+                continue;
+            }
+            for( int axis = 0; axis < 3; axis++ )
+            {
+                if( normal[axis] < -OVERHANG_TOLERANCE * length )
+                {
+                    overhangs[axis]++;
+                }
+                if( normal[axis] > OVERHANG_TOLERANCE * length )
+                {
+                    overhangs[axis + 3]++;
+                }
+                projectedArea[axis] += normal[axis];
+                projectedArea[axis + 3] -= normal[axis];
+            }
+        }
+    }
+
+    int bestCandidate = -1;
+    for( int candidate = 0; candidate < 6; candidate++ )
+    {
+        if( overhangs[candidate] == 0 && projectedArea[candidate] > 0.0f && ( bestCandidate == -1 || projectedArea[candidate] > projectedArea[bestCandidate] ) )
+        {
+            bestCandidate = candidate;
+        }
+    }
+
+    pUp = glm::vec3(0.0f, 1.0f, 0.0f);
+    if( bestCandidate != -1 )
+    {
+        pUp = glm::vec3(0.0f);
+        pUp[bestCandidate % 3] = ( bestCandidate < 3 ) ? 1.0f : -1.0f;
+    }
+    return bestCandidate != -1;
+}
+
+void ObscuranceHeightfield::SetScene(Scene* pScene)
+{
+    QTime t;
+    t.start();
+
+    mScene = pScene;
+    mSceneRadius = mScene->GetBoundingSphere()->GetRadius();
+
+    glm::vec3 up;
+    if( !IsHeightfield(mScene, up) )
+    {
+        Debug::Warning( "ObscuranceHeightfield::SetScene - The scene is not a heightfield, only its upper surface along Y is used" );
+    }
+    mAxisUp = ( up.x != 0.0f ) ? 0 : ( ( up.y != 0.0f ) ? 1 : 2 );
+    mUpSign = up[mAxisUp];
+    mAxisX = ( mAxisUp + 1 ) % 3;
+    mAxisY = ( mAxisUp + 2 ) % 3;
+
+    BuildHeightGrid();
+    Debug::Log( QString("ObscuranceHeightfield::SetScene - Height grid of %1x%2 built in %3 ms").arg(mGridWidth).arg(mGridHeight).arg( t.elapsed() ) );
+}
+
+void ObscuranceHeightfield::SetMaxDistance(float pMaxDistance)
+{
+    mMaxDistance = pMaxDistance;
+}
+
+void ObscuranceHeightfield::ComputeObscurances(int pIterations)
+{
+    if(mObscurances != NULL)
+    {
+        delete[] mObscurances;
+    }
+    int bufferSize = mScene->GetNumberOfPolygons();
+    mObscurances = new float[bufferSize];
+    for( int i = 0; i < bufferSize; i++ )
+    {
+        mObscurances[i] = 0.0f;
+    }
+
+    //Same distance than the one used by the Transfer shader of ObscuranceMap: dmax of the depth range of the projections
+    float maxDistance = mMaxDistance * mSceneRadius * glm::sqrt(12.0f);
+    int numberOfAzimuths = glm::max(pIterations, 1);
+    mCellObscurances.fill( 0.0f, mHeights.size() );
+    for( int i = 0; i < numberOfAzimuths; i++ )
+    {
+        SweepAzimuth( 2.0f * 3.14159265358979f * ( i + 0.5f ) / numberOfAzimuths, maxDistance );
+    }
+
+    for( int i = 0; i < mPolygonCells.size(); i++ )
+    {
+        int cell = mPolygonCells.at(i);
+        if( cell != -1 )
+        {
+            float obscurance = mCellObscurances.at(cell) / numberOfAzimuths;
+            mObscurances[i] = obscurance;
+        }
+        else
+        {
+            //The polygons that are not triangles are not in the height grid, nothing obscures them
+            mObscurances[i] = 1.0f;
+        }
+    }
+}
+
+const float* ObscuranceHeightfield::GetObscurances() const
+{
+    return mObscurances;
+}
+
+void ObscuranceHeightfield::BuildHeightGrid()
+{
+    //Extent of the scene over the plane of the grid from the bounding boxes, which the tiles that are not resident keep
+    glm::vec2 minimum(FLT_MAX);
+    glm::vec2 maximum(-FLT_MAX);
+    for( int i = 0; i < mScene->GetNumberOfMeshes(); i++ )
+    {
+        Geometry* currentMesh = mScene->GetMesh(i);
+        if( currentMesh->GetTopology() != Geometry::Triangles || currentMesh->GetNumFaces() == 0 )
+        {
+            continue;
+        }
+        glm::vec3 meshMinimum = currentMesh->GetBoundingBox()->GetMin();
+        glm::vec3 meshMaximum = currentMesh->GetBoundingBox()->GetMax();
+        minimum = glm::min( minimum, glm::vec2(meshMinimum[mAxisX], meshMinimum[mAxisY]) );
+        maximum = glm::max( maximum, glm::vec2(meshMaximum[mAxisX], meshMaximum[mAxisY]) );
+    }
+    glm::vec2 extent = glm::max( maximum - minimum, glm::vec2(0.0f) );
+
+    //Around one cell per two triangles, like the regular grid the terrain usually comes from
+    int numberOfCells = glm::max( mScene->GetNumberOfPolygons() / 2, 1 );
+    mCellSize = glm::sqrt( extent.x * extent.y / numberOfCells );
+    if( mCellSize <= 0.0f )
+    {
+        mCellSize = glm::max( glm::max(extent.x, extent.y) / numberOfCells, FLT_EPSILON );
+    }
+    mGridWidth = glm::min( (int)glm::ceil(extent.x / mCellSize) + 1, MAX_GRID_SIZE );
+    mGridHeight = glm::min( (int)glm::ceil(extent.y / mCellSize) + 1, MAX_GRID_SIZE );
+    mCellSize = glm::max( mCellSize, glm::max( extent.x / glm::max(mGridWidth - 1, 1), extent.y / glm::max(mGridHeight - 1, 1) ) );
+    mGridOrigin = minimum;
+
+    //Rasterization of the polygons at the centers of the cells keeping the highest surface.
+    //It is the only pass that reads the vertices, the tiles are paged in one after the other within the budget of the cache
+    mHeights.fill( -FLT_MAX, mGridWidth * mGridHeight );
+    mPolygonCells.fill( -1, mScene->GetNumberOfPolygons() );
+    QVector<int> meshOrder = mScene->GetMeshTraversalOrder();
+    for( int i = 0; i < meshOrder.size(); i++ )
+    {
+        Geometry* currentMesh = mScene->GetMesh(meshOrder.at(i));
+        currentMesh->MakeResident();
+        if( currentMesh->GetTopology() != Geometry::Triangles )
+        {
+            continue;
+        }
+        int currentPolygon = mScene->GetPolygonOffsetOfMesh(meshOrder.at(i));
+        for( int j = 0; j < currentMesh->GetNumFaces(); j++, currentPolygon++ )
+        {
+            glm::vec3 vertices[3];
+            glm::vec2 points[3];
+            for( int k = 0; k < 3; k++ )
+            {
+                vertices[k] = currentMesh->GetVertexByIndexPosition(j * 3 + k);
+                points[k] = ( glm::vec2(vertices[k][mAxisX], vertices[k][mAxisY]) - mGridOrigin ) / mCellSize;
+            }
+
+            glm::vec2 centroid = ( points[0] + points[1] + points[2] ) / 3.0f;
+            int centroidX = glm::clamp( (int)glm::floor(centroid.x + 0.5f), 0, mGridWidth - 1 );
+            int centroidY = glm::clamp( (int)glm::floor(centroid.y + 0.5f), 0, mGridHeight - 1 );
+            mPolygonCells[currentPolygon] = centroidY * mGridWidth + centroidX;
+
+            glm::vec2 edge1 = points[1] - points[0];
+            glm::vec2 edge2 = points[2] - points[0];
+            float area = edge1.x * edge2.y - edge1.y * edge2.x;
+            if( glm::abs(area) < FLT_EPSILON )
+            {
+                continue;
+            }
+            glm::vec2 polygonMin = glm::min( points[0], glm::min(points[1], points[2]) );
+            glm::vec2 polygonMax = glm::max( points[0], glm::max(points[1], points[2]) );
+            int firstX = glm::max( (int)glm::ceil(polygonMin.x), 0 );
+            int lastX = glm::min( (int)glm::floor(polygonMax.x), mGridWidth - 1 );
+            int firstY = glm::max( (int)glm::ceil(polygonMin.y), 0 );
+            int lastY = glm::min( (int)glm::floor(polygonMax.y), mGridHeight - 1 );
+            for( int y = firstY; y <= lastY; y++ )
+            {
+                for( int x = firstX; x <= lastX; x++ )
+                {
+                    //Barycentric coordinates with a small tolerance to avoid gaps between neighbour polygons
+                    glm::vec2 p = glm::vec2(x, y) - points[0];
+                    float b1 = ( p.x * edge2.y - p.y * edge2.x ) / area;
+                    float b2 = ( edge1.x * p.y - edge1.y * p.x ) / area;
+                    if( b1 >= -1e-4f && b2 >= -1e-4f && b1 + b2 <= 1.0f + 1e-4f )
+                    {
+                        float height = mUpSign * ( vertices[0][mAxisUp] * ( 1.0f - b1 - b2 ) + vertices[1][mAxisUp] * b1 + vertices[2][mAxisUp] * b2 );
+                        float& cellHeight = mHeights[y * mGridWidth + x];
+                        cellHeight = glm::max(cellHeight, height);
+                    }
+                }
+            }
+        }
+    }
+
+    //Thin polygons can have the centroid in a cell whose center they do not cover, they take the nearest cell with height
+    for( int i = 0; i < mPolygonCells.size(); i++ )
+    {
+        int cell = mPolygonCells.at(i);
+        if( cell != -1 && mHeights.at(cell) == -FLT_MAX )
+        {
+            mPolygonCells[i] = FindNearestCellWithHeight(cell % mGridWidth, cell / mGridWidth);
+        }
+    }
+
+    //Slopes with central differences, or one sided at the borders and holes
+    mGradientX.fill( 0.0f, mHeights.size() );
+    mGradientY.fill( 0.0f, mHeights.size() );
+    for( int y = 0; y < mGridHeight; y++ )
+    {
+        for( int x = 0; x < mGridWidth; x++ )
+        {
+            float height = GetHeight(x, y);
+            if( height == -FLT_MAX )
+            {
+                continue;
+            }
+            float left = GetHeight(x - 1, y);
+            float right = GetHeight(x + 1, y);
+            float down = GetHeight(x, y - 1);
+            float up = GetHeight(x, y + 1);
+            int stepsX = ( left != -FLT_MAX ? 1 : 0 ) + ( right != -FLT_MAX ? 1 : 0 );
+            int stepsY = ( down != -FLT_MAX ? 1 : 0 ) + ( up != -FLT_MAX ? 1 : 0 );
+            if( stepsX > 0 )
+            {
+                mGradientX[y * mGridWidth + x] = ( ( right != -FLT_MAX ? right : height ) - ( left != -FLT_MAX ? left : height ) ) / ( stepsX * mCellSize );
+            }
+            if( stepsY > 0 )
+            {
+                mGradientY[y * mGridWidth + x] = ( ( up != -FLT_MAX ? up : height ) - ( down != -FLT_MAX ? down : height ) ) / ( stepsY * mCellSize );
+            }
+        }
+    }
+}
+
+void ObscuranceHeightfield::SweepAzimuth(float pAngle, float pMaxDistance)
+{
+    float directionX = glm::cos(pAngle);
+    float directionY = glm::sin(pAngle);
+
+    //The lines are traversed along the major axis of the direction and every cell belongs to exactly one line
+    bool majorIsX = glm::abs(directionX) >= glm::abs(directionY);
+    int majorSize = majorIsX ? mGridWidth : mGridHeight;
+    int minorSize = majorIsX ? mGridHeight : mGridWidth;
+    float majorDirection = majorIsX ? directionX : directionY;
+    float slope = ( majorIsX ? directionY : directionX ) / majorDirection;
+    float stepLength = mCellSize * glm::sqrt(1.0f + slope * slope);
+    int majorSign = ( majorDirection > 0.0f ) ? 1 : -1;
+
+    int firstOffset = (int)glm::floor( glm::min( 0.0f, -slope * ( majorSize - 1 ) ) ) - 1;
+    int lastOffset = minorSize + (int)glm::ceil( glm::max( 0.0f, -slope * ( majorSize - 1 ) ) ) + 1;
+
+    //Upper convex hull of the (distance, height) of the cells already swept, the nearest on the top
+    QVector< float > hullDistance(majorSize);
+    QVector< float > hullHeight(majorSize);
+    for( int offset = firstOffset; offset <= lastOffset; offset++ )
+    {
+        int hullSize = 0;
+        //Cells swept from the farthest one along the direction so the horizon of every cell is already in the hull
+        for( int step = 0; step < majorSize; step++ )
+        {
+            int major = ( majorSign > 0 ) ? majorSize - 1 - step : step;
+            int minor = (int)glm::floor( offset + slope * major + 0.5f );
+            if( minor < 0 || minor >= minorSize )
+            {
+                continue;
+            }
+            int cell = majorIsX ? minor * mGridWidth + major : major * mGridWidth + minor;
+            float height = mHeights.at(cell);
+            if( height == -FLT_MAX )
+            {
+                continue;
+            }
+            float distance = major * majorSign * stepLength;
+
+            while( hullSize >= 2 && ( hullHeight[hullSize - 1] - height ) / ( hullDistance[hullSize - 1] - distance ) <= ( hullHeight[hullSize - 2] - height ) / ( hullDistance[hullSize - 2] - distance ) )
+            {
+                hullSize--;
+            }
+
+            //Elevation of the tangent plane and of the horizon along the direction
+            float tangentSlope = mGradientX.at(cell) * directionX + mGradientY.at(cell) * directionY;
+            float sinTangent = tangentSlope / glm::sqrt(1.0f + tangentSlope * tangentSlope);
+            float obscurance = 1.0f;
+            if( hullSize > 0 )
+            {
+                float horizontalDistance = hullDistance[hullSize - 1] - distance;
+                float verticalDistance = hullHeight[hullSize - 1] - height;
+                float horizonSlope = verticalDistance / horizontalDistance;
+                float sinHorizon = horizonSlope / glm::sqrt(1.0f + horizonSlope * horizonSlope);
+                float horizonDistance = glm::sqrt( horizontalDistance * horizontalDistance + verticalDistance * verticalDistance );
+                if( sinHorizon > sinTangent && horizonDistance < pMaxDistance )
+                {
+                    //Occluded part of the slice weighted like the Transfer shader of ObscuranceMap
+                    float occluded = ( sinHorizon - sinTangent ) / ( 1.0f - sinTangent );
+                    obscurance = 1.0f - occluded * ( 1.0f - glm::sqrt(horizonDistance / pMaxDistance) );
+                }
+            }
+            mCellObscurances[cell] += obscurance;
+
+            hullDistance[hullSize] = distance;
+            hullHeight[hullSize] = height;
+            hullSize++;
+        }
+    }
+}
+
+int ObscuranceHeightfield::FindNearestCellWithHeight(int pX, int pY) const
+{
+    //Rings of cells around the given one, the nearest cell of the first ring with heights is taken
+    int maxRadius = glm::max(mGridWidth, mGridHeight);
+    for( int radius = 1; radius < maxRadius; radius++ )
+    {
+        int nearestCell = -1;
+        int nearestDistance = INT_MAX;
+        for( int y = pY - radius; y <= pY + radius; y++ )
+        {
+            //Only the border of the ring is visited
+            int step = ( y == pY - radius || y == pY + radius ) ? 1 : 2 * radius;
+            for( int x = pX - radius; x <= pX + radius; x += step )
+            {
+                int distance = ( x - pX ) * ( x - pX ) + ( y - pY ) * ( y - pY );
+                if( GetHeight(x, y) != -FLT_MAX && distance < nearestDistance )
+                {
+                    nearestCell = y * mGridWidth + x;
+                    nearestDistance = distance;
+                }
+            }
+        }
+        if( nearestCell != -1 )
+        {
+            return nearestCell;
+        }
+    }
+    return -1;
+}
+
+float ObscuranceHeightfield::GetHeight(int pX, int pY) const
+{
+    if( pX < 0 || pX >= mGridWidth || pY < 0 || pY >= mGridHeight )
+    {
+        return -FLT_MAX;
+    }
+    return mHeights.at(pY * mGridWidth + pX);
+}
@@ -1,7 +1,12 @@
 //System includes
+#include "float.h"
 #include "time.h"
 
 //Qt includes
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
 #include <QProgressDialog>
 
 //Dependency includes
@@ -15,12 +20,21 @@
 #include "GPUGeometry.h"
 #include "MainWindow.h"
 #include "ObscuranceMap.h"
+#include "PolygonalTexture.h"
+#include "Tools.h"
 
 // To use Offsets in the PBOs.
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
 const unsigned int POSITION  = 0;
 const unsigned int TEXTCOORD = 3;
+// Polygons with less samples are filled from their neighbours by the Normalize shader
+const float MIN_SAMPLES = 10.0f;
+// Peels between the occlusion query of a peel and the read of its result, so the read does not stall.
+const int QUERY_LATENCY = 2;
+// Identification of the files of accumulated lightmaps, the version has to change if the accumulation changes.
+const quint32 CACHE_MAGIC = 0x4F42534C;
+const quint32 CACHE_VERSION = 2;
 
 ObscuranceMap::ObscuranceMap(Scene *pScene, int pTextureSize)
 {
@@ -40,8 +54,10 @@ ObscuranceMap::ObscuranceMap(Scene *pScene, int pTextureSize)
     mFbLightmapNormalization = 0; // Lightmap Normalization
 
     mCount = 0;
-    mBlueBuffer = NULL;
-    mImgRgbBuffer = NULL;
+    mListener = NULL;
+    mAdaptivePeelBudget = 0;
+    mFixedPeelBudget = 0;
+    mObscurances = NULL;
 
     LoadShaders();
 
@@ -52,11 +68,13 @@ ObscuranceMap::ObscuranceMap(Scene *pScene, int pTextureSize)
 void ObscuranceMap::SetScene(Scene* pScene)
 {
     mScene = pScene;
+    mSceneHash = mScene->GetContentHash();
+    mAdaptivePeelBudget = 0;
     mEsferaCenter = mScene->GetBoundingSphere()->GetCenter();
     mEsferaRadius = mScene->GetBoundingSphere()->GetRadius() * (glm::sqrt(12.0f) / 2.0f);
 
-    mResLightmapX = glm::ceil( glm::sqrt( (float)mScene->GetNumberOfPolygons() ) );
-    mResLightmapY = mResLightmapX;
+    mPageSize = PolygonalTexture::GetPageSize( mScene->GetNumberOfPolygons() );
+    mNumberOfPages = PolygonalTexture::GetNumberOfPages( mScene->GetNumberOfPolygons() );
     SaveOpenGLStats();
     InitializeLightmap();
     RestoreOpenGLStats();
@@ -67,11 +85,11 @@ void ObscuranceMap::SetTextureSize(int pTextureSize)
     mResProjectionX = pTextureSize * 2;
     mResProjectionY = pTextureSize * 2;
 
-    mResLightmapX = glm::ceil( glm::sqrt( (float)mScene->GetNumberOfPolygons() ) );
-    mResLightmapY = mResLightmapX;
+    mPageSize = PolygonalTexture::GetPageSize( mScene->GetNumberOfPolygons() );
+    mNumberOfPages = PolygonalTexture::GetNumberOfPages( mScene->GetNumberOfPolygons() );
 
     Debug::Log( QString("Plans de projeccio: ResolucioX = %1 , ResolucioY = %2").arg(mResProjectionX).arg(mResProjectionY) );
-    Debug::Log( QString("Lightmap: ResolucioX = %1 , ResolucioY = %2").arg(mResLightmapX).arg(mResLightmapY) );
+    Debug::Log( QString("Lightmap: Pagines = %1 , Resolucio = %2").arg(mNumberOfPages).arg(mPageSize) );
     SaveOpenGLStats();
     InitializeProjection();
     InitializeLightmap();
@@ -80,27 +98,138 @@ void ObscuranceMap::SetTextureSize(int pTextureSize)
 
 void ObscuranceMap::ComputeObscurances(int pIterations)
 {
-    if(mImgRgbBuffer != NULL)
+    if(mObscurances != NULL)
     {
-        delete[] mImgRgbBuffer;
+        delete[] mObscurances;
     }
-    mImgRgbBuffer = new float[mResLightmapX * mResLightmapY * 4];
+    int numberOfTexels = mPageSize * mPageSize * mNumberOfPages;
+    mObscurances = new float[numberOfTexels];
+    float* accumulated = new float[numberOfTexels * 2];
 
     SaveOpenGLStats();
     // Setup GL States
     glEnable(GL_DEPTH_TEST);	// Enable Depth Testing
     glPointSize(1.0);           // Set point size
     //Generate the reflectivity texture.
+    int resumedIterations = ResumeAccumulation(accumulated, pIterations);
     UpdateTexture(pIterations);
+    if(mCount > resumedIterations)
+    {
+        SaveAccumulation(accumulated);
+    }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, mFbLightmapNormalization);
-    glReadPixels(0, 0, mResLightmapX, mResLightmapY, GL_RGBA, GL_FLOAT, mImgRgbBuffer);
+    ReadLightmap(mTexNormalize, GL_RED, mObscurances);
+    RestoreOpenGLStats();
+    delete[] accumulated;
+}
+
+int ObscuranceMap::ComputeObscurancesProgressive(int pMaxIterations, int pBatchSize, float pTolerance)
+{
+    if(mObscurances != NULL)
+    {
+        delete[] mObscurances;
+    }
+    int numberOfTexels = mPageSize * mPageSize * mNumberOfPages;
+    mObscurances = new float[numberOfTexels];
+    float* accumulated = new float[numberOfTexels * 2];
+
+    SaveOpenGLStats();
+    // Setup GL States
+    glEnable(GL_DEPTH_TEST);	// Enable Depth Testing
+    glPointSize(1.0);           // Set point size
+
+    //The batches start after the cached directions, which are not used for the error estimate
+    int resumedIterations = ResumeAccumulation(accumulated, pMaxIterations);
+    QVector< float > previousSum( numberOfTexels );
+    QVector< float > previousSamples( numberOfTexels );
+    for( int i = 0; i < numberOfTexels; i++ )
+    {
+        previousSum[i] = accumulated[i * 2];
+        previousSamples[i] = accumulated[i * 2 + 1];
+    }
+    QVector< int > batches( numberOfTexels, 0 );
+    QVector< float > mean( numberOfTexels, 0.0f );
+    QVector< float > m2( numberOfTexels, 0.0f );
+
+    glGenQueries(NUMBER_OF_QUERIES, &mQueryIds[0]);
+    QProgressDialog progress(MainWindow::GetInstance());
+    progress.setLabelText("Computing obscurances per polygon progressively");
+    progress.setRange(0, pMaxIterations);
+    progress.show();
+    qApp->processEvents();
+
+    int iterations = resumedIterations;
+    int maxPeels = 0;
+    int truncatedDirections = 0;
+    float error = FLT_MAX;
+    while( iterations < pMaxIterations && error > pTolerance && !progress.wasCanceled() )
+    {
+        int batchSize = glm::min(pBatchSize, pMaxIterations - iterations);
+        for( int i = 0; i < batchSize; i++ )
+        {
+            RenderDirection(maxPeels, truncatedDirections);
+        }
+        iterations += batchSize;
+
+        ReadLightmap(mTexTransfer, GL_RG, accumulated);
+        error = UpdateBatchStatistics(accumulated, previousSum, previousSamples, batches, mean, m2);
+
+        NormalizeLightmap();
+        ReadLightmap(mTexNormalize, GL_RED, mObscurances);
+        Debug::Log( QString("ObscuranceMap::ComputeObscurancesProgressive - %1 directions, maximum standard error %2").arg(iterations).arg(error) );
+
+        if(mListener != NULL)
+        {
+            //The listener can render with the state of the application
+            RestoreOpenGLStats();
+            mListener->ObscurancesUpdated(mObscurances, iterations, error);
+            SaveOpenGLStats();
+            glEnable(GL_DEPTH_TEST);
+            glPointSize(1.0);
+        }
+        progress.setValue(iterations);
+        qApp->processEvents();
+    }
+    glDeleteQueries(NUMBER_OF_QUERIES, &mQueryIds[0]);
+    if(iterations > resumedIterations)
+    {
+        SaveAccumulation(accumulated);
+    }
+    else
+    {
+        //Everything comes from the cache
+        NormalizeLightmap();
+        ReadLightmap(mTexNormalize, GL_RED, mObscurances);
+    }
+    delete[] accumulated;
     RestoreOpenGLStats();
+
+    WarnTruncatedDirections( truncatedDirections, iterations - resumedIterations );
+    if(progress.wasCanceled())
+    {
+        Debug::Warning( QString("Obscurances computation canceled after %1 directions").arg(iterations) );
+    }
+    return iterations;
 }
 
-const float *ObscuranceMap::GetImgRgbBuffer() const
+void ObscuranceMap::SetListener(ObscuranceMapListener* pListener)
 {
-    return mImgRgbBuffer;
+    mListener = pListener;
+}
+
+void ObscuranceMap::SetCacheDirectory(const QString& pDirectory)
+{
+    mCacheDirectory = pDirectory;
+}
+
+void ObscuranceMap::SetPeelBudget(int pPeelBudget)
+{
+    mFixedPeelBudget = pPeelBudget;
+}
+
+const float *ObscuranceMap::GetObscurances() const
+{
+    return mObscurances;
 }
 
 void ObscuranceMap::LoadShaders()
@@ -147,6 +276,11 @@ void ObscuranceMap::LoadShaders()
     {
         Debug::Error( QString("shaders/Transfer.vert: %1").arg(transferVS->GetLog()) );
     }
+    GLSLShader* transferGS = new GLSLShader("shaders/Transfer.geom", GL_GEOMETRY_SHADER);
+    if( transferGS->HasErrors() )
+    {
+        Debug::Error( QString("shaders/Transfer.geom: %1").arg(transferGS->GetLog()) );
+    }
     GLSLShader* transferFS = new GLSLShader("shaders/Transfer.frag", GL_FRAGMENT_SHADER);
     if( transferFS->HasErrors() )
     {
@@ -154,9 +288,11 @@ void ObscuranceMap::LoadShaders()
     }
     mTransferProgram = new GLSLProgram("Energy Transfer");
     mTransferProgram->AttachShader(transferVS);
+    mTransferProgram->AttachShader(transferGS);
     mTransferProgram->AttachShader(transferFS);
     mTransferProgram->LinkProgram();
     delete transferVS;
+    delete transferGS;
     delete transferFS;
 }
 
@@ -168,6 +304,7 @@ void ObscuranceMap::SaveOpenGLStats()
     glGetFloatv(GL_COLOR_CLEAR_VALUE, &mPreviousClearColor[0]);
     glGetIntegerv(GL_VIEWPORT, &mPreviousViewport[0]);
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &mBinded2DTexture);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &mBinded2DArrayTexture);
     glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &mBindedReadFramebuffer);
     glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &mBindedDrawFramebuffer);
     glGetIntegerv(GL_RENDERBUFFER_BINDING, &mBindedRenderbuffer);
@@ -205,6 +342,7 @@ void ObscuranceMap::RestoreOpenGLStats()
     glClearColor(mPreviousClearColor.r, mPreviousClearColor.g, mPreviousClearColor.b, mPreviousClearColor.a);
     glViewport(mPreviousViewport[0], mPreviousViewport[1], mPreviousViewport[2], mPreviousViewport[3]);
     glBindTexture(GL_TEXTURE_2D, mBinded2DTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mBinded2DArrayTexture);
     glBindFramebuffer(GL_READ_FRAMEBUFFER, mBindedReadFramebuffer);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mBindedDrawFramebuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, mBindedRenderbuffer);
@@ -215,22 +353,6 @@ void ObscuranceMap::RestoreOpenGLStats()
 
 void ObscuranceMap::InitializeProjection()
 {
-    if(mBlueBuffer != NULL)
-    {
-        delete mBlueBuffer;
-    }
-    mBlueBuffer = new float[mResProjectionX * mResProjectionY * 4];
-    for( int i = 0; i < mResProjectionX; i++ )
-    {
-        for( int j = 0; j < mResProjectionY; j++ )
-        {
-            mBlueBuffer[4 * (i * mResProjectionY + j) + 0] = 0.0f;
-            mBlueBuffer[4 * (i * mResProjectionY + j) + 1] = 0.0f;
-            mBlueBuffer[4 * (i * mResProjectionY + j) + 2] = 1.0f;
-            mBlueBuffer[4 * (i * mResProjectionY + j) + 3] = 1.0f;
-        }
-    }
-
     glDeleteTextures(1, &mTexName);
     glGenTextures(1, &mTexName);
     glBindTexture(GL_TEXTURE_2D, mTexName);
@@ -261,7 +383,7 @@ void ObscuranceMap::InitializeProjection()
     glDeleteBuffers(2, &mProjectionsPBO[0]);
     glGenBuffers(2, &mProjectionsPBO[0]);
     glBindBuffer(GL_PIXEL_PACK_BUFFER, mProjectionsPBO[0]);
-    glBufferData(GL_PIXEL_PACK_BUFFER, mResProjectionX*mResProjectionY*4*sizeof(float), mBlueBuffer, GL_STREAM_COPY);
+    glBufferData(GL_PIXEL_PACK_BUFFER, mResProjectionX*mResProjectionY*4*sizeof(float), NULL, GL_STREAM_COPY);
     glBindBuffer(GL_PIXEL_PACK_BUFFER, mProjectionsPBO[1]);
     glBufferData(GL_PIXEL_PACK_BUFFER, mResProjectionX*mResProjectionY*4*sizeof(float), NULL, GL_STREAM_COPY);
 }
@@ -270,26 +392,28 @@ void ObscuranceMap::InitializeLightmap()
 {
     glDeleteTextures(1, &mTexTransfer);
     glGenTextures(1,&mTexTransfer);
-    glBindTexture(GL_TEXTURE_2D, mTexTransfer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, mResLightmapX, mResLightmapY, 0, GL_RGBA, GL_FLOAT, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    //Accumulated obscurance and number of samples of every polygon with the paged layout of PolygonalTexture
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexTransfer);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RG32F, mPageSize, mPageSize, mNumberOfPages, 0, GL_RG, GL_FLOAT, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
     glDeleteTextures(1, &mTexNormalize);
     glGenTextures(1,&mTexNormalize);
-    glBindTexture(GL_TEXTURE_2D, mTexNormalize);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, mResLightmapX, mResLightmapY, 0, GL_RGBA, GL_FLOAT, 0);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexNormalize);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32F, mPageSize, mPageSize, mNumberOfPages, 0, GL_RED, GL_FLOAT, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
     glDeleteFramebuffers(1, &mFbTransfer);
     glGenFramebuffers(1, &mFbTransfer);
     glBindFramebuffer(GL_FRAMEBUFFER, mFbTransfer);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTexTransfer, 0);
+    //Layered attachment, the Transfer geometry shader chooses the page of every sample
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mTexTransfer, 0);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0);
 
     glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
@@ -298,29 +422,16 @@ void ObscuranceMap::InitializeLightmap()
     glDeleteFramebuffers(1, &mFbLightmapNormalization);
     glGenFramebuffers(1, &mFbLightmapNormalization);
     glBindFramebuffer(GL_FRAMEBUFFER, mFbLightmapNormalization);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTexNormalize, 0);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mTexNormalize, 0, 0);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0);
 }
 
-float ObscuranceMap::VanDerCorput(int pI, int pBase) const
-{
-    float prec = 1.0f / (float)pBase;
-    float f = 0.0f;
-    while(pI != 0)
-    {
-        f += (float)(prec * (pI % pBase));
-        pI /= pBase;
-        prec /= pBase;
-    }
-    return f;
-}
-
 // Returns a random point in the surface of the sphere
 glm::vec3 ObscuranceMap::RandomPoint(float pR, const glm::vec3& pC)
 {
     mCount++;
-    float ale1 = VanDerCorput(mCount, 2);
-    float ale2 = VanDerCorput(mCount, 3);
+    float ale1 = Tools::VanDerCorput(mCount, 2);
+    float ale2 = Tools::VanDerCorput(mCount, 3);
     //float ale1= (float)rand()/(float)RAND_MAX;
     //float ale2= (float)rand()/(float)RAND_MAX;
 
@@ -341,52 +452,238 @@ glm::vec3 ObscuranceMap::RandomPoint(float pR, const glm::vec3& pC)
 // The number of directions used to calculate the lightmap is iterations * steps
 void ObscuranceMap::UpdateTexture(int pIterations)
 {
-    mCount = 0;
-
-    glGenQueries(1, &mQueryId);
+    glGenQueries(NUMBER_OF_QUERIES, &mQueryIds[0]);
     QProgressDialog progress(MainWindow::GetInstance());
     progress.setLabelText("Computing obscurances per polygon");
     progress.setCancelButton(0);
     progress.setRange(0, pIterations);
     progress.show();
     qApp->processEvents();
-    unsigned int bufferSize = mResProjectionX*mResProjectionY*4*sizeof(float);
-    for(int i = 0; i < pIterations; i++)
+    int maxPeels = 0;
+    int truncatedDirections = 0;
+    //The directions already accumulated are not rendered again, RandomPoint advances mCount
+    int directions = glm::max(pIterations - mCount, 0);
+    for(int i = mCount; i < pIterations; i++)
     {
         progress.setValue(i);
         qApp->processEvents();
-        // Find a random point over the sphere
-        glm::vec3 cameraPosition = RandomPoint(mEsferaRadius, mEsferaCenter);
-        glBindFramebuffer(GL_FRAMEBUFFER, mFbProjeccions);
-        glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
-        glClearDepth(1.0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        RenderDirection(maxPeels, truncatedDirections);
+    }
+    NormalizeLightmap();
+    glDeleteQueries(NUMBER_OF_QUERIES, &mQueryIds[0]);
+    Debug::Log( QString("ObscuranceMap::UpdateTexture - Maximum number of peels: %1").arg(maxPeels) );
+    WarnTruncatedDirections( truncatedDirections, directions );
+}
 
-        glBindBuffer( GL_PIXEL_PACK_BUFFER, mProjectionsPBO[0] );			// Bind The Buffer
-        glBufferData( GL_PIXEL_PACK_BUFFER, bufferSize, mBlueBuffer, GL_STREAM_COPY );
-        glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
-        RenderProjeccions(cameraPosition, 1,1);
-        RenderTransfer(1,1);
-        int l = 0;
-        bool somethingRendered = true;
-        while(somethingRendered)
+void ObscuranceMap::RenderDirection(int& pMaxPeels, int& pTruncatedDirections)
+{
+    // Find a random point over the sphere
+    glm::vec3 cameraPosition = RandomPoint(mEsferaRadius, mEsferaCenter);
+    glBindFramebuffer(GL_FRAMEBUFFER, mFbProjeccions);
+    glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    glClearDepth(1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    RenderProjeccions(cameraPosition, 1, 1, mQueryIds[0]);
+    RenderTransfer(1,1);
+    int l = 0;
+    int peel = 1;
+    // A fixed budget renders exactly that number of peels, the first one included
+    bool somethingRendered = (mFixedPeelBudget == 0 || peel < mFixedPeelBudget);
+    while(somethingRendered)
+    {
+        // Once a peel is empty the next ones are skipped by the GPU without waiting for the CPU
+        glBeginConditionalRender(mQueryIds[(peel - 1) % NUMBER_OF_QUERIES], GL_QUERY_WAIT);
+        RenderProjeccions(cameraPosition, l, 0, mQueryIds[peel % NUMBER_OF_QUERIES]);
+        l = (l == 0)? 1:0;
+        RenderTransfer(l,0);
+        glEndConditionalRender();
+        peel++;
+
+        if(mFixedPeelBudget > 0)
         {
-            int pixelsRendered = RenderProjeccions(cameraPosition, l,0);
-            somethingRendered = (pixelsRendered != 0);
-            l = (l == 0)? 1:0;
-            RenderTransfer(l,0);
+            somethingRendered = (peel < mFixedPeelBudget);
+        }
+        else if(peel >= mAdaptivePeelBudget && peel > QUERY_LATENCY)
+        {
+            // The result of an older peel is already available, so reading it does not stall the pipeline
+            int checkedPeel = peel - 1 - QUERY_LATENCY;
+            GLuint sampleCount;
+            glGetQueryObjectuiv(mQueryIds[checkedPeel % NUMBER_OF_QUERIES], GL_QUERY_RESULT, &sampleCount);
+            somethingRendered = (sampleCount != 0);
+            if(!somethingRendered)
+            {
+                mAdaptivePeelBudget = glm::max(mAdaptivePeelBudget, checkedPeel + 1 + QUERY_LATENCY);
+            }
         }
-        glBindBuffer( GL_PIXEL_PACK_BUFFER, mProjectionsPBO[l] );			// Bind The Buffer
-        glBufferData( GL_PIXEL_PACK_BUFFER, bufferSize, mBlueBuffer, GL_STREAM_COPY );
-        glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
-        l = (l = 0)? 1:0;
-        RenderTransfer(l,1);
     }
-    NormalizeLightmap();
-    glDeleteQueries(1, &mQueryId);
+    pMaxPeels = glm::max(pMaxPeels, peel);
+
+    if(mFixedPeelBudget > 0)
+    {
+        // The peel after the budget is only rendered to be counted, without transfer. If it is not empty the deeper layers are lost
+        glBeginConditionalRender(mQueryIds[(peel - 1) % NUMBER_OF_QUERIES], GL_QUERY_WAIT);
+        RenderProjeccions(cameraPosition, l, 0, mQueryIds[peel % NUMBER_OF_QUERIES]);
+        glEndConditionalRender();
+        GLuint sampleCount;
+        glGetQueryObjectuiv(mQueryIds[peel % NUMBER_OF_QUERIES], GL_QUERY_RESULT, &sampleCount);
+        if(sampleCount != 0)
+        {
+            pTruncatedDirections++;
+        }
+    }
+}
+
+void ObscuranceMap::WarnTruncatedDirections(int pTruncatedDirections, int pDirections) const
+{
+    if(pTruncatedDirections > 0)
+    {
+        Debug::Warning( QString("The peel budget of %1 cut %2 of %3 directions, the deeper layers of the scene are ignored. Increase it or set it to adaptive").arg(mFixedPeelBudget).arg(pTruncatedDirections).arg(pDirections) );
+    }
+}
+
+float ObscuranceMap::UpdateBatchStatistics(const float* pAccumulated, QVector< float >& pPreviousSum, QVector< float >& pPreviousSamples, QVector< int >& pBatches, QVector< float >& pMean, QVector< float >& pM2) const
+{
+    //The mean of every batch is a sample of the obscurance of the polygon, their variance gives the error of the estimate
+    float maxError = -1.0f;
+    for( int i = 0; i < pPreviousSum.size(); i++ )
+    {
+        float sum = pAccumulated[i * 2];
+        float samples = pAccumulated[i * 2 + 1];
+        float batchSamples = samples - pPreviousSamples.at(i);
+        if( batchSamples > 0.0f )
+        {
+            float batchMean = ( sum - pPreviousSum.at(i) ) / batchSamples;
+            pBatches[i]++;
+            float delta = batchMean - pMean.at(i);
+            pMean[i] += delta / pBatches.at(i);
+            pM2[i] += delta * ( batchMean - pMean.at(i) );
+        }
+        pPreviousSum[i] = sum;
+        pPreviousSamples[i] = samples;
+
+        if( pBatches.at(i) >= 2 && samples > MIN_SAMPLES )
+        {
+            float error = glm::sqrt( pM2.at(i) / ( ( pBatches.at(i) - 1 ) * pBatches.at(i) ) );
+            maxError = glm::max(maxError, error);
+        }
+    }
+    return ( maxError < 0.0f ) ? FLT_MAX : maxError;
+}
+
+QString ObscuranceMap::GetCacheFileName() const
+{
+    //Everything that changes the accumulated lightmap is part of the key
+    QCryptographicHash key(QCryptographicHash::Sha1);
+    key.addData(mSceneHash);
+    qint32 settings[6] = { (qint32)CACHE_VERSION, mResProjectionX, mResProjectionY, mPageSize, mNumberOfPages, mFixedPeelBudget };
+    key.addData( (const char*)settings, sizeof(settings) );
+    return QDir(mCacheDirectory).filePath( QString("obscurances-%1.bin").arg( QString( key.result().toHex() ) ) );
 }
 
-// Function that copies the 16-bit fp RGBA buffer of the lightmap to a 32-bit RGBA fb buffer.
+int ObscuranceMap::ResumeAccumulation(float* pAccumulated, int pMaxIterations)
+{
+    int numberOfFloats = mPageSize * mPageSize * mNumberOfPages * 2;
+    mCount = 0;
+    for( int i = 0; i < numberOfFloats; i++ )
+    {
+        pAccumulated[i] = 0.0f;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, mFbTransfer);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if(mCacheDirectory.isEmpty())
+    {
+        return 0;
+    }
+    QFile file( GetCacheFileName() );
+    if(!file.open(QFile::ReadOnly))
+    {
+        return 0;
+    }
+    QDataStream in(&file);
+    quint32 magic, version;
+    qint32 count, pageSize, numberOfPages;
+    in >> magic >> version >> count >> pageSize >> numberOfPages;
+    if( magic != CACHE_MAGIC || version != CACHE_VERSION || pageSize != mPageSize || numberOfPages != mNumberOfPages ||
+        in.readRawData( (char*)pAccumulated, numberOfFloats * sizeof(float) ) != (int)(numberOfFloats * sizeof(float)) )
+    {
+        Debug::Warning( QString("ObscuranceMap::ResumeAccumulation - Invalid cache file %1").arg( file.fileName() ) );
+        for( int i = 0; i < numberOfFloats; i++ )
+        {
+            pAccumulated[i] = 0.0f;
+        }
+        return 0;
+    }
+    //The accumulated sums can not be split by direction, so a cache with more directions would give a different result
+    if( count > pMaxIterations )
+    {
+        Debug::Log( QString("ObscuranceMap::ResumeAccumulation - %1 has %2 directions, more than the %3 requested, it is not used").arg( file.fileName() ).arg(count).arg(pMaxIterations) );
+        for( int i = 0; i < numberOfFloats; i++ )
+        {
+            pAccumulated[i] = 0.0f;
+        }
+        return 0;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mTexTransfer);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, mPageSize, mPageSize, mNumberOfPages, GL_RG, GL_FLOAT, pAccumulated);
+    mCount = count;
+    Debug::Log( QString("ObscuranceMap::ResumeAccumulation - %1 directions loaded from %2").arg(mCount).arg( file.fileName() ) );
+    return mCount;
+}
+
+void ObscuranceMap::SaveAccumulation(float* pAccumulated) const
+{
+    ReadLightmap(mTexTransfer, GL_RG, pAccumulated);
+
+    if(mCacheDirectory.isEmpty())
+    {
+        return;
+    }
+    if(!QDir().mkpath(mCacheDirectory))
+    {
+        Debug::Warning( QString("ObscuranceMap::SaveAccumulation - Impossible to create the folder %1").arg(mCacheDirectory) );
+        return;
+    }
+    //A cache with more directions is kept for the computations that ask for them
+    QString fileName = GetCacheFileName();
+    QFile previousFile(fileName);
+    if(previousFile.open(QFile::ReadOnly))
+    {
+        QDataStream in(&previousFile);
+        quint32 magic, version;
+        qint32 count;
+        in >> magic >> version >> count;
+        if( in.status() == QDataStream::Ok && magic == CACHE_MAGIC && version == CACHE_VERSION && count > mCount )
+        {
+            Debug::Log( QString("ObscuranceMap::SaveAccumulation - %1 already has %2 directions, it is kept").arg(fileName).arg(count) );
+            return;
+        }
+        previousFile.close();
+    }
+    //The file is replaced only when it is complete, so an interrupted save keeps the previous accumulation
+    QFile file(fileName + ".tmp");
+    if(!file.open(QFile::WriteOnly))
+    {
+        Debug::Warning( QString("ObscuranceMap::SaveAccumulation - Impossible to write %1").arg( file.fileName() ) );
+        return;
+    }
+    QDataStream out(&file);
+    out << CACHE_MAGIC << CACHE_VERSION << (qint32)mCount << (qint32)mPageSize << (qint32)mNumberOfPages;
+    out.writeRawData( (const char*)pAccumulated, mPageSize * mPageSize * mNumberOfPages * 2 * sizeof(float) );
+    file.close();
+    QFile::remove(fileName);
+    if(out.status() != QDataStream::Ok || !file.rename(fileName))
+    {
+        Debug::Warning( QString("ObscuranceMap::SaveAccumulation - Impossible to write %1").arg(fileName) );
+        return;
+    }
+    Debug::Log( QString("ObscuranceMap::SaveAccumulation - %1 directions saved into %2").arg(mCount).arg(fileName) );
+}
+
+// Function that divides the accumulated obscurance of every polygon by its number of samples, page by page.
 void ObscuranceMap::NormalizeLightmap()
 {
     mNormalizeProgram->UseProgram();
@@ -394,28 +691,42 @@ void ObscuranceMap::NormalizeLightmap()
 
     glEnable(GL_CULL_FACE);
 
-    glViewport(0, 0, mResLightmapX, mResLightmapY);
+    glViewport(0, 0, mPageSize, mPageSize);
 
-    glm::mat4 projection = glm::ortho(-(float)mResLightmapX, (float)mResLightmapY, -(float)mResLightmapX, (float)mResLightmapY);
+    glm::mat4 projection = glm::ortho(-(float)mPageSize, (float)mPageSize, -(float)mPageSize, (float)mPageSize);
     glm::mat4 modelView = glm::mat4(1.0f);
 
-    mNormalizeProgram->BindTexture(GL_TEXTURE_2D, "texture", mTexTransfer, 0);
-    mNormalizeProgram->SetUniform("res", (float)mResLightmapX);
+    mNormalizeProgram->BindTexture(GL_TEXTURE_2D_ARRAY, "texture", mTexTransfer, 0);
+    mNormalizeProgram->SetUniform("pageSize", mPageSize);
     mNormalizeProgram->SetUniform("modelViewProjection", projection * modelView);
 
-    //Draw the geometry.
-    glBegin(GL_QUADS);
+    for( int layer = 0; layer < mNumberOfPages; layer++ )
     {
-        glTexCoord2f(0, 0);  glVertex3f(-mResLightmapX, -mResLightmapY, -0.5f);
-        glTexCoord2f(1, 0);  glVertex3f( mResLightmapX, -mResLightmapY, -0.5f);
-        glTexCoord2f(1, 1);  glVertex3f( mResLightmapX,  mResLightmapY, -0.5f);
-        glTexCoord2f(0, 1);  glVertex3f(-mResLightmapX,  mResLightmapY, -0.5f);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, mTexNormalize, 0, layer);
+        mNormalizeProgram->SetUniform("layer", layer);
+
+        //Draw the geometry.
+        glBegin(GL_QUADS);
+        {
+            glVertex3f(-mPageSize, -mPageSize, -0.5f);
+            glVertex3f( mPageSize, -mPageSize, -0.5f);
+            glVertex3f( mPageSize,  mPageSize, -0.5f);
+            glVertex3f(-mPageSize,  mPageSize, -0.5f);
+        }
+        glEnd();
     }
-    glEnd();
+}
+
+void ObscuranceMap::ReadLightmap(GLuint pTexture, GLenum pFormat, float* pData) const
+{
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, pTexture);
+    glGetTexImage(GL_TEXTURE_2D_ARRAY, 0, pFormat, GL_FLOAT, pData);
 }
 
 // Function that renders the depth peeling geometry planes and stores them in PBOs.
-unsigned int ObscuranceMap::RenderProjeccions(const glm::vec3& pCameraPosition, int pBuffer, int pFirst)
+void ObscuranceMap::RenderProjeccions(const glm::vec3& pCameraPosition, int pBuffer, int pFirst, GLuint pQueryId)
 {
     mProjectionProgram->UseProgram();
     glBindFramebuffer(GL_FRAMEBUFFER, mFbProjeccions);
@@ -434,7 +745,7 @@ unsigned int ObscuranceMap::RenderProjeccions(const glm::vec3& pCameraPosition,
     mProjectionProgram->SetUniform("modelViewInverseTranspose", glm::inverseTranspose(modelView));
     mProjectionProgram->SetUniform("res", (float)mResProjectionX);
     mProjectionProgram->SetUniform("first", (float)pFirst);
-    mProjectionProgram->SetUniform("polygonalTexturesSize", mResLightmapX);
+    mProjectionProgram->SetUniform("polygonalTexturesSize", mPageSize);
 
     int other = ((pBuffer == 1)? 0:1);
     if(pFirst == 0)
@@ -448,26 +759,21 @@ unsigned int ObscuranceMap::RenderProjeccions(const glm::vec3& pCameraPosition,
         mProjectionProgram->BindTexture(GL_TEXTURE_2D, "ztex", mTexName, 0);
     }
 
-    glBeginQuery(GL_SAMPLES_PASSED, mQueryId);
-    int processedPolygons = 0;
-    for( int i = 0; i < mScene->GetNumberOfMeshes(); i++ )
+    glBeginQuery(GL_SAMPLES_PASSED, pQueryId);
+    QVector<int> meshOrder = mScene->GetMeshTraversalOrder();
+    for( int i = 0; i < meshOrder.size(); i++ )
     {
-        Geometry* currentMesh = mScene->GetMesh(i);
+        Geometry* currentMesh = mScene->GetMesh(meshOrder.at(i));
 
-        mProjectionProgram->SetUniform("offset", processedPolygons);
+        mProjectionProgram->SetUniform("offset", mScene->GetPolygonOffsetOfMesh(meshOrder.at(i)));
         currentMesh->Draw();
-        processedPolygons += currentMesh->GetNumFaces();
     }
     glEndQuery(GL_SAMPLES_PASSED);
-    unsigned int sampleCount;
-    glGetQueryObjectuiv(mQueryId, GL_QUERY_RESULT, &sampleCount);
 
     //Copy the color buffer to PBO.
     glBindBuffer( GL_PIXEL_PACK_BUFFER, mProjectionsPBO[pBuffer] );			// Bind The Buffer
     glReadPixels(0, 0, mResProjectionX, mResProjectionY, GL_RGBA, GL_FLOAT, BUFFER_OFFSET(0));
     glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-
-    return sampleCount;
 }
 
 // Function that calculates the lightmap using the neighbouring projections.
@@ -482,27 +788,27 @@ void ObscuranceMap::RenderTransfer(int pBuffer, int pFirst)
 
     glEnable(GL_BLEND);
 
-    glViewport(0, 0, mResLightmapX, mResLightmapY);
+    glViewport(0, 0, mPageSize, mPageSize);
 
     mTransferProgram->SetUniform("dmax", 0.3f);
+    mTransferProgram->SetUniform("pageSize", mPageSize);
 
     glEnableVertexAttribArray(POSITION);
-    glEnableVertexAttribArray(TEXTCOORD);
     if(pFirst == 1)
     {
-        //First Render
+        //First Render, the other layer is empty so it is a constant blue attribute instead of a buffer
         mTransferProgram->SetUniform("direction", (float)pBuffer);
 
         glBindBuffer( GL_ARRAY_BUFFER, mProjectionsPBO[pBuffer] );
         glVertexAttribPointer(POSITION, 4, GL_FLOAT, GL_FALSE, 0, 0);
 
-        glBindBuffer( GL_ARRAY_BUFFER, mProjectionsPBO[other] );
-        glVertexAttribPointer(TEXTCOORD, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        glVertexAttrib4f(TEXTCOORD, 0.0f, 0.0f, 1.0f, 1.0f);
 
         glDrawArrays(GL_POINTS, 0, mResProjectionX*mResProjectionY );
     }
     else
     {
+        glEnableVertexAttribArray(TEXTCOORD);
         mTransferProgram->SetUniform("direction", 0.0f);
 
         glBindBuffer( GL_ARRAY_BUFFER, mProjectionsPBO[pBuffer] );
@@ -0,0 +1,291 @@
+//Definition include
+#include "ObscuranceRayTracer.h"
+
+//Qt includes
+#include <QHash>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTime>
+
+//Dependency includes
+#include "glm/common.hpp"
+#include "glm/exponential.hpp"
+#include "glm/geometric.hpp"
+#include "glm/trigonometric.hpp"
+
+//Project includes
+#include "Debug.h"
+#include "Tools.h"
+
+/// Number of polygons computed by every task of the thread pool
+const int POLYGONS_PER_TASK = 256;
+/// Mark of the polygons whose rays only hit back faces, they get the obscurance of their neighbours
+const float UNRESOLVED_OBSCURANCE = -1.0f;
+
+/// Task of the thread pool that computes the obscurances of a range of polygons
+class ObscuranceRayTracerTask : public QRunnable
+{
+public:
+    ObscuranceRayTracerTask(ObscuranceRayTracer* pTracer, int pFirstPolygon, int pLastPolygon, int pIterations):
+        mTracer(pTracer), mFirstPolygon(pFirstPolygon), mLastPolygon(pLastPolygon), mIterations(pIterations)
+    {
+
+    }
+
+    void run()
+    {
+        mTracer->ComputeObscurances(mFirstPolygon, mLastPolygon, mIterations);
+    }
+
+private:
+    ObscuranceRayTracer* mTracer;
+    int mFirstPolygon;
+    int mLastPolygon;
+    int mIterations;
+};
+
+/// Hash of the polygon used to decorrelate the sequences of different polygons, the result is in [0, 1)
+static float Hash(quint32 pValue)
+{
+    pValue ^= pValue >> 16;
+    pValue *= 0x7feb352dU;
+    pValue ^= pValue >> 15;
+    pValue *= 0x846ca68bU;
+    pValue ^= pValue >> 16;
+    return ( pValue >> 8 ) / 16777216.0f;
+}
+
+/// Key of a vertex position to find the polygons that share it
+static QByteArray GetPositionKey(const glm::vec3& pPosition)
+{
+    return QByteArray( (const char*)&pPosition, sizeof(glm::vec3) );
+}
+
+ObscuranceRayTracer::ObscuranceRayTracer(Scene *pScene):
+    mScene(NULL), mHierarchy(NULL), mMaxDistance(0.3f), mSceneRadius(0.0f), mObscurances(NULL)
+{
+    SetScene(pScene);
+}
+
+ObscuranceRayTracer::~ObscuranceRayTracer()
+{
+    delete mHierarchy;
+    delete[] mObscurances;
+}
+
+void ObscuranceRayTracer::SetScene(Scene* pScene)
+{
+    QTime t;
+    t.start();
+
+    mScene = pScene;
+    mSceneRadius = mScene->GetBoundingSphere()->GetRadius();
+
+    delete mHierarchy;
+    mHierarchy = new BoundingVolumeHierarchy(mScene);
+    Debug::Log( QString("ObscuranceRayTracer::SetScene - Hierarchy built in %1 ms").arg( t.elapsed() ) );
+}
+
+void ObscuranceRayTracer::SetMaxDistance(float pMaxDistance)
+{
+    mMaxDistance = pMaxDistance;
+}
+
+void ObscuranceRayTracer::ComputeObscurances(int pIterations)
+{
+    if(mObscurances != NULL)
+    {
+        delete[] mObscurances;
+    }
+    int bufferSize = mScene->GetNumberOfPolygons();
+    mObscurances = new float[bufferSize];
+    for( int i = 0; i < bufferSize; i++ )
+    {
+        mObscurances[i] = 0.0f;
+    }
+
+    //Every task writes a disjoint range of the buffer
+    int numberOfPolygons = mHierarchy->GetNumberOfTriangles();
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount( QThread::idealThreadCount() );
+    for( int i = 0; i < numberOfPolygons; i += POLYGONS_PER_TASK )
+    {
+        threadPool.start( new ObscuranceRayTracerTask( this, i, glm::min(i + POLYGONS_PER_TASK, numberOfPolygons), pIterations ) );
+    }
+    threadPool.waitForDone();
+
+    FillUnresolvedObscurances();
+}
+
+const float* ObscuranceRayTracer::GetObscurances() const
+{
+    return mObscurances;
+}
+
+void ObscuranceRayTracer::ComputeObscurances(int pFirstPolygon, int pLastPolygon, int pIterations)
+{
+    //Same distance than the one used by the Transfer shader of ObscuranceMap: dmax of the depth range of the projections
+    float maxDistance = mMaxDistance * mSceneRadius * glm::sqrt(12.0f);
+    float offset = mSceneRadius * 1e-5f;
+
+    for( int currentPolygon = pFirstPolygon; currentPolygon < pLastPolygon; currentPolygon++ )
+    {
+        glm::vec3 v0 = mHierarchy->GetVertex(currentPolygon, 0);
+        glm::vec3 edge1 = mHierarchy->GetVertex(currentPolygon, 1) - v0;
+        glm::vec3 edge2 = mHierarchy->GetVertex(currentPolygon, 2) - v0;
+        glm::vec3 normal = mHierarchy->GetNormal(currentPolygon);
+        if( glm::dot(normal, normal) == 0.0f )
+        {
+            continue;
+        }
+        glm::vec3 tangent = glm::normalize( glm::cross( ( glm::abs(normal.x) > 0.9f ) ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f), normal ) );
+        glm::vec3 bitangent = glm::cross(normal, tangent);
+
+        float shift[4];
+        for( int i = 0; i < 4; i++ )
+        {
+            shift[i] = Hash( currentPolygon * 4 + i );
+        }
+
+        float sum = 0.0f;
+        int samples = 0;
+        for( int i = 1; i <= pIterations; i++ )
+        {
+            //Uniform point over the polygon
+            float a = glm::fract( Tools::VanDerCorput(i, 5) + shift[0] );
+            float b = glm::fract( Tools::VanDerCorput(i, 7) + shift[1] );
+            if( a + b > 1.0f )
+            {
+                a = 1.0f - a;
+                b = 1.0f - b;
+            }
+            glm::vec3 origin = v0 + edge1 * a + edge2 * b + normal * offset;
+
+            //Cosine weighted direction like the projected area of the polygon in the projections of ObscuranceMap
+            float u1 = glm::fract( Tools::VanDerCorput(i, 2) + shift[2] );
+            float u2 = glm::fract( Tools::VanDerCorput(i, 3) + shift[3] );
+            float r = glm::sqrt(u1);
+            float phi = 2.0f * 3.14159265358979f * u2;
+            glm::vec3 direction = tangent * ( r * glm::cos(phi) ) + bitangent * ( r * glm::sin(phi) ) + normal * glm::sqrt( glm::max(0.0f, 1.0f - u1) );
+
+            float distance;
+            int hit = mHierarchy->Intersect(origin, direction, maxDistance, currentPolygon, distance);
+            if( hit == -1 )
+            {
+                sum += 1.0f;
+                samples++;
+            }
+            else if( glm::dot( mHierarchy->GetNormal(hit), direction ) < 0.0f )
+            {
+                sum += glm::sqrt( distance / maxDistance );
+                samples++;
+            }
+            //Back faces are ignored like in the Transfer shader of ObscuranceMap
+        }
+
+        if( samples > 0 )
+        {
+            float obscurance = sum / samples;
+            mObscurances[currentPolygon] = obscurance;
+        }
+        else
+        {
+            mObscurances[currentPolygon] = UNRESOLVED_OBSCURANCE;
+        }
+    }
+}
+
+void ObscuranceRayTracer::FillUnresolvedObscurances()
+{
+    int numberOfPolygons = mHierarchy->GetNumberOfTriangles();
+    QVector<int> unresolved;
+    for( int i = 0; i < numberOfPolygons; i++ )
+    {
+        if( mObscurances[i] == UNRESOLVED_OBSCURANCE )
+        {
+            unresolved.push_back(i);
+        }
+    }
+    if( unresolved.isEmpty() )
+    {
+        return;
+    }
+
+    //Polygons that share a vertex with the unresolved ones
+    QHash< QByteArray, QVector<int> > polygonsOfVertex;
+    for( int i = 0; i < unresolved.size(); i++ )
+    {
+        for( int j = 0; j < 3; j++ )
+        {
+            polygonsOfVertex.insert( GetPositionKey( mHierarchy->GetVertex(unresolved.at(i), j) ), QVector<int>() );
+        }
+    }
+    for( int i = 0; i < numberOfPolygons; i++ )
+    {
+        for( int j = 0; j < 3; j++ )
+        {
+            QHash< QByteArray, QVector<int> >::iterator it = polygonsOfVertex.find( GetPositionKey( mHierarchy->GetVertex(i, j) ) );
+            if( it != polygonsOfVertex.end() )
+            {
+                it.value().push_back(i);
+            }
+        }
+    }
+
+    //Every step fills the unresolved polygons next to resolved ones with their mean, until nothing changes
+    int filled = 0;
+    bool changed = true;
+    while( changed && !unresolved.isEmpty() )
+    {
+        QVector<float> values( unresolved.size(), UNRESOLVED_OBSCURANCE );
+        for( int i = 0; i < unresolved.size(); i++ )
+        {
+            float sum = 0.0f;
+            int neighbours = 0;
+            for( int j = 0; j < 3; j++ )
+            {
+                const QVector<int>& polygons = polygonsOfVertex[ GetPositionKey( mHierarchy->GetVertex(unresolved.at(i), j) ) ];
+                for( int k = 0; k < polygons.size(); k++ )
+                {
+                    if( mObscurances[polygons.at(k)] != UNRESOLVED_OBSCURANCE )
+                    {
+                        sum += mObscurances[polygons.at(k)];
+                        neighbours++;
+                    }
+                }
+            }
+            if( neighbours > 0 )
+            {
+                values[i] = sum / neighbours;
+            }
+        }
+
+        changed = false;
+        QVector<int> stillUnresolved;
+        for( int i = 0; i < unresolved.size(); i++ )
+        {
+            if( values.at(i) != UNRESOLVED_OBSCURANCE )
+            {
+                mObscurances[unresolved.at(i)] = values.at(i);
+                changed = true;
+                filled++;
+            }
+            else
+            {
+                stillUnresolved.push_back( unresolved.at(i) );
+            }
+        }
+        unresolved = stillUnresolved;
+    }
+
+    Debug::Log( QString("ObscuranceRayTracer::FillUnresolvedObscurances - %1 polygons only hit back faces, obscurance taken from their neighbours").arg(filled) );
+    if( !unresolved.isEmpty() )
+    {
+        Debug::Warning( QString("ObscuranceRayTracer::FillUnresolvedObscurances - %1 polygons only hit back faces and have no neighbours to take the obscurance from, they are left fully obscured").arg( unresolved.size() ) );
+        for( int i = 0; i < unresolved.size(); i++ )
+        {
+            mObscurances[unresolved.at(i)] = 0.0f;
+        }
+    }
+}
@@ -6,6 +6,32 @@
 #include "glm/geometric.hpp"
 #include "glm/trigonometric.hpp"
 
+//Project includes
+#include "Debug.h"
+
+/// Maximum difference per coordinate of two equal vertices
+const float VERTEX_EPSILON = 0.0001f;
+/// Size of the cells of the spatial hash of the vertices, smaller than the distance between the points of the deepest spheres
+const float VERTEX_CELL_SIZE = 0.001f;
+
+/// Cell of the spatial hash of a coordinate
+static inline int VertexCell(float pCoordinate)
+{
+    return (int)glm::floor(pCoordinate / VERTEX_CELL_SIZE);
+}
+
+/// Key of the cell of the spatial hash, the coordinates of the unit sphere need 11 bits per cell index
+static inline quint64 VertexCellKey(int pX, int pY, int pZ)
+{
+    return ( (quint64)( pX + ( 1 << 20 ) ) << 42 ) | ( (quint64)( pY + ( 1 << 20 ) ) << 21 ) | (quint64)( pZ + ( 1 << 20 ) );
+}
+
+/// Key of the edge between the points \a pV1 and \a pV2, the same in both directions
+static inline quint64 EdgeKey(unsigned int pV1, unsigned int pV2)
+{
+    return ( (quint64)glm::min(pV1, pV2) << 32 ) | glm::max(pV1, pV2);
+}
+
 glm::vec3 SpherePointCloud::Up(const glm::vec3 &pViewpoint)
 {
     float max = glm::max( glm::abs(pViewpoint.x), glm::max( glm::abs(pViewpoint.y), glm::abs(pViewpoint.z) ) );
@@ -49,8 +75,24 @@ void SpherePointCloud::SetToQuasiUniform(unsigned char pDepth)
     CreateIcosahedron();
 
     QVector< unsigned int > tempFaces = mFaces;
+    QVector< glm::vec3 > icosahedronVertices = mVertices;
 
+    // The vertices are added again in the order they are found by the subdivision
     mFaces.clear();
+    mVertices.clear();
+    mNormals.clear();
+    mVertexCells.clear();
+    mNextVertexInCell.clear();
+    int expectedNumberOfPoints = 10 * ( 1 << ( 2 * pDepth ) ) + 2;
+    mVertices.reserve(expectedNumberOfPoints);
+    mNormals.reserve(expectedNumberOfPoints);
+    mNextVertexInCell.reserve(expectedNumberOfPoints);
+    mFaces.reserve( tempFaces.size() * ( 1 << ( 2 * pDepth ) ) );
+    mVertexCells.reserve(expectedNumberOfPoints);
+    for( int i = 0; i < icosahedronVertices.size(); i++ )
+    {
+        AddSphereCloudVertex( icosahedronVertices.at(i) );
+    }
 
     // Each triangle has to be subdivided as many times as the sphere depth
     for( int i = 0; i < tempFaces.size(); i += 3 )
@@ -61,10 +103,248 @@ void SpherePointCloud::SetToQuasiUniform(unsigned char pDepth)
 
         Subdivide( mVertices.at(face1), mVertices.at(face2), mVertices.at(face3), pDepth );
     }
+    mVertexCells.clear();
+    mNextVertexInCell.clear();
+    mNumberOfPoints = mVertices.size();
+    ComputeQuasiUniformNeighbours();
+    CreateVerticesInOtherCoordinates();
+    SetMeshInformation();
+}
+
+void SpherePointCloud::RestrictToElevationBand(const glm::vec3 &pUp, float pMinElevation, float pMaxElevation)
+{
+    glm::vec3 up = glm::normalize(pUp);
+    float minSin = glm::sin( glm::radians( glm::clamp(pMinElevation, -90.0f, 90.0f) ) );
+    float maxSin = glm::sin( glm::radians( glm::clamp(pMaxElevation, -90.0f, 90.0f) ) );
+
+    // New position of every point, -1 for the discarded ones
+    QVector<int> newIndices( mNumberOfPoints, -1 );
+    QVector< glm::vec3 > vertices;
+    QVector< glm::vec3 > normals;
+    for( int i = 0; i < mNumberOfPoints; i++ )
+    {
+        // The points are in the unit sphere, so the sine of the elevation is the projection over the up direction
+        float elevation = glm::dot( mVertices.at(i), up );
+        if( elevation >= minSin - VERTEX_EPSILON && elevation <= maxSin + VERTEX_EPSILON )
+        {
+            newIndices[i] = vertices.size();
+            vertices.push_back( mVertices.at(i) );
+            normals.push_back( mNormals.at(i) );
+        }
+    }
+
+    if( vertices.isEmpty() )
+    {
+        Debug::Warning( QString("SpherePointCloud::RestrictToElevationBand - No point between %1 and %2 degrees, the whole sphere is kept").arg(pMinElevation).arg(pMaxElevation) );
+        return;
+    }
+
+    QVector< unsigned int > faces;
+    for( int i = 0; i < mFaces.size(); i += 3 )
+    {
+        int v1 = newIndices.at( mFaces.at(i) );
+        int v2 = newIndices.at( mFaces.at(i+1) );
+        int v3 = newIndices.at( mFaces.at(i+2) );
+        if( v1 != -1 && v2 != -1 && v3 != -1 )
+        {
+            faces.push_back(v1);
+            faces.push_back(v2);
+            faces.push_back(v3);
+        }
+    }
+
+    // The neighbours come from the whole sphere, so the points of the border keep the ones inside the band
+    QVector< QVector<int> > neighbours( vertices.size() );
+    for( int i = 0; i < mNumberOfPoints; i++ )
+    {
+        if( newIndices.at(i) != -1 )
+        {
+            const QVector<int>& vertexNeighbours = mNeighbours.at(i);
+            QVector<int>& newNeighbours = neighbours[ newIndices.at(i) ];
+            for( int j = 0; j < vertexNeighbours.size(); j++ )
+            {
+                int neighbour = newIndices.at( vertexNeighbours.at(j) );
+                if( neighbour != -1 )
+                {
+                    newNeighbours.push_back(neighbour);
+                }
+            }
+        }
+    }
+
+    mVertices = vertices;
+    mNormals = normals;
+    mFaces = faces;
+    mNeighbours = neighbours;
+    mNumberOfPoints = mVertices.size();
+    CreateVerticesInOtherCoordinates();
+    SetMeshInformation();
+}
+
+void SpherePointCloud::SubdivideFaces(const QVector<int> &pFaces)
+{
+#ifdef QT_DEBUG
+    bool wasWatertight = IsWatertight();
+#endif
+    int nFaces = mFaces.size() / 3;
+    QVector<bool> subdivide( nFaces, false );
+    // Midpoint of every edge that is split, -1 until it is created
+    QHash< quint64, int > midpoints;
+    for( int i = 0; i < pFaces.size(); i++ )
+    {
+        subdivide[ pFaces.at(i) ] = true;
+        for( int j = 0; j < 3; j++ )
+        {
+            midpoints.insert( EdgeKey( mFaces.at( 3 * pFaces.at(i) + j ), mFaces.at( 3 * pFaces.at(i) + ( j + 1 ) % 3 ) ), -1 );
+        }
+    }
+
+    // Closure: a face with two or three split edges is subdivided in four too, which can split edges of other faces
+    bool changed = true;
+    while( changed )
+    {
+        changed = false;
+        for( int i = 0; i < nFaces; i++ )
+        {
+            if( !subdivide.at(i) )
+            {
+                int splitEdges = 0;
+                for( int j = 0; j < 3; j++ )
+                {
+                    if( midpoints.contains( EdgeKey( mFaces.at(3 * i + j), mFaces.at( 3 * i + ( j + 1 ) % 3 ) ) ) )
+                    {
+                        splitEdges++;
+                    }
+                }
+                if( splitEdges >= 2 )
+                {
+                    subdivide[i] = true;
+                    for( int j = 0; j < 3; j++ )
+                    {
+                        midpoints.insert( EdgeKey( mFaces.at(3 * i + j), mFaces.at( 3 * i + ( j + 1 ) % 3 ) ), -1 );
+                    }
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // The new points are added after the existing ones in the order of the faces
+    QVector< int > faceMidpoints( 3 * nFaces, -1 );
+    for( int i = 0; i < nFaces; i++ )
+    {
+        for( int j = 0; j < 3; j++ )
+        {
+            unsigned int v1 = mFaces.at(3 * i + j);
+            unsigned int v2 = mFaces.at( 3 * i + ( j + 1 ) % 3 );
+            QHash< quint64, int >::iterator it = midpoints.find( EdgeKey(v1, v2) );
+            if( it != midpoints.end() )
+            {
+                if( it.value() == -1 )
+                {
+                    // It's not necessary to divide by 2 the midpoint because we normalize it
+                    glm::vec3 midpoint = glm::normalize( mVertices.at(v1) + mVertices.at(v2) );
+                    it.value() = mVertices.size();
+                    mVertices.push_back(midpoint);
+                    mNormals.push_back(midpoint);
+                }
+                faceMidpoints[3 * i + j] = it.value();
+            }
+        }
+    }
+
+    // The faces that are not split keep their order and the new ones are added at the end.
+    // A face with one split edge is split in two through the opposite vertex, so no midpoint is left hanging
+    QVector< unsigned int > tempFaces = mFaces;
+    mFaces.clear();
+    mFaces.reserve( tempFaces.size() + 9 * pFaces.size() + 3 * midpoints.size() );
+    for( int i = 0; i < nFaces; i++ )
+    {
+        if( faceMidpoints.at(3 * i) == -1 && faceMidpoints.at(3 * i + 1) == -1 && faceMidpoints.at(3 * i + 2) == -1 )
+        {
+            mFaces.push_back( tempFaces.at(3 * i) );
+            mFaces.push_back( tempFaces.at(3 * i + 1) );
+            mFaces.push_back( tempFaces.at(3 * i + 2) );
+        }
+    }
+    int bisectedFaces = 0;
+    for( int i = 0; i < nFaces; i++ )
+    {
+        unsigned int v1 = tempFaces.at(3 * i);
+        unsigned int v2 = tempFaces.at(3 * i + 1);
+        unsigned int v3 = tempFaces.at(3 * i + 2);
+        if( subdivide.at(i) )
+        {
+            unsigned int v12 = faceMidpoints.at(3 * i);
+            unsigned int v23 = faceMidpoints.at(3 * i + 1);
+            unsigned int v31 = faceMidpoints.at(3 * i + 2);
+            AddSphereCloudTriangle( v1, v12, v31 );
+            AddSphereCloudTriangle( v2, v23, v12 );
+            AddSphereCloudTriangle( v3, v31, v23 );
+            AddSphereCloudTriangle( v12, v23, v31 );
+        }
+        else
+        {
+            for( int j = 0; j < 3; j++ )
+            {
+                if( faceMidpoints.at(3 * i + j) != -1 )
+                {
+                    // The split edge goes from a to b and c is the opposite vertex, the winding is kept
+                    unsigned int a = tempFaces.at(3 * i + j);
+                    unsigned int b = tempFaces.at( 3 * i + ( j + 1 ) % 3 );
+                    unsigned int c = tempFaces.at( 3 * i + ( j + 2 ) % 3 );
+                    AddSphereCloudTriangle( a, faceMidpoints.at(3 * i + j), c );
+                    AddSphereCloudTriangle( faceMidpoints.at(3 * i + j), b, c );
+                    bisectedFaces++;
+                }
+            }
+        }
+    }
+    Debug::Log( QString("SpherePointCloud::SubdivideFaces - %1 faces subdivided in four and %2 split in two to avoid hanging points").arg( subdivide.count(true) ).arg(bisectedFaces) );
+
     mNumberOfPoints = mVertices.size();
     ComputeQuasiUniformNeighbours();
     CreateVerticesInOtherCoordinates();
     SetMeshInformation();
+
+#ifdef QT_DEBUG
+    if( wasWatertight && !IsWatertight() )
+    {
+        Debug::Error( "SpherePointCloud::SubdivideFaces - The refined sphere is not watertight" );
+    }
+#endif
+}
+
+bool SpherePointCloud::IsWatertight() const
+{
+    // Every edge is shared by two faces that go through it in opposite directions, so every directed edge appears once
+    // and its reverse appears too
+    QHash< quint64, int > directedEdges;
+    directedEdges.reserve( mFaces.size() );
+    for( int i = 0; i < mFaces.size(); i += 3 )
+    {
+        for( int j = 0; j < 3; j++ )
+        {
+            quint64 key = ( (quint64)mFaces.at(i + j) << 32 ) | mFaces.at( i + ( j + 1 ) % 3 );
+            if( directedEdges.contains(key) )
+            {
+                return false;
+            }
+            directedEdges.insert(key, i / 3);
+        }
+    }
+    for( int i = 0; i < mFaces.size(); i += 3 )
+    {
+        for( int j = 0; j < 3; j++ )
+        {
+            quint64 reverseKey = ( (quint64)mFaces.at( i + ( j + 1 ) % 3 ) << 32 ) | mFaces.at(i + j);
+            if( !directedEdges.contains(reverseKey) )
+            {
+                return false;
+            }
+        }
+    }
+    return true;
 }
 
 QVector<unsigned int> SpherePointCloud::GetFaces() const
@@ -104,53 +384,26 @@ QVector<int> SpherePointCloud::GetNeighbours(unsigned int pI) const
 
 void SpherePointCloud::ComputeQuasiUniformNeighbours()
 {
-    mNeighbours.clear();
     int nFaces = mFaces.size() / 3;
     Q_ASSERT( nFaces * 3 == mFaces.size() );
 
-    for ( int i = 0; i < mNumberOfPoints; i++ )
+    // A single pass over the faces, every vertex gets its neighbours in the order of the faces
+    mNeighbours.fill( QVector<int>(), mNumberOfPoints );
+    for ( int j = 0; j < nFaces; j++ )
     {
-        QVector<int> vertexNeighbours;
-
-        for ( int j = 0; j < nFaces; j++ )
+        for ( int k = 0; k < 3; k++ )
         {
-            if ( mFaces.at( 3 * j ) == i )
-            {
-                if ( vertexNeighbours.indexOf( mFaces.at( 3 * j + 1 ) ) == -1 )
-                {
-                    vertexNeighbours.push_back(mFaces.at( 3 * j + 1 ));
-                }
-                if ( vertexNeighbours.indexOf( mFaces.at( 3 * j + 2 ) ) == -1 )
-                {
-                    vertexNeighbours.push_back(mFaces.at( 3 * j + 2 ));
-                }
-            }
-
-            if ( mFaces.at( 3 * j + 1 ) == i )
-            {
-                if ( vertexNeighbours.indexOf( mFaces.at( 3 * j ) ) == -1 )
-                {
-                    vertexNeighbours.push_back(mFaces.at( 3 * j ));
-                }
-                if ( vertexNeighbours.indexOf( mFaces.at( 3 * j + 2 ) ) == -1 )
-                {
-                    vertexNeighbours.push_back(mFaces.at( 3 * j + 2 ));
-                }
-            }
-
-            if ( mFaces.at( 3 * j + 2 ) == i )
+            QVector<int>& vertexNeighbours = mNeighbours[ mFaces.at( 3 * j + k ) ];
+            for ( int l = 0; l < 3; l++ )
             {
-                if ( vertexNeighbours.indexOf( mFaces.at( 3 * j ) ) == -1 )
-                {
-                    vertexNeighbours.push_back(mFaces.at( 3 * j ));
-                }
-                if ( vertexNeighbours.indexOf( mFaces.at( 3 * j + 1 ) ) == -1 )
+                int neighbour = mFaces.at( 3 * j + l );
+                // The lists are short, 6 vertices for most of the points
+                if ( l != k && !vertexNeighbours.contains(neighbour) )
                 {
-                    vertexNeighbours.push_back(mFaces.at( 3 * j + 1 ));
+                    vertexNeighbours.push_back(neighbour);
                 }
             }
         }
-        mNeighbours.push_back(vertexNeighbours);
     }
 }
 
@@ -211,63 +464,73 @@ inline bool equal(const glm::vec3 & v1, const glm::vec3 & v2, float error)
 
 bool SpherePointCloud::FindSphereCloudVertex(const glm::vec3 & pV, unsigned int & pPosition) const
 {
-    int i = 0;
-    bool trobat = false;
-
-    while ( i < mVertices.size() && !trobat )
+    // Only the cells that overlap the box of the epsilon around the vertex are checked, usually one
+    int minX = VertexCell( pV.x - VERTEX_EPSILON ), maxX = VertexCell( pV.x + VERTEX_EPSILON );
+    int minY = VertexCell( pV.y - VERTEX_EPSILON ), maxY = VertexCell( pV.y + VERTEX_EPSILON );
+    int minZ = VertexCell( pV.z - VERTEX_EPSILON ), maxZ = VertexCell( pV.z + VERTEX_EPSILON );
+    for ( int x = minX; x <= maxX; x++ )
     {
-        if ( equal( pV, mVertices.at(i), 0.0001f ) ) trobat = true;
-        else i++;
+        for ( int y = minY; y <= maxY; y++ )
+        {
+            for ( int z = minZ; z <= maxZ; z++ )
+            {
+                int i = mVertexCells.value( VertexCellKey(x, y, z), -1 );
+                while ( i != -1 )
+                {
+                    if ( equal( pV, mVertices.at(i), VERTEX_EPSILON ) )
+                    {
+                        pPosition = i;
+                        return true;
+                    }
+                    i = mNextVertexInCell.at(i);
+                }
+            }
+        }
     }
-    pPosition = i;
+    pPosition = mVertices.size();
 
-    return trobat;
+    return false;
 }
 
-void SpherePointCloud::CreateSphereCloudTriangle(const glm::vec3 & pV1, const glm::vec3 & pV2, const glm::vec3 & pV3)
+unsigned int SpherePointCloud::AddSphereCloudVertex(const glm::vec3 & pV)
 {
-    unsigned int pos;
+    unsigned int position = mVertices.size();
+    mVertices.push_back( pV );
+    mNormals.push_back( pV );
+    InsertInSpatialHash(position);
+    return position;
+}
 
-    // Add the triangle (v1, v2, v3) to the list --> Add vertexs (if needed) and faces!!!
+void SpherePointCloud::InsertInSpatialHash(unsigned int pIndex)
+{
+    const glm::vec3 & v = mVertices.at(pIndex);
+    quint64 key = VertexCellKey( VertexCell(v.x), VertexCell(v.y), VertexCell(v.z) );
+    Q_ASSERT( (int)pIndex == mNextVertexInCell.size() );
+    mNextVertexInCell.push_back( mVertexCells.value(key, -1) );
+    mVertexCells.insert(key, pIndex);
+}
 
-    if( FindSphereCloudVertex( pV1, pos ) )
-    {
-        // Vertex finded at position pos --> Only the index of the face is added
-        mFaces.push_back( pos );
-    }
-    else
-    {
-        // Add the vertex and the index of the face
-        mVertices.push_back( pV1 );
-        mNormals.push_back( pV1 );
-        mFaces.push_back( mVertices.size() - 1 );
-    }
+void SpherePointCloud::AddSphereCloudTriangle(unsigned int pV1, unsigned int pV2, unsigned int pV3)
+{
+    mFaces.push_back( pV1 );
+    mFaces.push_back( pV2 );
+    mFaces.push_back( pV3 );
+}
 
-    if( FindSphereCloudVertex( pV2, pos ) )
-    {
-        // Vertex finded at position pos --> Only the index of the face is added
-        mFaces.push_back( pos );
-    }
-    else
-    {
-        // Add the vertex and the index of the face
-        mVertices.push_back( pV2 );
-        mNormals.push_back( pV2 );
-        mFaces.push_back( mVertices.size() - 1 );
-    }
+void SpherePointCloud::CreateSphereCloudTriangle(const glm::vec3 & pV1, const glm::vec3 & pV2, const glm::vec3 & pV3)
+{
+    unsigned int pos;
 
-    if( FindSphereCloudVertex( pV3, pos ) )
+    // Add the triangle (v1, v2, v3) to the list --> Add vertexs (if needed) and faces!!!
+    const glm::vec3* vertices[3] = { &pV1, &pV2, &pV3 };
+    for( int i = 0; i < 3; i++ )
     {
-        // Vertex finded at position pos --> Only the index of the face is added
+        if( !FindSphereCloudVertex( *vertices[i], pos ) )
+        {
+            pos = AddSphereCloudVertex( *vertices[i] );
+        }
         mFaces.push_back( pos );
     }
-    else
-    {
-        // Add the vertex and the index of the face
-        mVertices.push_back( pV3 );
-        mNormals.push_back( pV3 );
-        mFaces.push_back( mVertices.size() - 1 );
-    }
 }
 
 /**
@@ -344,5 +607,10 @@ void SpherePointCloud::SetMeshInformation()
         mMesh->SetIndexsData(mFaces.size(), mFaces.data());
         mMesh->SetTopology(Geometry::Triangles);
     }
+    else
+    {
+        mMesh->SetIndexsData(0, NULL);
+        mMesh->SetTopology(Geometry::Points);
+    }
     mMesh->ComputeBoundingVolumes();
 }
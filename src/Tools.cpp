@@ -235,6 +235,19 @@ float Tools::TriangleArea(const glm::vec3& pA, const glm::vec3& pB, const glm::v
     return glm::length(v) / 2.0f;
 }
 
+float Tools::VanDerCorput(int pI, int pBase)
+{
+    float prec = 1.0f / (float)pBase;
+    float f = 0.0f;
+    while(pI != 0)
+    {
+        f += (float)(prec * (pI % pBase));
+        pI /= pBase;
+        prec /= pBase;
+    }
+    return f;
+}
+
 QString Tools::GetProgramPath()
 {
     QString picturesPath, completePath;
@@ -258,3 +271,64 @@ QString Tools::GetProgramPath()
     }
     return completePath;
 }
+
+bool Tools::ParseFloat(const char*& pText, const char* pEnd, float& pValue)
+{
+    const char* text = pText;
+    bool negative = false;
+    if( text < pEnd && ( *text == '-' || *text == '+' ) )
+    {
+        negative = ( *text == '-' );
+        text++;
+    }
+    double value = 0.0;
+    int digits = 0;
+    while( text < pEnd && *text >= '0' && *text <= '9' )
+    {
+        value = value * 10.0 + ( *text - '0' );
+        text++;
+        digits++;
+    }
+    if( text < pEnd && *text == '.' )
+    {
+        text++;
+        double scale = 0.1;
+        while( text < pEnd && *text >= '0' && *text <= '9' )
+        {
+            value += ( *text - '0' ) * scale;
+            scale *= 0.1;
+            text++;
+            digits++;
+        }
+    }
+    if( digits == 0 )
+    {
+        return false;
+    }
+    if( text < pEnd && ( *text == 'e' || *text == 'E' ) )
+    {
+        const char* exponentText = text + 1;
+        bool negativeExponent = false;
+        if( exponentText < pEnd && ( *exponentText == '-' || *exponentText == '+' ) )
+        {
+            negativeExponent = ( *exponentText == '-' );
+            exponentText++;
+        }
+        int exponent = 0;
+        int exponentDigits = 0;
+        while( exponentText < pEnd && *exponentText >= '0' && *exponentText <= '9' )
+        {
+            exponent = glm::min( exponent * 10 + ( *exponentText - '0' ), 1000 );
+            exponentText++;
+            exponentDigits++;
+        }
+        if( exponentDigits > 0 )
+        {
+            value *= pow( 10.0, negativeExponent ? -exponent : exponent );
+            text = exponentText;
+        }
+    }
+    pValue = (float)( negative ? -value : value );
+    pText = text;
+    return true;
+}
@@ -1,20 +1,388 @@
 //Definition include
 #include "ViewpointsMesh.h"
 
+//System includes
+#include <math.h>
+#include <string.h>
+
 //Dependency includes
+#include "glm/common.hpp"
 #include "glm/geometric.hpp"
 #include "glm/trigonometric.hpp"
 
 //Qt includes
 #include <QFile>
-#include <QTextStream>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTime>
 #include <QXmlStreamReader>
 
 //Project includes
 #include "PerspectiveCamera.h"
 #include "OrthographicCamera.h"
 #include "Debug.h"
-#include "SpherePointCloud.h"
+#include "Tools.h"
+
+/// Identification of the binary files of viewpoints, the version has to change if the format changes
+const quint32 VIEWPOINTS_MAGIC = 0x51565042;
+const quint32 VIEWPOINTS_VERSION = 1;
+/// Minimum size in bytes of the part of a text file parsed by every task of the thread pool
+const int TEXT_BYTES_PER_TASK = 1 << 20;
+
+/// Pose of a camera given by its center and the corners of its image
+struct ViewpointPose
+{
+    glm::vec3 center;
+    glm::vec3 upperLeft;
+    glm::vec3 upperRight;
+    glm::vec3 lowerRight;
+    glm::vec3 lowerLeft;
+};
+
+static void SkipSpaces(const char*& pText, const char* pEnd)
+{
+    while( pText < pEnd && ( *pText == ' ' || *pText == '\t' || *pText == '\r' ) )
+    {
+        pText++;
+    }
+}
+
+/// Parse a line "image, 15 coordinates" separated by commas, return false if it does not have this format
+static bool ParsePoseLine(const char* pBegin, const char* pEnd, QString& pName, ViewpointPose& pPose)
+{
+    const char* comma = (const char*)memchr( pBegin, ',', pEnd - pBegin );
+    if( comma == NULL )
+    {
+        return false;
+    }
+    pName = QString::fromUtf8( pBegin, comma - pBegin ).trimmed();
+
+    float coordinates[15];
+    const char* text = comma + 1;
+    for( int i = 0; i < 15; i++ )
+    {
+        SkipSpaces(text, pEnd);
+        if( !Tools::ParseFloat(text, pEnd, coordinates[i]) )
+        {
+            return false;
+        }
+        SkipSpaces(text, pEnd);
+        if( i < 14 )
+        {
+            if( text == pEnd || *text != ',' )
+            {
+                return false;
+            }
+            text++;
+        }
+    }
+    if( text != pEnd )
+    {
+        return false;
+    }
+    pPose.center = glm::vec3( coordinates[0], coordinates[1], coordinates[2] );
+    pPose.upperLeft = glm::vec3( coordinates[3], coordinates[4], coordinates[5] );
+    pPose.upperRight = glm::vec3( coordinates[6], coordinates[7], coordinates[8] );
+    pPose.lowerRight = glm::vec3( coordinates[9], coordinates[10], coordinates[11] );
+    pPose.lowerLeft = glm::vec3( coordinates[12], coordinates[13], coordinates[14] );
+    return true;
+}
+
+/// Parse the lines in [pBegin, pEnd) counting the ones that do not have the expected format in \param pErrors
+static void ParseTextPoses(const char* pBegin, const char* pEnd, QVector< ViewpointPose >& pPoses, QVector< QString >& pNames, int& pErrors)
+{
+    const char* line = pBegin;
+    while( line < pEnd )
+    {
+        const char* lineEnd = (const char*)memchr( line, '\n', pEnd - line );
+        if( lineEnd == NULL )
+        {
+            lineEnd = pEnd;
+        }
+        const char* text = line;
+        SkipSpaces(text, lineEnd);
+        if( text < lineEnd )
+        {
+            QString name;
+            ViewpointPose pose;
+            if( ParsePoseLine(line, lineEnd, name, pose) )
+            {
+                pPoses.push_back(pose);
+                pNames.push_back(name);
+            }
+            else
+            {
+                pErrors++;
+            }
+        }
+        line = lineEnd + 1;
+    }
+}
+
+/// Task of the thread pool that parses a range of complete lines of a text file
+class ViewpointsTextTask : public QRunnable
+{
+public:
+    ViewpointsTextTask(const char* pBegin, const char* pEnd, QVector< ViewpointPose >* pPoses, QVector< QString >* pNames, int* pErrors):
+        mBegin(pBegin), mEnd(pEnd), mPoses(pPoses), mNames(pNames), mErrors(pErrors)
+    {
+
+    }
+
+    void run()
+    {
+        ParseTextPoses(mBegin, mEnd, *mPoses, *mNames, *mErrors);
+    }
+
+private:
+    const char* mBegin;
+    const char* mEnd;
+    QVector< ViewpointPose >* mPoses;
+    QVector< QString >* mNames;
+    int* mErrors;
+};
+
+/// Read a text file with a header line and a line per viewpoint, the file is split in ranges of lines parsed in parallel
+static void ReadTextPoses(QFile& pFile, QVector< ViewpointPose >& pPoses, QVector< QString >& pNames)
+{
+    qint64 size = pFile.size();
+    const char* data = (const char*)pFile.map(0, size);
+    QByteArray contents;
+    if( data == NULL && size > 0 )
+    {
+        contents = pFile.readAll();
+        data = contents.constData();
+        size = contents.size();
+    }
+    const char* end = data + size;
+
+    //Reading the header
+    const char* begin = ( size > 0 ) ? (const char*)memchr( data, '\n', size ) : NULL;
+    begin = ( begin == NULL ) ? end : begin + 1;
+
+    //Every range ends at the end of a line
+    QVector< const char* > limits;
+    limits.push_back(begin);
+    int numberOfTasks = glm::max( 1, glm::min( QThread::idealThreadCount() * 4, (int)( ( end - begin ) / TEXT_BYTES_PER_TASK ) ) );
+    qint64 bytesPerTask = ( end - begin ) / numberOfTasks;
+    for( int i = 1; i < numberOfTasks; i++ )
+    {
+        const char* limit = glm::max( limits.last(), begin + i * bytesPerTask );
+        const char* lineEnd = (const char*)memchr( limit, '\n', end - limit );
+        limits.push_back( ( lineEnd == NULL ) ? end : lineEnd + 1 );
+    }
+    limits.push_back(end);
+
+    QVector< QVector< ViewpointPose > > poses(numberOfTasks);
+    QVector< QVector< QString > > names(numberOfTasks);
+    QVector< int > errors(numberOfTasks, 0);
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount( QThread::idealThreadCount() );
+    for( int i = 0; i < numberOfTasks; i++ )
+    {
+        threadPool.start( new ViewpointsTextTask( limits.at(i), limits.at(i + 1), poses.data() + i, names.data() + i, errors.data() + i ) );
+    }
+    threadPool.waitForDone();
+
+    int numberOfErrors = 0;
+    for( int i = 0; i < numberOfTasks; i++ )
+    {
+        pPoses += poses.at(i);
+        pNames += names.at(i);
+        numberOfErrors += errors.at(i);
+    }
+    if( numberOfErrors > 0 )
+    {
+        Debug::Error( QString("File format unexpected in %1 lines!").arg(numberOfErrors) );
+    }
+    if( contents.isEmpty() )
+    {
+        pFile.unmap( (uchar*)data );
+    }
+}
+
+/// Read an xml file with a viewpoint element per image and an element with the coordinates of its center and every corner.
+/// The viewpoints without all the points or with coordinates that are not numbers are discarded like malformed text lines.
+static void ReadXmlPoses(QFile& pFile, const QString& pFileName, QVector< ViewpointPose >& pPoses, QVector< QString >& pNames)
+{
+    QXmlStreamReader xmlReader(&pFile);
+    int numberOfErrors = 0;
+    if( xmlReader.readNextStartElement() && xmlReader.name() == QLatin1String("viewpoints") )
+    {
+        while( xmlReader.readNextStartElement() )
+        {
+            if( xmlReader.name() == QLatin1String("viewpoint") )
+            {
+                QString image = xmlReader.attributes().value("image").toString();
+
+                ViewpointPose pose = ViewpointPose();
+                bool center = false, upperLeft = false, upperRight = false, lowerRight = false, lowerLeft = false;
+                bool valid = true;
+                while( xmlReader.readNextStartElement() )
+                {
+                    QXmlStreamAttributes attributes = xmlReader.attributes();
+                    bool validX, validY, validZ;
+                    glm::vec3 point( attributes.value("x").toFloat(&validX), attributes.value("y").toFloat(&validY), attributes.value("z").toFloat(&validZ) );
+
+                    QStringRef name = xmlReader.name();
+                    bool known = true;
+                    if( name == QLatin1String("center") )
+                    {
+                        pose.center = point;
+                        center = true;
+                    }
+                    else if( name == QLatin1String("ul") )
+                    {
+                        pose.upperLeft = point;
+                        upperLeft = true;
+                    }
+                    else if( name == QLatin1String("ur") )
+                    {
+                        pose.upperRight = point;
+                        upperRight = true;
+                    }
+                    else if( name == QLatin1String("lr") )
+                    {
+                        pose.lowerRight = point;
+                        lowerRight = true;
+                    }
+                    else if( name == QLatin1String("ll") )
+                    {
+                        pose.lowerLeft = point;
+                        lowerLeft = true;
+                    }
+                    else
+                    {
+                        known = false;
+                    }
+                    if( known && !( validX && validY && validZ ) )
+                    {
+                        valid = false;
+                    }
+                    xmlReader.skipCurrentElement();
+                }
+
+                if( valid && center && upperLeft && upperRight && lowerRight && lowerLeft )
+                {
+                    pPoses.push_back(pose);
+                    pNames.push_back(image);
+                }
+                else
+                {
+                    numberOfErrors++;
+                }
+            }
+            else
+            {
+                xmlReader.skipCurrentElement();
+            }
+        }
+    }
+    if( numberOfErrors > 0 )
+    {
+        Debug::Error( QString("Incomplete viewpoints in %1: %2 discarded!").arg(pFileName).arg(numberOfErrors) );
+    }
+    if( xmlReader.hasError() )
+    {
+        Debug::Error(QString("[Line: %1, Column:%2] Error in LoadViewpointsFromFile - GeneralError file %3: %4, error: %5").arg(xmlReader.lineNumber()).arg(xmlReader.columnNumber()).arg(pFileName).arg(xmlReader.errorString()).arg(xmlReader.error()));
+    }
+}
+
+/// Read a binary file: magic, version, number of viewpoints, their poses and their names as a size and UTF-8 bytes
+static void ReadBinaryPoses(QFile& pFile, const QString& pFileName, QVector< ViewpointPose >& pPoses, QVector< QString >& pNames)
+{
+    QByteArray contents;
+    qint64 size = pFile.size();
+    const uchar* data = pFile.map(0, size);
+    if( data == NULL )
+    {
+        contents = pFile.readAll();
+        data = (const uchar*)contents.constData();
+        size = contents.size();
+    }
+    const uchar* end = data + size;
+
+    quint32 header[3] = { 0, 0, 0 };
+    bool valid = ( size >= (qint64)sizeof(header) );
+    if( valid )
+    {
+        memcpy( header, data, sizeof(header) );
+        valid = ( header[0] == VIEWPOINTS_MAGIC && header[1] == VIEWPOINTS_VERSION && (qint64)header[2] <= ( size - (qint64)sizeof(header) ) / (qint64)sizeof(ViewpointPose) );
+    }
+    const uchar* text = data + sizeof(header);
+    if( valid )
+    {
+        int numberOfViewpoints = header[2];
+        pPoses.resize(numberOfViewpoints);
+        memcpy( pPoses.data(), text, numberOfViewpoints * sizeof(ViewpointPose) );
+        text += numberOfViewpoints * sizeof(ViewpointPose);
+        pNames.reserve(numberOfViewpoints);
+        for( int i = 0; i < numberOfViewpoints && valid; i++ )
+        {
+            quint32 length = 0;
+            valid = ( end - text >= (qint64)sizeof(length) );
+            if( valid )
+            {
+                memcpy( &length, text, sizeof(length) );
+                text += sizeof(length);
+                valid = ( (quint32)( end - text ) >= length );
+            }
+            if( valid )
+            {
+                pNames.push_back( QString::fromUtf8( (const char*)text, length ) );
+                text += length;
+            }
+        }
+    }
+    if( !valid )
+    {
+        Debug::Error( QString("Invalid binary file with viewpoints: %1").arg(pFileName) );
+        pPoses.clear();
+        pNames.clear();
+    }
+    if( contents.isEmpty() )
+    {
+        pFile.unmap( (uchar*)data );
+    }
+}
+
+/// Read the poses of \param pFileName by its extension, return false if the file can not be opened
+static bool ReadPoses(const QString& pFileName, QVector< ViewpointPose >& pPoses, QVector< QString >& pNames)
+{
+    QFile file(pFileName);
+    if( !file.open(QIODevice::ReadOnly) )
+    {
+        if(!file.exists())
+        {
+            Debug::Error(QString("File with viewpoints not found: %1").arg(pFileName));
+        }
+        else
+        {
+            Debug::Error(QString("Impossible to open file with viewpoints: %1").arg(pFileName));
+        }
+        return false;
+    }
+
+    if( pFileName.endsWith( QString("xml"), Qt::CaseInsensitive ) )
+    {
+        ReadXmlPoses(file, pFileName, pPoses, pNames);
+    }
+    else if( pFileName.endsWith( QString("txt"), Qt::CaseInsensitive ) )
+    {
+        ReadTextPoses(file, pPoses, pNames);
+    }
+    else if( pFileName.endsWith( QString("vpb"), Qt::CaseInsensitive ) )
+    {
+        ReadBinaryPoses(file, pFileName, pPoses, pNames);
+    }
+    else
+    {
+        Debug::Warning( "Unknown file format!" );
+    }
+    file.close();
+    return true;
+}
 
 ViewpointsMesh::ViewpointsMesh(const QVector< Camera * >& pCameras)
 {
@@ -32,17 +400,15 @@ ViewpointsMesh::ViewpointsMesh(const QVector< Camera * >& pCameras)
     mMesh->ComputeBoundingVolumes();
 
     mNeighbours.resize(numberOfViewpoints);
+    mKdTree = new KdTree(mVertices);
+    mCamerasGizmo = NULL;
 }
 
-ViewpointsMesh::ViewpointsMesh(const glm::vec3& pCenter, float pRadius, float pAngle, float pAspectRatio, int pSubdivision)
+ViewpointsMesh::ViewpointsMesh(const SpherePointCloud& pSphere, const glm::vec3& pCenter, float pRadius, float pAngle, float pAspectRatio)
 {
     mMesh = new Geometry( "Sphere of viewpoints", Geometry::Points );
 
-    //Creaci de l'esfera de punts de vista
-    SpherePointCloud sphere;
-    sphere.SetToQuasiUniform(pSubdivision);
-
-    mVertices = sphere.GetVertices();
+    mVertices = pSphere.GetVertices();
     int numberOfViewpoints = mVertices.size();
     mCameras.resize(numberOfViewpoints);
     for( int i = 0; i < numberOfViewpoints; i++ )
@@ -54,12 +420,12 @@ ViewpointsMesh::ViewpointsMesh(const glm::vec3& pCenter, float pRadius, float pA
     mMesh->SetVerticesData( numberOfViewpoints, mVertices.data() );
     mMesh->ComputeBoundingVolumes();
 
-    SetFaces( sphere.GetFaces() );
+    SetFaces( pSphere.GetFaces() );
 
     mNeighbours.resize(numberOfViewpoints);
     for( int i = 0; i < numberOfViewpoints; i++ )
     {
-        QVector<int> neigh = sphere.GetNeighbours(i);
+        QVector<int> neigh = pSphere.GetNeighbours(i);
         int numberOfNeighbours = neigh.size();
         mNeighbours[i].resize(numberOfNeighbours);
         for( int j = 0; j < numberOfNeighbours; j++ )
@@ -67,145 +433,56 @@ ViewpointsMesh::ViewpointsMesh(const glm::vec3& pCenter, float pRadius, float pA
             mNeighbours[i][j] = neigh.at(j);
         }
     }
+    mKdTree = new KdTree(mVertices);
+    mCamerasGizmo = NULL;
 }
 
 ViewpointsMesh::ViewpointsMesh(const glm::vec3& pCenter, float pRadius, const QString& pFileName)
 {
-    QFile file(pFileName);
+    QTime t;
+    t.start();
 
-    if( file.open(QIODevice::ReadOnly | QIODevice::Text) )
+    QVector< ViewpointPose > poses;
+    QVector< QString > imageNames;
+    if( ReadPoses(pFileName, poses, imageNames) )
     {
-        QVector< glm::vec3 > centerPoints;
-        QVector< glm::vec3 > upperLeftPoints;
-        QVector< glm::vec3 > upperRightPoints;
-        QVector< glm::vec3 > lowerLeftPoints;
-        QVector< glm::vec3 > lowerRightPoints;
-        QVector< QString > imageNames;
-
         mMesh = new Geometry( "Viewpoints from file", Geometry::Points );
 
-        //Fitxer xml
-        if( pFileName.endsWith( QString("xml"), Qt::CaseInsensitive ) )
-        {
-            QXmlStreamReader * xmlReader = new QXmlStreamReader(&file);
-            if( xmlReader->readNextStartElement() )
-            {
-                if( xmlReader->name() == "viewpoints" )
-                {
-                    while( xmlReader->readNextStartElement() )
-                    {
-                        if( xmlReader->name() == "viewpoint" )
-                        {
-                            imageNames.push_back( xmlReader->attributes().value("image").toString() );
-
-                            while( xmlReader->readNextStartElement() )
-                            {
-                                glm::vec3 point;
-
-                                point.x = xmlReader->attributes().value("x").toString().toFloat();
-                                point.y = xmlReader->attributes().value("y").toString().toFloat();
-                                point.z = xmlReader->attributes().value("z").toString().toFloat();
-
-                                if(xmlReader->name() == "center")
-                                {
-                                    centerPoints.push_back(point);
-                                }
-                                else if(xmlReader->name() == "ul")
-                                {
-                                    upperLeftPoints.push_back(point);
-                                }
-                                else if(xmlReader->name() == "ur")
-                                {
-                                    upperRightPoints.push_back(point);
-                                }
-                                else if(xmlReader->name() == "lr")
-                                {
-                                    lowerRightPoints.push_back(point);
-                                }
-                                else if(xmlReader->name() == "ll")
-                                {
-                                    lowerLeftPoints.push_back(point);
-                                }
-                            }
-                        }
-                    }
-
-                }
-            }
-            if (xmlReader->hasError())
-            {
-                Debug::Error(QString("[Line: %1, Column:%2] Error in LoadViewpointsFromFile - GeneralError file %3: %4, error: %5").arg(xmlReader->lineNumber()).arg(xmlReader->columnNumber()).arg(pFileName).arg(xmlReader->errorString()).arg(xmlReader->error()));
-            }
-
-            delete xmlReader;
-        }
-        else if( pFileName.endsWith( QString("txt"), Qt::CaseInsensitive ) )
-        {
-            QTextStream * textReader = new QTextStream(&file);
-
-            //Reading the header
-            textReader->readLine();
-            while( !textReader->atEnd() )
-            {
-                QString line = textReader->readLine();
-                QStringList list = line.split(QRegExp("\\s*,\\s*"));
-                if( list.size() == 16 )
-                {
-                    imageNames.push_back( list.at(0) );
-
-                    centerPoints.push_back( glm::vec3( list.at(1).toFloat(), list.at(2).toFloat(), list.at(3).toFloat() ) );
-                    upperLeftPoints.push_back( glm::vec3( list.at(4).toFloat(), list.at(5).toFloat(), list.at(6).toFloat() ) );
-                    upperRightPoints.push_back( glm::vec3( list.at(7).toFloat(), list.at(8).toFloat(), list.at(9).toFloat() ) );
-                    lowerRightPoints.push_back( glm::vec3( list.at(10).toFloat(), list.at(11).toFloat(), list.at(12).toFloat() ) );
-                    lowerLeftPoints.push_back( glm::vec3( list.at(13).toFloat(), list.at(14).toFloat(), list.at(15).toFloat() ) );
-                }
-                else
-                {
-                    Debug::Error( "File format unexpected!" );
-                }
-
-            }
-        }
-        else
-        {
-            Debug::Warning( "Unknown file format!" );
-        }
-        file.close();
         int numberOfViewpoints = imageNames.size();
+        bool verbose = ( Debug::GetVerbosity() >= Debug::Verbose );
         mCameras.resize(numberOfViewpoints);
         mVertices.resize(numberOfViewpoints);
         for( int i = 0; i < numberOfViewpoints; i++ )
         {
-            glm::vec3 leftPoint = ( ( upperLeftPoints.at(i) - lowerLeftPoints.at(i) ) / 2.0f ) + lowerLeftPoints.at(i);
-            glm::vec3 rightPoint = ( ( upperRightPoints.at(i) - lowerRightPoints.at(i) ) / 2.0f ) + lowerRightPoints.at(i);
-            glm::vec3 lookAtPoint = ( ( lowerRightPoints.at(i) - lowerLeftPoints.at(i) ) / 2.0f ) + leftPoint;
-            float aspectRatio = glm::length( lowerRightPoints.at(i) - lowerLeftPoints.at(i) ) / glm::length( upperRightPoints.at(i) - lowerRightPoints.at(i) );
-            glm::vec3 v1 = rightPoint - centerPoints.at(i);
-            glm::vec3 v2 = leftPoint - centerPoints.at(i);
+            const ViewpointPose& pose = poses.at(i);
+            glm::vec3 leftPoint = ( ( pose.upperLeft - pose.lowerLeft ) / 2.0f ) + pose.lowerLeft;
+            glm::vec3 rightPoint = ( ( pose.upperRight - pose.lowerRight ) / 2.0f ) + pose.lowerRight;
+            glm::vec3 lookAtPoint = ( ( pose.lowerRight - pose.lowerLeft ) / 2.0f ) + leftPoint;
+            float aspectRatio = glm::length( pose.lowerRight - pose.lowerLeft ) / glm::length( pose.upperRight - pose.lowerRight );
+            glm::vec3 v1 = rightPoint - pose.center;
+            glm::vec3 v2 = leftPoint - pose.center;
             float angle = glm::degrees( glm::acos( glm::dot( v1, v2 ) / ( glm::length( v1 ) * glm::length( v2 ) ) ) );
 
-            Debug::Log( QString("Image number: %1, Aspect ratio: %2, Angle: %3, Center: (%4, %5, %6)").arg(imageNames.at(i)).arg(aspectRatio).arg(angle).arg(centerPoints.at(i).x).arg(centerPoints.at(i).y).arg(centerPoints.at(i).z) );
-            mCameras[i] = new PerspectiveCamera( 0.05f * pRadius, pRadius * 2.0f + glm::length( pCenter - centerPoints.at(i) ), lookAtPoint, glm::cross( v1, v2 ), centerPoints.at(i), angle / aspectRatio, aspectRatio );
+            if( verbose )
+            {
+                Debug::Log( QString("Image number: %1, Aspect ratio: %2, Angle: %3, Center: (%4, %5, %6)").arg(imageNames.at(i)).arg(aspectRatio).arg(angle).arg(pose.center.x).arg(pose.center.y).arg(pose.center.z) );
+            }
+            mCameras[i] = new PerspectiveCamera( 0.05f * pRadius, pRadius * 2.0f + glm::length( pCenter - pose.center ), lookAtPoint, glm::cross( v1, v2 ), pose.center, angle / aspectRatio, aspectRatio );
             mCameras.at(i)->mName = imageNames.at(i);
-            mVertices[i] = centerPoints.at(i);
+            mVertices[i] = pose.center;
         }
         mMesh->SetVerticesData( numberOfViewpoints, mVertices.data() );
         mMesh->ComputeBoundingVolumes();
 
         mNeighbours.resize(numberOfViewpoints);
+        Debug::Log( QString("ViewpointsMesh - %1 viewpoints read from %2 in %3 ms").arg(numberOfViewpoints).arg(pFileName).arg(t.elapsed()) );
     }
     else
     {
-        if(!file.exists())
-        {
-            Debug::Error(QString("File with viewpoints not found: %1").arg(pFileName));
-        }
-        else
-        {
-            Debug::Error(QString("Impossible to open file with viewpoints: %1").arg(pFileName));
-        }
         mMesh = NULL;
     }
+    mKdTree = new KdTree(mVertices);
+    mCamerasGizmo = NULL;
 }
 
 ViewpointsMesh::ViewpointsMesh(const ViewpointsMesh& pViewpointsMesh)
@@ -228,6 +505,8 @@ ViewpointsMesh::ViewpointsMesh(const ViewpointsMesh& pViewpointsMesh)
         mCameras[i] = camera->Clone();
     }
     mFaces = pViewpointsMesh.mFaces;
+    mKdTree = new KdTree(mVertices);
+    mCamerasGizmo = NULL;
 }
 
 ViewpointsMesh::~ViewpointsMesh()
@@ -237,6 +516,8 @@ ViewpointsMesh::~ViewpointsMesh()
         delete mCameras[i];
     }
     delete mMesh;
+    delete mKdTree;
+    delete mCamerasGizmo;
 }
 
 void ViewpointsMesh::SetCameras( const QVector< Camera * >& pCameras )
@@ -250,6 +531,12 @@ void ViewpointsMesh::SetCameras( const QVector< Camera * >& pCameras )
     }
     mMesh->SetVerticesData( mVertices.size(), mVertices.data() );
     mMesh->ComputeBoundingVolumes();
+    delete mKdTree;
+    mKdTree = new KdTree(mVertices);
+    if( mCamerasGizmo != NULL )
+    {
+        mCamerasGizmo->SetCameras(mCameras);
+    }
 }
 
 void ViewpointsMesh::SetNeighbours( const QVector< QVector< int > >& pNeighbours )
@@ -276,6 +563,43 @@ void ViewpointsMesh::SetFaces( const QVector< unsigned int >& pFaces )
     mMesh->SetTopology( Geometry::Triangles );
 }
 
+bool ViewpointsMesh::ConvertToBinary(const QString& pFileName, const QString& pBinaryFileName)
+{
+    QVector< ViewpointPose > poses;
+    QVector< QString > imageNames;
+    if( !ReadPoses(pFileName, poses, imageNames) )
+    {
+        return false;
+    }
+
+    QFile file(pBinaryFileName);
+    if( !file.open(QFile::WriteOnly) )
+    {
+        Debug::Error( QString("Impossible to write %1").arg(pBinaryFileName) );
+        return false;
+    }
+    quint32 header[3] = { VIEWPOINTS_MAGIC, VIEWPOINTS_VERSION, (quint32)poses.size() };
+    file.write( (const char*)header, sizeof(header) );
+    file.write( (const char*)poses.constData(), poses.size() * sizeof(ViewpointPose) );
+    for( int i = 0; i < imageNames.size(); i++ )
+    {
+        QByteArray name = imageNames.at(i).toUtf8();
+        quint32 length = name.size();
+        file.write( (const char*)&length, sizeof(length) );
+        file.write(name);
+    }
+    bool written = ( file.error() == QFile::NoError );
+    file.close();
+    if( !written )
+    {
+        Debug::Error( QString("Impossible to write %1").arg(pBinaryFileName) );
+        QFile::remove(pBinaryFileName);
+        return false;
+    }
+    Debug::Log( QString("%1 viewpoints of %2 written into %3").arg(poses.size()).arg(pFileName).arg(pBinaryFileName) );
+    return true;
+}
+
 Camera* ViewpointsMesh::GetViewpoint( int pIndex ) const
 {
     return mCameras.at(pIndex);
@@ -283,20 +607,17 @@ Camera* ViewpointsMesh::GetViewpoint( int pIndex ) const
 
 int ViewpointsMesh::GetNearestViewpoint( const glm::vec3& pPoint ) const
 {
-    int nearest;
+    return mKdTree->GetNearest(pPoint);
+}
 
-    float minDistance = FLT_MAX;
-    for( int i = 0; i < mVertices.size(); i++ )
-    {
-        float distance = glm::distance( pPoint, mVertices.at(i) );
-        if( distance < minDistance )
-        {
-            minDistance = distance;
-            nearest = i;
-        }
-    }
+QVector< int > ViewpointsMesh::GetNearestViewpoints( const glm::vec3& pPoint, int pNumberOfViewpoints ) const
+{
+    return mKdTree->GetKNearest(pPoint, pNumberOfViewpoints);
+}
 
-    return nearest;
+QVector< int > ViewpointsMesh::GetViewpointsInRadius( const glm::vec3& pPoint, float pRadius ) const
+{
+    return mKdTree->GetInRadius(pPoint, pRadius);
 }
 
 int ViewpointsMesh::GetNumberOfViewpoints() const
@@ -324,6 +645,20 @@ Geometry* ViewpointsMesh::GetMesh() const
     return mMesh;
 }
 
+Geometry* ViewpointsMesh::GetCamerasMesh()
+{
+    if( mCamerasGizmo == NULL )
+    {
+        mCamerasGizmo = new CameraGizmo(mCameras);
+    }
+    return mCamerasGizmo->GetMesh();
+}
+
+bool ViewpointsMesh::HasCamerasMesh() const
+{
+    return mCamerasGizmo != NULL;
+}
+
 QVector< glm::vec3 > ViewpointsMesh::GetVertices() const
 {
     return mVertices;
@@ -1,6 +1,9 @@
 //Definition include
 #include "AxisAlignedBoundingBox.h"
 
+//Dependency includes
+#include "glm/vec4.hpp"
+
 //Project includes
 #include "Geometry.h"
 
@@ -37,6 +40,36 @@ glm::vec3 AxisAlignedBoundingBox::GetMax() const
     return mMax;
 }
 
+bool AxisAlignedBoundingBox::Intersects(const glm::mat4& pViewProjection) const
+{
+    //The box is outside if all its corners are on the outer side of the same clipping plane
+    int outside[6] = { 0, 0, 0, 0, 0, 0 };
+    for( int i = 0; i < 8; i++ )
+    {
+        glm::vec4 corner( ( i & 1 ) ? mMax.x : mMin.x, ( i & 2 ) ? mMax.y : mMin.y, ( i & 4 ) ? mMax.z : mMin.z, 1.0f );
+        glm::vec4 clip = pViewProjection * corner;
+        for( int axis = 0; axis < 3; axis++ )
+        {
+            if( clip[axis] < -clip.w )
+            {
+                outside[axis * 2]++;
+            }
+            if( clip[axis] > clip.w )
+            {
+                outside[axis * 2 + 1]++;
+            }
+        }
+    }
+    for( int i = 0; i < 6; i++ )
+    {
+        if( outside[i] == 8 )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 AxisAlignedBoundingBox* AxisAlignedBoundingBox::Merge(AxisAlignedBoundingBox* pAABB0, AxisAlignedBoundingBox* pAABB1)
 {
     glm::vec3 newMin, newMax;
@@ -48,35 +48,11 @@ BoundingSphere* BoundingSphere::Merge(const BoundingSphere *pBS0, const Bounding
 
     if( pBS0 != NULL && pBS1 != NULL )
     {
-        //Bibliography: 3D Game Engine Design: A Practical Approach to Real-Time Computer Graphics (p.149)
-        glm::vec3 C0 = pBS0->GetCenter();
-        glm::vec3 C1 = pBS1->GetCenter();
-        float r0 = pBS0->GetRadius();
-        float r1 = pBS1->GetRadius();
-        glm::vec3 centerDiff = C1 - C0;
-        float radiusDiff = r1 - r0;
-        float radiusDiffSqr = radiusDiff*radiusDiff;
-        float Lsqr = glm::length2(centerDiff);
-        if( radiusDiffSqr >= Lsqr )
-        {
-            if( radiusDiff >= 0.0f )
-            {
-                result->SetCenter(C1);
-                result->SetRadius(r1);
-            }
-            else
-            {
-                result->SetCenter(C0);
-                result->SetRadius(r0);
-            }
-        }
-        else
-        {
-            float L = glm::sqrt(Lsqr);
-            float t = ( L + r1 - r0 ) / ( 2.0f * L );
-            result->SetCenter( C0 + t * centerDiff );
-            result->SetRadius( ( L + r1 + r0 ) / 2.0f );
-        }
+        glm::vec3 center = pBS0->GetCenter();
+        float radius = pBS0->GetRadius();
+        Merge(center, radius, pBS1->GetCenter(), pBS1->GetRadius());
+        result->SetCenter(center);
+        result->SetRadius(radius);
     }
     else if( pBS0 != NULL )
     {
@@ -92,6 +68,30 @@ BoundingSphere* BoundingSphere::Merge(const BoundingSphere *pBS0, const Bounding
     return result;
 }
 
+void BoundingSphere::Merge(glm::vec3& pCenter, float& pRadius, const glm::vec3& pOtherCenter, float pOtherRadius)
+{
+    //Bibliography: 3D Game Engine Design: A Practical Approach to Real-Time Computer Graphics (p.149)
+    glm::vec3 centerDiff = pOtherCenter - pCenter;
+    float radiusDiff = pOtherRadius - pRadius;
+    float radiusDiffSqr = radiusDiff*radiusDiff;
+    float Lsqr = glm::length2(centerDiff);
+    if( radiusDiffSqr >= Lsqr )
+    {
+        if( radiusDiff >= 0.0f )
+        {
+            pCenter = pOtherCenter;
+            pRadius = pOtherRadius;
+        }
+    }
+    else
+    {
+        float L = glm::sqrt(Lsqr);
+        float t = ( L + pOtherRadius - pRadius ) / ( 2.0f * L );
+        pCenter += t * centerDiff;
+        pRadius = ( L + pOtherRadius + pRadius ) / 2.0f;
+    }
+}
+
 void BoundingSphere::CreateMesh()
 {
     /// Resolution used to render the bounding sphere
@@ -0,0 +1,325 @@
+//Definition include
+#include "BoundingVolumeHierarchy.h"
+
+//System includes
+#include <float.h>
+
+//Dependency includes
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+
+//Project includes
+#include "Debug.h"
+
+/// Number of bins used to evaluate the surface area heuristic
+const int NUMBER_OF_BINS = 16;
+/// Leaves with this number of triangles or less are not split
+const int MIN_LEAF_SIZE = 2;
+/// Leaves are split while the surface area heuristic prefers it or they have more triangles than this
+const int MAX_LEAF_SIZE = 8;
+/// Maximum depth of the hierarchy, it bounds the stack used by the traversal
+const int MAX_DEPTH = 64;
+
+static float SurfaceArea(const glm::vec3& pMin, const glm::vec3& pMax)
+{
+    glm::vec3 extent = glm::max(pMax - pMin, glm::vec3(0.0f));
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy(const Scene* pScene)
+{
+    int numberOfTriangles = pScene->GetNumberOfPolygons();
+    mVertices.reserve(numberOfTriangles * 3);
+    for( int i = 0; i < pScene->GetNumberOfMeshes(); i++ )
+    {
+        Geometry* currentMesh = pScene->GetMesh(i);
+        currentMesh->MakeResident();
+        int numberOfFaces = currentMesh->GetNumFaces();
+        if( currentMesh->GetTopology() == Geometry::Triangles )
+        {
+            for( int j = 0; j < numberOfFaces * 3; j++ )
+            {
+                mVertices.push_back( currentMesh->GetVertexByIndexPosition(j) );
+            }
+        }
+        else
+        {
+            //Degenerated triangles keep the polygon numbering and are never hit
+            Debug::Warning( "BoundingVolumeHierarchy only supports Triangles topology, other polygons are ignored" );
+            for( int j = 0; j < numberOfFaces * 3; j++ )
+            {
+                mVertices.push_back( glm::vec3(0.0f) );
+            }
+        }
+    }
+
+    mTriangleMin.resize(numberOfTriangles);
+    mTriangleMax.resize(numberOfTriangles);
+    mCentroids.resize(numberOfTriangles);
+    mTriangleOrder.resize(numberOfTriangles);
+    for( int i = 0; i < numberOfTriangles; i++ )
+    {
+        const glm::vec3& v0 = mVertices.at(i * 3);
+        const glm::vec3& v1 = mVertices.at(i * 3 + 1);
+        const glm::vec3& v2 = mVertices.at(i * 3 + 2);
+        mTriangleMin[i] = glm::min( v0, glm::min(v1, v2) );
+        mTriangleMax[i] = glm::max( v0, glm::max(v1, v2) );
+        mCentroids[i] = ( mTriangleMin.at(i) + mTriangleMax.at(i) ) * 0.5f;
+        mTriangleOrder[i] = i;
+    }
+
+    mNodes.reserve( glm::max(1, 2 * numberOfTriangles / MIN_LEAF_SIZE) );
+    Build(0, numberOfTriangles, 0);
+
+    //Only needed during the build
+    mTriangleMin.clear();
+    mTriangleMax.clear();
+    mCentroids.clear();
+    mNodes.squeeze();
+}
+
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+{
+
+}
+
+int BoundingVolumeHierarchy::GetNumberOfTriangles() const
+{
+    return mTriangleOrder.size();
+}
+
+glm::vec3 BoundingVolumeHierarchy::GetVertex(int pTriangle, int pVertex) const
+{
+    return mVertices.at(pTriangle * 3 + pVertex);
+}
+
+glm::vec3 BoundingVolumeHierarchy::GetNormal(int pTriangle) const
+{
+    const glm::vec3& v0 = mVertices.at(pTriangle * 3);
+    glm::vec3 normal = glm::cross( mVertices.at(pTriangle * 3 + 1) - v0, mVertices.at(pTriangle * 3 + 2) - v0 );
+    float length = glm::length(normal);
+    return ( length > 0.0f ) ? normal / length : normal;
+}
+
+int BoundingVolumeHierarchy::Intersect(const glm::vec3& pOrigin, const glm::vec3& pDirection, float pMaxDistance, int pIgnoredTriangle, float& pDistance) const
+{
+    int hit = -1;
+    if( mNodes.isEmpty() )
+    {
+        return hit;
+    }
+
+    glm::vec3 inverseDirection = 1.0f / pDirection;
+    const Node* nodes = mNodes.constData();
+    const int* triangleOrder = mTriangleOrder.constData();
+    float closest = pMaxDistance;
+
+    int stack[MAX_DEPTH * 2];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+    while( stackSize > 0 )
+    {
+        int currentNode = stack[--stackSize];
+        const Node& node = nodes[currentNode];
+
+        //Slab test against the bounding box of the node
+        glm::vec3 t0 = ( node.mMin - pOrigin ) * inverseDirection;
+        glm::vec3 t1 = ( node.mMax - pOrigin ) * inverseDirection;
+        glm::vec3 tNear = glm::min(t0, t1);
+        glm::vec3 tFar = glm::max(t0, t1);
+        float entry = glm::max( glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f) );
+        float exit = glm::min( glm::min(tFar.x, tFar.y), glm::min(tFar.z, closest) );
+        if( entry > exit )
+        {
+            continue;
+        }
+
+        if( node.mCount > 0 )
+        {
+            for( int i = node.mOffset; i < node.mOffset + node.mCount; i++ )
+            {
+                int triangle = triangleOrder[i];
+                if( triangle != pIgnoredTriangle )
+                {
+                    float distance = IntersectTriangle(triangle, pOrigin, pDirection);
+                    if( distance > 0.0f && distance < closest )
+                    {
+                        closest = distance;
+                        hit = triangle;
+                    }
+                }
+            }
+        }
+        else
+        {
+            //The nearest child is pushed the last to be visited first
+            if( pDirection[node.mAxis] < 0.0f )
+            {
+                stack[stackSize++] = currentNode + 1;
+                stack[stackSize++] = node.mOffset;
+            }
+            else
+            {
+                stack[stackSize++] = node.mOffset;
+                stack[stackSize++] = currentNode + 1;
+            }
+        }
+    }
+    if( hit != -1 )
+    {
+        pDistance = closest;
+    }
+    return hit;
+}
+
+void BoundingVolumeHierarchy::Build(int pFirst, int pCount, int pDepth)
+{
+    int nodeIndex = mNodes.size();
+    Node node;
+    node.mMin = glm::vec3(FLT_MAX);
+    node.mMax = glm::vec3(-FLT_MAX);
+    node.mOffset = pFirst;
+    node.mCount = pCount;
+    node.mAxis = 0;
+    glm::vec3 centroidMin(FLT_MAX);
+    glm::vec3 centroidMax(-FLT_MAX);
+    for( int i = pFirst; i < pFirst + pCount; i++ )
+    {
+        int triangle = mTriangleOrder.at(i);
+        node.mMin = glm::min( node.mMin, mTriangleMin.at(triangle) );
+        node.mMax = glm::max( node.mMax, mTriangleMax.at(triangle) );
+        centroidMin = glm::min( centroidMin, mCentroids.at(triangle) );
+        centroidMax = glm::max( centroidMax, mCentroids.at(triangle) );
+    }
+    mNodes.push_back(node);
+
+    glm::vec3 centroidExtent = centroidMax - centroidMin;
+    int axis = 0;
+    if( centroidExtent.y > centroidExtent[axis] )
+    {
+        axis = 1;
+    }
+    if( centroidExtent.z > centroidExtent[axis] )
+    {
+        axis = 2;
+    }
+    float extent = centroidExtent[axis];
+    if( pCount <= MIN_LEAF_SIZE || extent <= 0.0f || pDepth >= MAX_DEPTH - 1 )
+    {
+        return;
+    }
+
+    //Binned surface area heuristic along the axis with the largest centroid extent
+    int binCount[NUMBER_OF_BINS];
+    glm::vec3 binMin[NUMBER_OF_BINS];
+    glm::vec3 binMax[NUMBER_OF_BINS];
+    for( int i = 0; i < NUMBER_OF_BINS; i++ )
+    {
+        binCount[i] = 0;
+        binMin[i] = glm::vec3(FLT_MAX);
+        binMax[i] = glm::vec3(-FLT_MAX);
+    }
+    float binScale = NUMBER_OF_BINS / extent;
+    for( int i = pFirst; i < pFirst + pCount; i++ )
+    {
+        int triangle = mTriangleOrder.at(i);
+        int bin = glm::min( (int)( ( mCentroids.at(triangle)[axis] - centroidMin[axis] ) * binScale ), NUMBER_OF_BINS - 1 );
+        binCount[bin]++;
+        binMin[bin] = glm::min( binMin[bin], mTriangleMin.at(triangle) );
+        binMax[bin] = glm::max( binMax[bin], mTriangleMax.at(triangle) );
+    }
+
+    float leftArea[NUMBER_OF_BINS - 1];
+    int leftCount[NUMBER_OF_BINS - 1];
+    glm::vec3 accumulatedMin(FLT_MAX);
+    glm::vec3 accumulatedMax(-FLT_MAX);
+    int accumulatedCount = 0;
+    for( int i = 0; i < NUMBER_OF_BINS - 1; i++ )
+    {
+        accumulatedCount += binCount[i];
+        accumulatedMin = glm::min( accumulatedMin, binMin[i] );
+        accumulatedMax = glm::max( accumulatedMax, binMax[i] );
+        leftCount[i] = accumulatedCount;
+        leftArea[i] = SurfaceArea( accumulatedMin, accumulatedMax );
+    }
+    float bestCost = FLT_MAX;
+    int bestSplit = -1;
+    accumulatedMin = glm::vec3(FLT_MAX);
+    accumulatedMax = glm::vec3(-FLT_MAX);
+    accumulatedCount = 0;
+    for( int i = NUMBER_OF_BINS - 1; i > 0; i-- )
+    {
+        accumulatedCount += binCount[i];
+        accumulatedMin = glm::min( accumulatedMin, binMin[i] );
+        accumulatedMax = glm::max( accumulatedMax, binMax[i] );
+        if( leftCount[i - 1] > 0 && accumulatedCount > 0 )
+        {
+            float cost = leftArea[i - 1] * leftCount[i - 1] + SurfaceArea( accumulatedMin, accumulatedMax ) * accumulatedCount;
+            if( cost < bestCost )
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+    }
+
+    float leafCost = SurfaceArea( node.mMin, node.mMax ) * pCount;
+    if( bestSplit == -1 || ( bestCost >= leafCost && pCount <= MAX_LEAF_SIZE ) )
+    {
+        return;
+    }
+
+    //Partition of the triangles by the selected bin
+    int left = pFirst;
+    int right = pFirst + pCount - 1;
+    while( left <= right )
+    {
+        int triangle = mTriangleOrder.at(left);
+        int bin = glm::min( (int)( ( mCentroids.at(triangle)[axis] - centroidMin[axis] ) * binScale ), NUMBER_OF_BINS - 1 );
+        if( bin < bestSplit )
+        {
+            left++;
+        }
+        else
+        {
+            mTriangleOrder[left] = mTriangleOrder.at(right);
+            mTriangleOrder[right] = triangle;
+            right--;
+        }
+    }
+    int numberOfLeftTriangles = left - pFirst;
+
+    mNodes[nodeIndex].mCount = 0;
+    mNodes[nodeIndex].mAxis = axis;
+    Build(pFirst, numberOfLeftTriangles, pDepth + 1);
+    mNodes[nodeIndex].mOffset = mNodes.size();
+    Build(left, pCount - numberOfLeftTriangles, pDepth + 1);
+}
+
+float BoundingVolumeHierarchy::IntersectTriangle(int pTriangle, const glm::vec3& pOrigin, const glm::vec3& pDirection) const
+{
+    //Moller-Trumbore intersection test, both faces of the triangle are hit
+    const glm::vec3& v0 = mVertices.at(pTriangle * 3);
+    glm::vec3 edge1 = mVertices.at(pTriangle * 3 + 1) - v0;
+    glm::vec3 edge2 = mVertices.at(pTriangle * 3 + 2) - v0;
+    glm::vec3 p = glm::cross(pDirection, edge2);
+    float determinant = glm::dot(edge1, p);
+    if( glm::abs(determinant) < 1e-12f )
+    {
+        return -1.0f;
+    }
+    float inverseDeterminant = 1.0f / determinant;
+    glm::vec3 s = pOrigin - v0;
+    float u = glm::dot(s, p) * inverseDeterminant;
+    if( u < 0.0f || u > 1.0f )
+    {
+        return -1.0f;
+    }
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(pDirection, q) * inverseDeterminant;
+    if( v < 0.0f || u + v > 1.0f )
+    {
+        return -1.0f;
+    }
+    return glm::dot(edge2, q) * inverseDeterminant;
+}
@@ -4,14 +4,15 @@
 //Dependency includes
 #include <glm/gtc/matrix_transform.hpp>
 
-Camera::Camera(float pNearPlane, float pFarPlane, const glm::vec3 &pLookAt, const glm::vec3 &pUp, const glm::vec3 &pPosition, float pAspectRatio): Gizmo(),
+Camera::Camera(float pNearPlane, float pFarPlane, const glm::vec3 &pLookAt, const glm::vec3 &pUp, const glm::vec3 &pPosition, float pAspectRatio):
     mNearPlane(pNearPlane), mFarPlane(pFarPlane), mLookAt(pLookAt), mUp(pUp), mPosition(pPosition), mAspectRatio(pAspectRatio),
     mUpdatedView(false), mUpdatedProjection(false)
 {
 
 }
 
-Camera::Camera(const Camera& pCamera): Gizmo(pCamera),
+Camera::Camera(const Camera& pCamera):
+    mName(pCamera.mName),
     mNearPlane(pCamera.mNearPlane), mFarPlane(pCamera.mFarPlane), mLookAt(pCamera.mLookAt), mUp(pCamera.mUp), mPosition(pCamera.mPosition), mAspectRatio(pCamera.mAspectRatio),
     mUpdatedView(pCamera.mUpdatedView), mUpdatedProjection(pCamera.mUpdatedProjection),
     mViewMatrix(pCamera.mViewMatrix), mProjectionMatrix(pCamera.mProjectionMatrix)
@@ -47,42 +48,36 @@ void Camera::SetNearPlane(float pNearPlane)
 {
     mNearPlane = pNearPlane;
     mUpdatedProjection = false;
-    UpdatePositions();
 }
 
 void Camera::SetFarPlane(float pFarPlane)
 {
     mFarPlane = pFarPlane;
     mUpdatedProjection = false;
-    UpdatePositions();
 }
 
 void Camera::SetLookAt(const glm::vec3 &pLookAt)
 {
     mLookAt = pLookAt;
     mUpdatedView = false;
-    UpdatePositions();
 }
 
 void Camera::SetUp(const glm::vec3 &pUp)
 {
     mUp = pUp;
     mUpdatedView = false;
-    UpdatePositions();
 }
 
 void Camera::SetPosition(const glm::vec3 &pPosition)
 {
     mPosition = pPosition;
     mUpdatedView = false;
-    UpdatePositions();
 }
 
 void Camera::SetAspectRatio(float pRatio)
 {
     mAspectRatio = pRatio;
     mUpdatedProjection = false;
-    UpdatePositions();
 }
 
 float Camera::GetNearPlane() const
@@ -0,0 +1,43 @@
+//Definition include
+#include "CameraGizmo.h"
+
+//Project includes
+#include "Geometry.h"
+
+CameraGizmo::CameraGizmo(const QVector< Camera* >& pCameras): Gizmo(),
+    mCameras(pCameras)
+{
+    CreateMesh();
+}
+
+CameraGizmo::~CameraGizmo()
+{
+}
+
+void CameraGizmo::SetCameras(const QVector< Camera* >& pCameras)
+{
+    mCameras = pCameras;
+    UpdatePositions();
+}
+
+void CameraGizmo::CreateMesh()
+{
+    /// Creation of the mesh
+    mGizmo = new Geometry("CameraGizmo", Geometry::Lines);
+    UpdatePositions();
+}
+
+void CameraGizmo::UpdatePositions()
+{
+    QVector<glm::vec4> colors;
+    QVector<unsigned int> indexs;
+    mPositionOfVertices.clear();
+    for( int i = 0; i < mCameras.size(); i++ )
+    {
+        mCameras.at(i)->AddGizmo(mPositionOfVertices, colors, indexs);
+    }
+
+    mGizmo->SetVerticesData(mPositionOfVertices.size(), mPositionOfVertices.data());
+    mGizmo->SetColorData(colors.size(), colors.data());
+    mGizmo->SetIndexsData(indexs.size(), indexs.data());
+}
@@ -5,10 +5,14 @@
 #include "glew.h"
 
 QPlainTextEdit* Debug::mConsole = NULL;
+Debug::Verbosity Debug::mVerbosity = Debug::Normal;
 
 void Debug::Log(const QString &pMessage)
 {
-    qDebug(pMessage.toStdString().c_str());
+    if( mVerbosity != Quiet )
+    {
+        qDebug(pMessage.toStdString().c_str());
+    }
 }
 
 void Debug::Warning(const QString& pMessage)
@@ -21,6 +25,16 @@ void Debug::Error(const QString &pMessage)
     qCritical(pMessage.toStdString().c_str());
 }
 
+void Debug::SetVerbosity(Verbosity pVerbosity)
+{
+    mVerbosity = pVerbosity;
+}
+
+Debug::Verbosity Debug::GetVerbosity()
+{
+    return mVerbosity;
+}
+
 void Debug::SetConsole(QPlainTextEdit * pConsole)
 {
     mConsole = pConsole;
@@ -65,23 +79,24 @@ bool Debug::CheckGLError(const char *pFile, int pLine)
     }
     return retCode;
 }
+//The console is updated through invokeMethod so messages logged from worker threads are queued to the GUI thread
 #if QT_VERSION < 0x50000
 void Debug::ConsoleOutput(QtMsgType pType, const char *pMessage)
 {
     switch(pType)
     {
         case QtDebugMsg:
-            mConsole->appendHtml( QString("<FONT color=black>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) );
+            QMetaObject::invokeMethod( mConsole, "appendHtml", Q_ARG( QString, QString("<FONT color=black>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) ) );
             fprintf(stdout, "Log: %s\n", pMessage);
             fflush(stdout);
             break;
         case QtWarningMsg:
-            mConsole->appendHtml( QString("<FONT color=yellow>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) );
+            QMetaObject::invokeMethod( mConsole, "appendHtml", Q_ARG( QString, QString("<FONT color=yellow>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) ) );
             fprintf(stderr, "Warning: %s\n", pMessage);
             fflush(stderr);
             break;
         case QtCriticalMsg:
-            mConsole->appendHtml( QString("<FONT color=red>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) );
+            QMetaObject::invokeMethod( mConsole, "appendHtml", Q_ARG( QString, QString("<FONT color=red>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) ) );
             fprintf(stderr, "Error: %s\n", pMessage);
             fflush(stderr);
             break;
@@ -93,17 +108,17 @@ void Debug::ConsoleOutput(QtMsgType pType, const QMessageLogContext &, const QSt
     switch(pType)
     {
         case QtDebugMsg:
-            mConsole->appendHtml( QString("<FONT color=black>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) );
+            QMetaObject::invokeMethod( mConsole, "appendHtml", Q_ARG( QString, QString("<FONT color=black>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) ) );
             fprintf(stdout, "Log: %s\n", pMessage.toLocal8Bit().constData());
             fflush(stdout);
             break;
         case QtWarningMsg:
-            mConsole->appendHtml( QString("<FONT color=yellow>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) );
+            QMetaObject::invokeMethod( mConsole, "appendHtml", Q_ARG( QString, QString("<FONT color=yellow>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) ) );
             fprintf(stderr, "Warning: %s\n", pMessage.toLocal8Bit().constData());
             fflush(stderr);
             break;
         case QtCriticalMsg:
-            mConsole->appendHtml( QString("<FONT color=red>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) );
+            QMetaObject::invokeMethod( mConsole, "appendHtml", Q_ARG( QString, QString("<FONT color=red>%1</FONT>").arg( QString(pMessage).replace(" ","&nbsp;") ) ) );
             fprintf(stderr, "Error: %s\n", pMessage.toLocal8Bit().constData());
             fflush(stderr);
             break;
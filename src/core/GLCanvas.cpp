@@ -19,6 +19,7 @@ GLCanvas::GLCanvas(QWidget *pParent)
     mDrawBoundingSphere = false;
     mDrawWireframe = false;
     mApplyMaterials = true;
+    mWeightedBlendedTransparency = false;
 
     //Inicialitzaci de la cmera de render
     mFreeCamera = NULL;
@@ -30,10 +31,12 @@ GLCanvas::GLCanvas(QWidget *pParent)
 
     //Inicialitzaci els shaders
     mShaderDualInit = NULL;
-    mShaderDualPeel = NULL;
+    mShaderOpaque = NULL;
     mShaderDualPeelPerVertexColor = NULL;
     mShaderDualBlend = NULL;
     mShaderDualFinal = NULL;
+    mShaderWeightedBlendedAccumulation = NULL;
+    mShaderWeightedBlendedComposite = NULL;
 
     //Inicialitzaci dels draw buffers
     mDrawBuffers[0] = GL_COLOR_ATTACHMENT0;
@@ -137,7 +140,7 @@ void GLCanvas::SetPolygonalTextureSize(unsigned int pPolygonalTextureSize)
 
 GLSLProgram* GLCanvas::GetShaderProgram() const
 {
-    return mShaderDualPeel;
+    return mShaderOpaque;
 }
 
 QString GLCanvas::SaveScreenshot( const QString &pFileName )
@@ -164,6 +167,14 @@ void GLCanvas::SetCamera(const Camera* pCamera)
     updateGL();
 }
 
+void GLCanvas::SetCameraView(const glm::vec3& pPosition, const glm::vec3& pLookAt, const glm::vec3& pUp)
+{
+    mFreeCamera->SetPosition( pPosition );
+    mFreeCamera->SetLookAt( pLookAt );
+    mFreeCamera->SetUp( pUp );
+    updateGL();
+}
+
 const Camera* GLCanvas::GetCamera()
 {
     return mFreeCamera;
@@ -192,6 +203,12 @@ void GLCanvas::ApplyMaterials(bool pApplyMaterials)
     updateGL();
 }
 
+void GLCanvas::UseWeightedBlendedTransparency(bool pWeightedBlended)
+{
+    mWeightedBlendedTransparency = pWeightedBlended;
+    updateGL();
+}
+
 void GLCanvas::initializeGL()
 {
     GLenum err = glewInit();
@@ -238,180 +255,219 @@ void GLCanvas::paintGL()
         glm::mat4 viewMatrix = mFreeCamera->GetViewMatrix();
         glm::mat4 viewProjectionMatrix = projectionMatrix * viewMatrix;
 
-        glDisable(GL_DEPTH_TEST);
-        glEnable(GL_BLEND);
+        glBindFramebuffer(GL_FRAMEBUFFER, mDualPeelingSingleFboId);
 
         // ---------------------------------------------------------------------
-        // 1. Initialize Min-Max Depth Buffer
+        // 1. Opaque geometry
         // ---------------------------------------------------------------------
 
-        glBindFramebuffer(GL_FRAMEBUFFER, mDualPeelingSingleFboId);
-
-        // Render targets 1 and 2 store the front and back colors
-        // Clear to 0.0 and use MAX blending to filter written color
-        // At most one front color and one back color can be written every pass
-        glDrawBuffers(2, &mDrawBuffers[1]);
-        glClearColor(0, 0, 0, 0);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        // Render target 0 stores (-minDepth, maxDepth, alphaMultiplier)
-        glDrawBuffer(mDrawBuffers[0]);
-        glClearColor(-MAX_DEPTH, -MAX_DEPTH, 0, 0);
-        glClear(GL_COLOR_BUFFER_BIT);
-        glBlendEquation(GL_MAX);
-
-        mShaderDualInit->UseProgram();
-        mShaderDualInit->SetUniform("modelViewProjection", viewProjectionMatrix);
-        for(int i = 0; i < mScene->GetNumberOfMeshes(); i++)
-        {
-            //if( mWireframe )
-            //    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-            mScene->GetMesh(i)->Draw();
-            glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-            if(mDrawBoundingBox)
-                mScene->GetMesh(i)->GetBoundingBox()->Draw();
-            if(mDrawBoundingSphere)
-                mScene->GetMesh(i)->GetBoundingSphere()->Draw();
-        }
-        for(int i = 0; i < mPerVertexColorMeshes.size(); i++)
+        // The scene is opaque, so it is drawn only once with the depth test into the back blender.
+        // The translucent layers are blended over it and its depth hides the translucent fragments behind it
+        glDrawBuffer(mDrawBuffers[6]);
+        glClearColor(mBackgroundColor[0], mBackgroundColor[1], mBackgroundColor[2], 0);
+        glClearDepth(MAX_DEPTH);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+
+        mShaderOpaque->UseProgram();
+        mShaderOpaque->SetUniform("modelViewProjection", viewProjectionMatrix);
+        mShaderOpaque->BindTexture(GL_TEXTURE_2D_ARRAY, "visibilityTexture", mPolygonalVisibilityTexture, 6);
+        mShaderOpaque->BindTexture(GL_TEXTURE_2D_ARRAY, "polygonalTexture", mPolygonalTexture, 5);
+        mShaderOpaque->SetUniform("polygonalTexturesSize", (int)mPolygonalTextureSize);
+
+        QVector<int> meshOrder = mScene->GetMeshTraversalOrder();
+        for(int i = 0; i < meshOrder.size(); i++)
         {
-            if( mDrawWireframe )
+            Geometry* currentMesh = mScene->GetMesh(meshOrder.at(i));
+            //The meshes outside the frustum are not drawn nor paged in
+            if( !currentMesh->GetBoundingBox()->Intersects(viewProjectionMatrix) )
+            {
+                continue;
+            }
+            Material* currentMaterial = currentMesh->GetMaterial();
+            if(mApplyMaterials && currentMaterial != NULL)
+            {
+                bool hasTexture = currentMaterial->HasKdTexture();
+                if( hasTexture )
+                {
+                    Texture* kdTexture = currentMaterial->GetKdTexture();
+                    mShaderOpaque->BindTexture(GL_TEXTURE_2D, "diffuseTexture", kdTexture->GetGLId(), 0);
+                }
+                mShaderOpaque->SetUniform("applyDiffuseTexture", hasTexture);
+                mShaderOpaque->SetUniform("materialKa", currentMaterial->GetKa());
+                mShaderOpaque->SetUniform("materialKd", currentMaterial->GetKd());
+            }
+            else
             {
-                glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+                mShaderOpaque->SetUniform("applyDiffuseTexture", false);
+                mShaderOpaque->SetUniform("materialKa", glm::vec3(0.0f, 0.0f, 0.0f));
+                mShaderOpaque->SetUniform("materialKd", glm::vec3(0.6f, 0.6f, 0.6f));
             }
-            mPerVertexColorMeshes.at(i)->Draw();
-            glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+            mShaderOpaque->SetUniform("offset", mScene->GetPolygonOffsetOfMesh(meshOrder.at(i)));
+            currentMesh->Draw();
         }
         glUseProgram(0);
 
-        CHECK_GL_ERROR();
-
-        // ---------------------------------------------------------------------
-        // 2. Dual Depth Peeling + Blending
-        // ---------------------------------------------------------------------
+        //From here the depth of the opaque geometry is only tested
+        glDepthMask(GL_FALSE);
 
-        // Since we cannot blend the back colors in the geometry passes,
-        // we use another render target to do the alpha blending
-        //glBindFramebuffer(GL_FRAMEBUFFER, mDualBackBlenderFboId);
-        glDrawBuffer(mDrawBuffers[6]);
-        glClearColor(mBackgroundColor[0], mBackgroundColor[1], mBackgroundColor[2], 0);
-        glClear(GL_COLOR_BUFFER_BIT);
+        CHECK_GL_ERROR();
 
         int currId = 0;
-        int pass = 1;
-        for (;;)
+        bool hasTranslucentGeometry = HasTranslucentGeometry();
+        if( hasTranslucentGeometry && !mWeightedBlendedTransparency )
         {
-            currId = pass % 2;
-            int prevId = 1 - currId;
-            int bufId = currId * 3;
-            int processedPolygons = 0;
+            glEnable(GL_BLEND);
 
-            //glBindFramebuffer(GL_FRAMEBUFFER, mDualPeelingFboId[currId]);
+            // ---------------------------------------------------------------------
+            // 2. Initialize Min-Max Depth Buffer
+            // ---------------------------------------------------------------------
 
-            glDrawBuffers(2, &mDrawBuffers[bufId+1]);
+            // Render targets 1 and 2 store the front and back colors
+            // Clear to 0.0 and use MAX blending to filter written color
+            // At most one front color and one back color can be written every pass
+            glDrawBuffers(2, &mDrawBuffers[1]);
             glClearColor(0, 0, 0, 0);
             glClear(GL_COLOR_BUFFER_BIT);
 
-            glDrawBuffer(mDrawBuffers[bufId+0]);
+            // Render target 0 stores (-minDepth, maxDepth, alphaMultiplier)
+            glDrawBuffer(mDrawBuffers[0]);
             glClearColor(-MAX_DEPTH, -MAX_DEPTH, 0, 0);
             glClear(GL_COLOR_BUFFER_BIT);
-
-            // Render target 0: RG32F MAX blending
-            // Render target 1: RGBA MAX blending
-            // Render target 2: RGBA MAX blending
-            glDrawBuffers(3, &mDrawBuffers[bufId+0]);
             glBlendEquation(GL_MAX);
 
-            mShaderDualPeel->UseProgram();
-            mShaderDualPeel->SetUniform("modelViewProjection", viewProjectionMatrix);
-
-            mShaderDualPeel->BindTexture(GL_TEXTURE_RECTANGLE, "DepthBlenderTex", mDualDepthTexId[prevId], 1);
-            mShaderDualPeel->BindTexture(GL_TEXTURE_RECTANGLE, "FrontBlenderTex", mDualFrontBlenderTexId[prevId], 2);
-            mShaderDualPeel->BindTexture(GL_TEXTURE_2D, "visibilityTexture", mPolygonalVisibilityTexture, 6);
-            mShaderDualPeel->BindTexture(GL_TEXTURE_2D, "polygonalTexture", mPolygonalTexture, 5);
-
-            mShaderDualPeel->SetUniform("polygonalTexturesSize", (int)mPolygonalTextureSize);
-
-            //Recorrem els meshos
-            for(int i = 0; i < mScene->GetNumberOfMeshes(); i++)
-            {
-                Geometry* currentMesh = mScene->GetMesh(i);
-                Material* currentMaterial = currentMesh->GetMaterial();
-                if(mApplyMaterials && currentMaterial != NULL)
-                {
-                    bool hasTexture = currentMaterial->HasKdTexture();
-                    if( hasTexture )
-                    {
-                        Texture* kdTexture = currentMaterial->GetKdTexture();
-                        mShaderDualPeel->BindTexture(GL_TEXTURE_2D, "diffuseTexture", kdTexture->GetGLId(), 0);
-                    }
-                    mShaderDualPeel->SetUniform("applyDiffuseTexture", hasTexture);
-                    mShaderDualPeel->SetUniform("materialKa", currentMaterial->GetKa());
-                    mShaderDualPeel->SetUniform("materialKd", currentMaterial->GetKd());
-                }
-                else
-                {
-                    mShaderDualPeel->SetUniform("applyDiffuseTexture", false);
-                    mShaderDualPeel->SetUniform("materialKa", glm::vec3(0.0f, 0.0f, 0.0f));
-                    mShaderDualPeel->SetUniform("materialKd", glm::vec3(0.6f, 0.6f, 0.6f));
-                }
-                //if( mWireframe )
-                //    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-                mShaderDualPeel->SetUniform("offset", processedPolygons);
-                currentMesh->Draw();
-                processedPolygons += currentMesh->GetNumFaces();
-                glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-                //glPolygonMode( GL_FRONT, GL_FILL );
-                //glPolygonMode( GL_BACK, GL_LINE );
-            }
-            mShaderDualPeelPerVertexColor->UseProgram();
-            mShaderDualPeelPerVertexColor->BindTexture(GL_TEXTURE_RECTANGLE, "DepthBlenderTex", mDualDepthTexId[prevId], 1);
-            mShaderDualPeelPerVertexColor->BindTexture(GL_TEXTURE_RECTANGLE, "FrontBlenderTex", mDualFrontBlenderTexId[prevId], 2);
-            mShaderDualPeelPerVertexColor->SetUniform("modelViewProjection", viewProjectionMatrix);
-            DrawGeometryBoundingVolumes();
-            for(int i = 0; i < mPerVertexColorMeshes.size(); i++)
-            {
-                if( mDrawWireframe )
-                {
-                    glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
-                }
-                mPerVertexColorMeshes.at(i)->Draw();
-                glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
-            }
+            mShaderDualInit->UseProgram();
+            mShaderDualInit->SetUniform("modelViewProjection", viewProjectionMatrix);
+            DrawTranslucentGeometry();
             glUseProgram(0);
 
             CHECK_GL_ERROR();
 
-            // Full screen pass to alpha-blend the back color
-            glDrawBuffer(mDrawBuffers[6]);
-
-            glBlendEquation(GL_FUNC_ADD);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-            glBeginQuery(GL_SAMPLES_PASSED, mQueryId);
+            // ---------------------------------------------------------------------
+            // 3. Dual Depth Peeling + Blending
+            // ---------------------------------------------------------------------
 
-            mShaderDualBlend->UseProgram();
-            mShaderDualBlend->SetUniform("modelViewProjection", glm::ortho(0.0f, 1.0f, 0.0f, 1.0f));
-            mShaderDualBlend->BindTexture(GL_TEXTURE_RECTANGLE, "TempTex", mDualBackTempTexId[currId], 1);
-            mMeshFullScreenQuad->Draw();
-            glUseProgram(0);
-
-            CHECK_GL_ERROR();
+            // Only the translucent geometry is peeled, the back colors are blended over the opaque geometry
+            int pass = 1;
+            for (;;)
+            {
+                currId = pass % 2;
+                int prevId = 1 - currId;
+                int bufId = currId * 3;
+
+                glDrawBuffers(2, &mDrawBuffers[bufId+1]);
+                glClearColor(0, 0, 0, 0);
+                glClear(GL_COLOR_BUFFER_BIT);
+
+                glDrawBuffer(mDrawBuffers[bufId+0]);
+                glClearColor(-MAX_DEPTH, -MAX_DEPTH, 0, 0);
+                glClear(GL_COLOR_BUFFER_BIT);
+
+                // Render target 0: RG32F MAX blending
+                // Render target 1: RGBA MAX blending
+                // Render target 2: RGBA MAX blending
+                glDrawBuffers(3, &mDrawBuffers[bufId+0]);
+                glBlendEquation(GL_MAX);
+                glEnable(GL_DEPTH_TEST);
+
+                mShaderDualPeelPerVertexColor->UseProgram();
+                mShaderDualPeelPerVertexColor->BindTexture(GL_TEXTURE_RECTANGLE, "DepthBlenderTex", mDualDepthTexId[prevId], 1);
+                mShaderDualPeelPerVertexColor->BindTexture(GL_TEXTURE_RECTANGLE, "FrontBlenderTex", mDualFrontBlenderTexId[prevId], 2);
+                mShaderDualPeelPerVertexColor->SetUniform("modelViewProjection", viewProjectionMatrix);
+                DrawTranslucentGeometry();
+                glUseProgram(0);
+
+                CHECK_GL_ERROR();
+
+                // Full-screen passes are not depth tested
+                glDisable(GL_DEPTH_TEST);
+                glDrawBuffer(mDrawBuffers[6]);
+
+                glBlendEquation(GL_FUNC_ADD);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+                glBeginQuery(GL_SAMPLES_PASSED, mQueryId);
+
+                mShaderDualBlend->UseProgram();
+                mShaderDualBlend->SetUniform("modelViewProjection", glm::ortho(0.0f, 1.0f, 0.0f, 1.0f));
+                mShaderDualBlend->BindTexture(GL_TEXTURE_RECTANGLE, "TempTex", mDualBackTempTexId[currId], 1);
+                mMeshFullScreenQuad->Draw();
+                glUseProgram(0);
+
+                CHECK_GL_ERROR();
+
+                glEndQuery(GL_SAMPLES_PASSED);
+                GLuint sample_count;
+                glGetQueryObjectuiv(mQueryId, GL_QUERY_RESULT, &sample_count);
+                if (sample_count == 0) {
+                    break;
+                }
 
-            glEndQuery(GL_SAMPLES_PASSED);
-            GLuint sample_count;
-            glGetQueryObjectuiv(mQueryId, GL_QUERY_RESULT, &sample_count);
-            if (sample_count == 0) {
-                break;
+                pass++;
             }
 
-            pass++;
+            glDisable(GL_BLEND);
         }
+        else
+        {
+            if( hasTranslucentGeometry )
+            {
+                // ---------------------------------------------------------------------
+                // 2. Weighted Blended Order-Independent Transparency
+                // ---------------------------------------------------------------------
+
+                // A single pass accumulates all the translucent fragments whatever the depth complexity
+                glBindFramebuffer(GL_FRAMEBUFFER, mWeightedBlendedFboId);
+                glDrawBuffer(mDrawBuffers[0]);
+                glClearColor(0, 0, 0, 1);
+                glClear(GL_COLOR_BUFFER_BIT);
+                glDrawBuffer(mDrawBuffers[1]);
+                glClearColor(0, 0, 0, 0);
+                glClear(GL_COLOR_BUFFER_BIT);
+
+                glDrawBuffers(2, &mDrawBuffers[0]);
+                glEnable(GL_BLEND);
+                glBlendEquation(GL_FUNC_ADD);
+                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+
+                mShaderWeightedBlendedAccumulation->UseProgram();
+                mShaderWeightedBlendedAccumulation->SetUniform("modelViewProjection", viewProjectionMatrix);
+                DrawTranslucentGeometry();
+                glUseProgram(0);
+
+                CHECK_GL_ERROR();
+
+                // The average color of the translucent fragments is blended over the opaque geometry
+                glDisable(GL_DEPTH_TEST);
+                glBindFramebuffer(GL_FRAMEBUFFER, mDualPeelingSingleFboId);
+                glDrawBuffer(mDrawBuffers[6]);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+                mShaderWeightedBlendedComposite->UseProgram();
+                mShaderWeightedBlendedComposite->SetUniform("modelViewProjection", glm::ortho(0.0f, 1.0f, 0.0f, 1.0f));
+                mShaderWeightedBlendedComposite->BindTexture(GL_TEXTURE_RECTANGLE, "AccumulationTex", mWeightedAccumulationTexId, 1);
+                mShaderWeightedBlendedComposite->BindTexture(GL_TEXTURE_RECTANGLE, "WeightTex", mWeightedWeightTexId, 2);
+                mMeshFullScreenQuad->Draw();
+                glUseProgram(0);
+
+                glDisable(GL_BLEND);
+
+                CHECK_GL_ERROR();
+            }
 
-        glDisable(GL_BLEND);
+            // Without peeling there is nothing in the front blender
+            glDrawBuffer(mDrawBuffers[1]);
+            glClearColor(0, 0, 0, 0);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        glDisable(GL_DEPTH_TEST);
+        glDepthMask(GL_TRUE);
 
         // ---------------------------------------------------------------------
-        // 3. Final Pass
+        // 4. Final Pass
         // ---------------------------------------------------------------------
 
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -550,6 +606,30 @@ void GLCanvas::keyPressEvent(QKeyEvent *pEvent)
     }
 }
 
+bool GLCanvas::HasTranslucentGeometry() const
+{
+    bool hasTranslucentGeometry = mDrawBoundingBox || mDrawBoundingSphere;
+    for(int i = 0; i < mPerVertexColorMeshes.size() && !hasTranslucentGeometry; i++)
+    {
+        hasTranslucentGeometry = mPerVertexColorMeshes.at(i)->IsVisible();
+    }
+    return hasTranslucentGeometry;
+}
+
+void GLCanvas::DrawTranslucentGeometry()
+{
+    DrawGeometryBoundingVolumes();
+    for(int i = 0; i < mPerVertexColorMeshes.size(); i++)
+    {
+        if( mDrawWireframe )
+        {
+            glPolygonMode( GL_FRONT_AND_BACK, GL_LINE );
+        }
+        mPerVertexColorMeshes.at(i)->Draw();
+        glPolygonMode( GL_FRONT_AND_BACK, GL_FILL );
+    }
+}
+
 void GLCanvas::DrawGeometryBoundingVolumes()
 {
     for(int i = 0; i < mScene->GetNumberOfMeshes(); i++)
@@ -604,6 +684,11 @@ void GLCanvas::LoadShaders()
     {
         Debug::Error( QString("shaders/DualPeelingPeel.frag: %1").arg(dualPeelingPeelFS->GetLog()) );
     }
+    GLSLShader* opaqueFS = new GLSLShader("shaders/Opaque.frag", GL_FRAGMENT_SHADER);
+    if( opaqueFS->HasErrors() )
+    {
+        Debug::Error( QString("shaders/Opaque.frag: %1").arg(opaqueFS->GetLog()) );
+    }
     GLSLShader* shadeFragmentFS = new GLSLShader("shaders/ShadeFragment.frag", GL_FRAGMENT_SHADER);
     if( shadeFragmentFS->HasErrors() )
     {
@@ -629,18 +714,28 @@ void GLCanvas::LoadShaders()
     {
         Debug::Error( QString("shaders/DualPeelingFinal.frag: %1").arg(dualPeelingFinalFS->GetLog()) );
     }
+    GLSLShader* weightedBlendedAccumulationFS = new GLSLShader("shaders/WeightedBlendedAccumulation.frag", GL_FRAGMENT_SHADER);
+    if( weightedBlendedAccumulationFS->HasErrors() )
+    {
+        Debug::Error( QString("shaders/WeightedBlendedAccumulation.frag: %1").arg(weightedBlendedAccumulationFS->GetLog()) );
+    }
+    GLSLShader* weightedBlendedCompositeFS = new GLSLShader("shaders/WeightedBlendedComposite.frag", GL_FRAGMENT_SHADER);
+    if( weightedBlendedCompositeFS->HasErrors() )
+    {
+        Debug::Error( QString("shaders/WeightedBlendedComposite.frag: %1").arg(weightedBlendedCompositeFS->GetLog()) );
+    }
 
     mShaderDualInit = new GLSLProgram("ShaderDualInit");
     mShaderDualInit->AttachShader(basicVS);
     mShaderDualInit->AttachShader(dualPeelingInitFS);
     mShaderDualInit->LinkProgram();
 
-    mShaderDualPeel = new GLSLProgram("ShaderDualPeel");
-    mShaderDualPeel->AttachShader(dualPeelingPeelVS);
-    mShaderDualPeel->AttachShader(dualPeelingPeelFS);
-    mShaderDualPeel->AttachShader(shadeFragmentFS);
-    mShaderDualPeel->AttachShader(thermalScaleFS);
-    mShaderDualPeel->LinkProgram();
+    mShaderOpaque = new GLSLProgram("ShaderOpaque");
+    mShaderOpaque->AttachShader(dualPeelingPeelVS);
+    mShaderOpaque->AttachShader(opaqueFS);
+    mShaderOpaque->AttachShader(shadeFragmentFS);
+    mShaderOpaque->AttachShader(thermalScaleFS);
+    mShaderOpaque->LinkProgram();
 
     mShaderDualPeelPerVertexColor = new GLSLProgram("ShaderDualPeelPerVertexColor");
     mShaderDualPeelPerVertexColor->AttachShader(dualPeelingPeelVS);
@@ -658,24 +753,40 @@ void GLCanvas::LoadShaders()
     mShaderDualFinal->AttachShader(dualPeelingFinalFS);
     mShaderDualFinal->LinkProgram();
 
+    mShaderWeightedBlendedAccumulation = new GLSLProgram("ShaderWeightedBlendedAccumulation");
+    mShaderWeightedBlendedAccumulation->AttachShader(dualPeelingPeelVS);
+    mShaderWeightedBlendedAccumulation->AttachShader(weightedBlendedAccumulationFS);
+    mShaderWeightedBlendedAccumulation->AttachShader(shadePerVertexColorFS);
+    mShaderWeightedBlendedAccumulation->LinkProgram();
+
+    mShaderWeightedBlendedComposite = new GLSLProgram("ShaderWeightedBlendedComposite");
+    mShaderWeightedBlendedComposite->AttachShader(basicVS);
+    mShaderWeightedBlendedComposite->AttachShader(weightedBlendedCompositeFS);
+    mShaderWeightedBlendedComposite->LinkProgram();
+
     delete basicVS;
     delete dualPeelingInitFS;
     delete dualPeelingPeelVS;
     delete dualPeelingPeelFS;
+    delete opaqueFS;
     delete shadeFragmentFS;
     delete thermalScaleFS;
     delete shadePerVertexColorFS;
     delete dualPeelingBlendFS;
     delete dualPeelingFinalFS;
+    delete weightedBlendedAccumulationFS;
+    delete weightedBlendedCompositeFS;
 }
 
 void GLCanvas::DeleteShaders()
 {
     delete mShaderDualInit;
-    delete mShaderDualPeel;
+    delete mShaderOpaque;
     delete mShaderDualPeelPerVertexColor;
     delete mShaderDualBlend;
     delete mShaderDualFinal;
+    delete mShaderWeightedBlendedAccumulation;
+    delete mShaderWeightedBlendedComposite;
 }
 
 void GLCanvas::InitDualPeelingRenderTargets()
@@ -734,6 +845,35 @@ void GLCanvas::InitDualPeelingRenderTargets()
 
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT6, GL_TEXTURE_RECTANGLE, mDualBackBlenderTexId, 0);
 
+    glGenRenderbuffers(1, &mOpaqueDepthId);
+    glBindRenderbuffer(GL_RENDERBUFFER, mOpaqueDepthId);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT32F, mWinWidth, mWinHeight);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mOpaqueDepthId);
+
+    //The weighted blended transparency uses float render targets and the depth of the opaque geometry
+    glGenTextures(1, &mWeightedAccumulationTexId);
+    glBindTexture(GL_TEXTURE_RECTANGLE, mWeightedAccumulationTexId);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_RECTANGLE, 0, GL_RGBA16F, mWinWidth, mWinHeight, 0, GL_RGBA, GL_FLOAT, 0);
+
+    glGenTextures(1, &mWeightedWeightTexId);
+    glBindTexture(GL_TEXTURE_RECTANGLE, mWeightedWeightTexId);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_RECTANGLE, 0, GL_R16F, mWinWidth, mWinHeight, 0, GL_RED, GL_FLOAT, 0);
+
+    glGenFramebuffers(1, &mWeightedBlendedFboId);
+    glBindFramebuffer(GL_FRAMEBUFFER, mWeightedBlendedFboId);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_RECTANGLE, mWeightedAccumulationTexId, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_RECTANGLE, mWeightedWeightTexId, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, mOpaqueDepthId);
+
     CHECK_GL_ERROR();
 }
 
@@ -746,4 +886,8 @@ void GLCanvas::DeleteDualPeelingRenderTargets()
     glDeleteTextures(2, mDualBackTempTexId);
     glDeleteTextures(2, mDualFrontBlenderTexId);
     glDeleteTextures(2, mDualDepthTexId);
+    glDeleteFramebuffers(1, &mWeightedBlendedFboId);
+    glDeleteTextures(1, &mWeightedWeightTexId);
+    glDeleteTextures(1, &mWeightedAccumulationTexId);
+    glDeleteRenderbuffers(1, &mOpaqueDepthId);
 }
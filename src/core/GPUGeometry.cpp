@@ -7,12 +7,25 @@
 //Project includes
 #include "Debug.h"
 
+/// Locations of the vertex attributes, they have to match the ones defined in the shaders
+const unsigned int POSITION        = 0;
+const unsigned int NORMAL          = 1;
+const unsigned int COLOR           = 2;
+const unsigned int TEXTCOORD       = 3;
+const unsigned int TANGENT         = 4;
+const unsigned int BITANGENT       = 5;
+const unsigned int POSITION_OFFSET = 6;
+const unsigned int POSITION_SCALE  = 7;
+const unsigned int OCT_NORMALS     = 8;
+
 GPUGeometry::GPUGeometry():
-    mVerticesId(0), mVerticesStride(0),
+    mVerticesId(0), mVerticesStride(0), mVerticesType(GL_FLOAT),
+    mPositionOffset(0.0f), mPositionScale(1.0f),
     mColorsId(0), mColorsStride(0),
-    mNormalsId(0), mTangentsId(0), mBitangentsId(0),
+    mNormalsId(0), mOctNormals(false), mTangentsId(0), mBitangentsId(0),
     mTextCoordsId(0),
-    mIndexsId(0), mIndexsSize(0), mMeshTopology(Geometry::Triangles)
+    mIndexsId(0), mIndexsSize(0), mIndexsType(GL_UNSIGNED_INT), mMeshTopology(Geometry::Triangles),
+    mReferences(1)
 {
     //VAO Generation
     glGenVertexArrays(1, &mVaoId);
@@ -31,6 +44,24 @@ GPUGeometry::~GPUGeometry()
     glDeleteVertexArrays(1, &mVaoId);
 }
 
+void GPUGeometry::AddReference()
+{
+    mReferences++;
+}
+
+void GPUGeometry::Release(GPUGeometry* pGPUGeometry)
+{
+    if( pGPUGeometry != NULL && --pGPUGeometry->mReferences <= 0 )
+    {
+        delete pGPUGeometry;
+    }
+}
+
+bool GPUGeometry::IsShared() const
+{
+    return mReferences > 1;
+}
+
 //Methods for setting the data
 void GPUGeometry::SetVerticesData(unsigned int pSize, unsigned int pStride, const float *pData)
 {
@@ -39,22 +70,53 @@ void GPUGeometry::SetVerticesData(unsigned int pSize, unsigned int pStride, cons
         glGenBuffers(1, &mVerticesId);
     }
     mVerticesStride = pStride;
+    mVerticesType = GL_FLOAT;
+    mPositionOffset = glm::vec3(0.0f);
+    mPositionScale = glm::vec3(1.0f);
     glBindBuffer(GL_ARRAY_BUFFER, mVerticesId);
     glBufferData(GL_ARRAY_BUFFER, pSize * sizeof(float), pData, GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void GPUGeometry::SetVerticesData(unsigned int pSize, const unsigned short *pData, const glm::vec3& pOffset, const glm::vec3& pScale)
+{
+    if(mVerticesId == 0)
+    {
+        glGenBuffers(1, &mVerticesId);
+    }
+    mVerticesStride = 3;
+    mVerticesType = GL_UNSIGNED_SHORT;
+    mPositionOffset = pOffset;
+    mPositionScale = pScale;
+    glBindBuffer(GL_ARRAY_BUFFER, mVerticesId);
+    glBufferData(GL_ARRAY_BUFFER, pSize * sizeof(unsigned short), pData, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void GPUGeometry::SetNormalsData(unsigned int pSize, const float *pData)
 {
     if(mNormalsId == 0)
     {
         glGenBuffers(1, &mNormalsId);
     }
+    mOctNormals = false;
     glBindBuffer(GL_ARRAY_BUFFER, mNormalsId);
     glBufferData(GL_ARRAY_BUFFER, pSize * sizeof(float), pData, GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void GPUGeometry::SetNormalsData(unsigned int pSize, const short *pData)
+{
+    if(mNormalsId == 0)
+    {
+        glGenBuffers(1, &mNormalsId);
+    }
+    mOctNormals = true;
+    glBindBuffer(GL_ARRAY_BUFFER, mNormalsId);
+    glBufferData(GL_ARRAY_BUFFER, pSize * sizeof(short), pData, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void GPUGeometry::SetColorData(unsigned int pSize, unsigned int pStride, const float *pData)
 {
     if(mColorsId == 0)
@@ -107,19 +169,38 @@ void GPUGeometry::SetIndexsData(unsigned int pSize, Geometry::Topology pTopology
         glGenBuffers(1, &mIndexsId);
     }
     mIndexsSize = pSize;
+    mIndexsType = GL_UNSIGNED_INT;
     mMeshTopology = pTopology;
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexsId);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, pSize * sizeof(unsigned int), pData, GL_STATIC_DRAW);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+void GPUGeometry::SetIndexsData(unsigned int pSize, Geometry::Topology pTopology, const unsigned short *pData)
+{
+    if(mIndexsId == 0)
+    {
+        glGenBuffers(1, &mIndexsId);
+    }
+    mIndexsSize = pSize;
+    mIndexsType = GL_UNSIGNED_SHORT;
+    mMeshTopology = pTopology;
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mIndexsId);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, pSize * sizeof(unsigned short), pData, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
 void GPUGeometry::FastDraw(unsigned int pSize) const
 {
-    glDrawElements(mMeshTopology, pSize, GL_UNSIGNED_INT, 0);
+    glDrawElements(mMeshTopology, pSize, mIndexsType, 0);
 }
 
 void GPUGeometry::Draw() const
 {
+    //The values to decode the vertices are constant attributes because they are not part of the vertex array object
+    glVertexAttrib3f(POSITION_OFFSET, mPositionOffset.x, mPositionOffset.y, mPositionOffset.z);
+    glVertexAttrib3f(POSITION_SCALE, mPositionScale.x, mPositionScale.y, mPositionScale.z);
+    glVertexAttrib1f(OCT_NORMALS, mOctNormals ? 1.0f : 0.0f);
     glBindVertexArray(mVaoId);
     FastDraw(mIndexsSize);
     glBindVertexArray(0);
@@ -127,24 +208,24 @@ void GPUGeometry::Draw() const
 
 void GPUGeometry::ConfigureVAO()
 {
-    const unsigned int POSITION  = 0;
-    const unsigned int NORMAL    = 1;
-    const unsigned int COLOR     = 2;
-    const unsigned int TEXTCOORD = 3;
-    const unsigned int TANGENT   = 4;
-    const unsigned int BITANGENT = 5;
-
     glBindVertexArray(mVaoId);
     if(mVerticesId != 0)
     {
         glBindBuffer(GL_ARRAY_BUFFER, mVerticesId);
-        glVertexAttribPointer(POSITION, mVerticesStride, GL_FLOAT, GL_FALSE, 0, 0);
+        glVertexAttribPointer(POSITION, mVerticesStride, mVerticesType, mVerticesType != GL_FLOAT, 0, 0);
         glEnableVertexAttribArray(POSITION);
     }
     if(mNormalsId != 0)
     {
         glBindBuffer(GL_ARRAY_BUFFER, mNormalsId);
-        glVertexAttribPointer(NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        if(mOctNormals)
+        {
+            glVertexAttribPointer(NORMAL, 2, GL_SHORT, GL_TRUE, 0, 0);
+        }
+        else
+        {
+            glVertexAttribPointer(NORMAL, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        }
         glEnableVertexAttribArray(NORMAL);
     }
     if(mColorsId != 0)
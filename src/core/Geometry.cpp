@@ -1,7 +1,13 @@
 //Definition include
 #include "Geometry.h"
 
+//Qt includes
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
 //Dependency includes
+#include "glm/common.hpp"
 #include "glm/exponential.hpp"
 #include "glm/geometric.hpp"
 #include "Miniball.h"
@@ -10,14 +16,168 @@
 #include "Debug.h"
 #include "GPUGeometry.h"
 #include "Scene.h"
+#include "TerrainTileCache.h"
+
+/// Directions of the extremal points that are the candidates of the bounding sphere, the first three give the bounding box
+const int NUMBER_OF_DIRECTIONS = 13;
+const float DIRECTIONS[NUMBER_OF_DIRECTIONS][3] = {
+    { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },
+    { 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f, -1.0f }, { 1.0f, -1.0f, 1.0f }, { 1.0f, -1.0f, -1.0f },
+    { 1.0f, 1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { 1.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, -1.0f },
+    { 0.0f, 1.0f, 1.0f }, { 0.0f, 1.0f, -1.0f }
+};
+/// Meshes with more vertices compute their bounding volumes with several threads
+const int PARALLEL_BOUNDING_VOLUMES_VERTICES = 1 << 20;
+/// Points farther than the radius by this factor are added to the candidates of the exact bounding sphere
+const float BOUNDING_SPHERE_TOLERANCE = 1.0f + 1e-5f;
+/// Iterations adding candidates before the exact bounding sphere is computed with all the vertices
+const int MAX_BOUNDING_SPHERE_ITERATIONS = 32;
+
+/// Extremal vertices along every direction of a range of vertices
+struct ExtremalVertices
+{
+    float minimum[NUMBER_OF_DIRECTIONS];
+    float maximum[NUMBER_OF_DIRECTIONS];
+    int minimumVertex[NUMBER_OF_DIRECTIONS];
+    int maximumVertex[NUMBER_OF_DIRECTIONS];
+};
+
+/// Get the position of the vertex \param pVertex, the missing coordinates are 0
+static inline glm::vec3 GetPosition(const float* pData, unsigned int pStride, int pVertex)
+{
+    const float* position = pData + pVertex * pStride;
+    return glm::vec3( position[0], position[1], pStride > 2 ? position[2] : 0.0f );
+}
+
+/// Task that finds the extremal vertices of a range of vertices
+class GeometryExtremalVerticesTask : public QRunnable
+{
+public:
+    GeometryExtremalVerticesTask(const float* pData, unsigned int pStride, int pFirst, int pLast, ExtremalVertices* pResult):
+        mData(pData), mStride(pStride), mFirst(pFirst), mLast(pLast), mResult(pResult)
+    {
+
+    }
+
+    void run()
+    {
+        for( int j = 0; j < NUMBER_OF_DIRECTIONS; j++ )
+        {
+            mResult->minimum[j] = FLT_MAX;
+            mResult->maximum[j] = -FLT_MAX;
+            mResult->minimumVertex[j] = mFirst;
+            mResult->maximumVertex[j] = mFirst;
+        }
+        for( int i = mFirst; i < mLast; i++ )
+        {
+            glm::vec3 position = GetPosition(mData, mStride, i);
+            for( int j = 0; j < NUMBER_OF_DIRECTIONS; j++ )
+            {
+                float projection = position.x * DIRECTIONS[j][0] + position.y * DIRECTIONS[j][1] + position.z * DIRECTIONS[j][2];
+                if( projection < mResult->minimum[j] )
+                {
+                    mResult->minimum[j] = projection;
+                    mResult->minimumVertex[j] = i;
+                }
+                if( projection > mResult->maximum[j] )
+                {
+                    mResult->maximum[j] = projection;
+                    mResult->maximumVertex[j] = i;
+                }
+            }
+        }
+    }
+
+private:
+    const float* mData;
+    unsigned int mStride;
+    int mFirst;
+    int mLast;
+    ExtremalVertices* mResult;
+};
+
+/// Task that finds the farthest vertex from a point in a range of vertices
+class GeometryFarthestVertexTask : public QRunnable
+{
+public:
+    GeometryFarthestVertexTask(const float* pData, unsigned int pStride, int pFirst, int pLast, const glm::vec3& pPoint, int* pResult):
+        mData(pData), mStride(pStride), mFirst(pFirst), mLast(pLast), mPoint(pPoint), mResult(pResult)
+    {
+
+    }
+
+    void run()
+    {
+        float farthestDistance = -1.0f;
+        for( int i = mFirst; i < mLast; i++ )
+        {
+            glm::vec3 difference = GetPosition(mData, mStride, i) - mPoint;
+            float distance = glm::dot(difference, difference);
+            if( distance > farthestDistance )
+            {
+                farthestDistance = distance;
+                *mResult = i;
+            }
+        }
+    }
+
+private:
+    const float* mData;
+    unsigned int mStride;
+    int mFirst;
+    int mLast;
+    glm::vec3 mPoint;
+    int* mResult;
+};
+
+/// Run the tasks \param pTasks and delete them, with a pool of threads if there is more than one.
+/// A local pool is used because the meshes can be loaded from tasks of the global one.
+static void RunTasks(const QVector<QRunnable*>& pTasks)
+{
+    if( pTasks.size() == 1 )
+    {
+        pTasks.at(0)->run();
+        delete pTasks.at(0);
+    }
+    else
+    {
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount( pTasks.size() );
+        for( int i = 0; i < pTasks.size(); i++ )
+        {
+            threadPool.start( pTasks.at(i) );
+        }
+        threadPool.waitForDone();
+    }
+}
+
+/// Compute the minimum sphere that encloses the vertices \param pVertices
+static void ComputeMinimumSphere(const float* pData, unsigned int pStride, const QVector<int>& pVertices, glm::vec3& pCenter, float& pRadius)
+{
+    Miniball<3> mb;
+    Point<3> p;
+    for( int i = 0; i < pVertices.size(); i++ )
+    {
+        glm::vec3 position = GetPosition(pData, pStride, pVertices.at(i));
+        p[0] = position.x;
+        p[1] = position.y;
+        p[2] = position.z;
+        mb.check_in(p);
+    }
+    mb.build();
+    pCenter = glm::vec3( mb.center()[0], mb.center()[1], mb.center()[2] );
+    pRadius = glm::sqrt( mb.squared_radius() );
+}
 
 Geometry::Geometry(const QString &pName, Topology pT):
     mVertexData(), mVertexStride(3), mNormalData(),
     mColorData(), mColorStride(3), mTextCoordsData(),
     mTangentData(), mBitangentData(), mIndexData(),
-    mAreasOfPolygons(), mVisible(true), mName(pName),
+    mAreasOfPolygons(), mVisible(true), mCompactStorage(false), mReleaseAttributesAfterUpload(false), mAttributesReleased(false),
+    mApproximateBoundingSphere(false), mBoundingSphereErrorBound(0.0f), mName(pName),
     mTopology(pT), mNeedGPUGeometryUpdate(false),
-    mMaterial(NULL), mBoundingBox(NULL), mBoundingSphere(NULL), mGPUGeometry(NULL)
+    mMaterial(NULL), mBoundingBox(NULL), mBoundingSphere(NULL), mGPUGeometry(NULL),
+    mTileCache(NULL), mResident(true), mNumberOfIndicesOnDisk(0), mNumberOfVerticesOnDisk(0)
 {
 
 }
@@ -26,8 +186,11 @@ Geometry::Geometry(const Geometry& pGeometry):
     mVertexData(pGeometry.mVertexData), mVertexStride(pGeometry.mVertexStride), mNormalData(pGeometry.mNormalData),
     mColorData(pGeometry.mColorData), mColorStride(pGeometry.mColorStride), mTextCoordsData(pGeometry.mTextCoordsData),
     mTangentData(pGeometry.mTangentData), mBitangentData(pGeometry.mBitangentData), mIndexData(pGeometry.mIndexData),
-    mAreasOfPolygons(pGeometry.mAreasOfPolygons), mVisible(pGeometry.mVisible), mName(pGeometry.mName),
-    mTopology(pGeometry.mTopology), mNeedGPUGeometryUpdate(true)
+    mAreasOfPolygons(pGeometry.mAreasOfPolygons), mVisible(pGeometry.mVisible), mCompactStorage(pGeometry.mCompactStorage),
+    mReleaseAttributesAfterUpload(pGeometry.mReleaseAttributesAfterUpload), mAttributesReleased(false), mApproximateBoundingSphere(pGeometry.mApproximateBoundingSphere),
+    mBoundingSphereErrorBound(pGeometry.mBoundingSphereErrorBound), mName(pGeometry.mName),
+    mTopology(pGeometry.mTopology), mNeedGPUGeometryUpdate(true),
+    mTileCache(NULL), mResident(true), mNumberOfIndicesOnDisk(0), mNumberOfVerticesOnDisk(0)
 {
     if(pGeometry.mMaterial != NULL)
     {
@@ -55,14 +218,26 @@ Geometry::Geometry(const Geometry& pGeometry):
     {
         mBoundingSphere = NULL;
     }
-    mGPUGeometry = NULL;
+
+    //The released attributes are only in the buffers of the original, so they are shared instead of uploaded again
+    if( pGeometry.mAttributesReleased && pGeometry.mGPUGeometry != NULL )
+    {
+        mGPUGeometry = pGeometry.mGPUGeometry;
+        mGPUGeometry->AddReference();
+        mAttributesReleased = true;
+        mNeedGPUGeometryUpdate = false;
+    }
+    else
+    {
+        mGPUGeometry = NULL;
+    }
 }
 
 Geometry::~Geometry()
 {
     delete mBoundingBox;
     delete mBoundingSphere;
-    delete mGPUGeometry;
+    ReleaseGPUGeometry();
     delete mMaterial;
 }
 
@@ -174,7 +349,7 @@ void Geometry::SetBitangentData(unsigned int pSize, const glm::vec3 *pData)
     {
         mBitangentData[i*3] = pData[i].x;
         mBitangentData[i*3+1] = pData[i].y;
-        mBitangentData[i*3+1] = pData[i].z;
+        mBitangentData[i*3+2] = pData[i].z;
     }
     mNeedGPUGeometryUpdate = true;
 }
@@ -189,7 +364,32 @@ void Geometry::SetIndexsData(unsigned int pSize, const unsigned int *pData)
     mNeedGPUGeometryUpdate = true;
 }
 
-QVector<float> Geometry::GetVerticesData() const
+void Geometry::SetVerticesData(const QVector<float>& pData, unsigned int pStride)
+{
+    mVertexData = pData;
+    mVertexStride = pStride;
+    mNeedGPUGeometryUpdate = true;
+}
+
+void Geometry::SetNormalsData(const QVector<float>& pData)
+{
+    mNormalData = pData;
+    mNeedGPUGeometryUpdate = true;
+}
+
+void Geometry::SetTextCoordsData(const QVector<float>& pData)
+{
+    mTextCoordsData = pData;
+    mNeedGPUGeometryUpdate = true;
+}
+
+void Geometry::SetIndexsData(const QVector<unsigned int>& pData)
+{
+    mIndexData = pData;
+    mNeedGPUGeometryUpdate = true;
+}
+
+const QVector<float>& Geometry::GetVerticesData() const
 {
     return mVertexData;
 }
@@ -204,6 +404,11 @@ void Geometry::SetName(const QString &pName)
     mName = pName;
 }
 
+QString Geometry::GetName() const
+{
+    return mName;
+}
+
 void Geometry::SetTopology( Topology pTopology )
 {
     mTopology = pTopology;
@@ -225,56 +430,166 @@ void Geometry::SetVisible(bool pVisible)
     mVisible = pVisible;
 }
 
+bool Geometry::IsVisible() const
+{
+    return mVisible;
+}
+
+void Geometry::SetCompactStorage(bool pCompactStorage)
+{
+    mCompactStorage = pCompactStorage;
+    mNeedGPUGeometryUpdate = true;
+}
+
+bool Geometry::IsCompactStorage() const
+{
+    return mCompactStorage;
+}
+
+void Geometry::SetReleaseAttributesAfterUpload(bool pRelease)
+{
+    mReleaseAttributesAfterUpload = pRelease;
+}
+
+void Geometry::SetApproximateBoundingSphere(bool pApproximate)
+{
+    mApproximateBoundingSphere = pApproximate;
+}
+
+void Geometry::MakeResident()
+{
+    if( mTileCache != NULL )
+    {
+        mTileCache->Request(this);
+    }
+}
+
 void Geometry::ComputeBoundingVolumes()
 {
-    glm::vec3 min(FLT_MAX);
-    glm::vec3 max(-FLT_MAX);
+    glm::vec3 min(0.0f);
+    glm::vec3 max(0.0f);
+    glm::vec3 sphereCenter(0.0f);
+    float sphereRadius = 0.0f;
+    mBoundingSphereErrorBound = 0.0f;
 
-    Miniball<3> mb;
-    Point<3> p;
-    for( int i = 0; i < mVertexData.size(); i += mVertexStride )
+    int numberOfVertices = mVertexData.size() / mVertexStride;
+    if( numberOfVertices > 0 )
     {
-        p[0] = mVertexData.at(i);
-        p[1] = mVertexData.at(i+1);
-        if( mVertexStride > 2 )
+        const float* data = mVertexData.constData();
+        int numberOfChunks = 1;
+        if( numberOfVertices > PARALLEL_BOUNDING_VOLUMES_VERTICES )
         {
-            p[2] = mVertexData.at(i+2);
+            numberOfChunks = glm::max( QThread::idealThreadCount(), 1 );
         }
-        else
-        {
-            p[2] = 0.0f;
-        }
-        mb.check_in(p);
+        int chunkSize = ( numberOfVertices + numberOfChunks - 1 ) / numberOfChunks;
 
-        if(mVertexData.at(i) <  min.x)
+        //Bounding box and candidates of the bounding sphere in a single pass
+        QVector<ExtremalVertices> extremalVertices(numberOfChunks);
+        QVector<QRunnable*> tasks(numberOfChunks);
+        for( int i = 0; i < numberOfChunks; i++ )
         {
-            min.x = mVertexData.at(i);
+            tasks[i] = new GeometryExtremalVerticesTask( data, mVertexStride, i * chunkSize, glm::min( (i + 1) * chunkSize, numberOfVertices ), &extremalVertices[i] );
         }
-        if(mVertexData.at(i) > max.x)
-        {
-            max.x = mVertexData.at(i);
-        }
-        if(mVertexData.at(i+1) <  min.y)
+        RunTasks(tasks);
+
+        QVector<int> candidates;
+        for( int j = 0; j < NUMBER_OF_DIRECTIONS; j++ )
         {
-            min.y = mVertexData.at(i+1);
+            int minimumChunk = 0;
+            int maximumChunk = 0;
+            for( int i = 1; i < numberOfChunks; i++ )
+            {
+                if( extremalVertices.at(i).minimum[j] < extremalVertices.at(minimumChunk).minimum[j] )
+                {
+                    minimumChunk = i;
+                }
+                if( extremalVertices.at(i).maximum[j] > extremalVertices.at(maximumChunk).maximum[j] )
+                {
+                    maximumChunk = i;
+                }
+            }
+            if( j < 3 )
+            {
+                min[j] = extremalVertices.at(minimumChunk).minimum[j];
+                max[j] = extremalVertices.at(maximumChunk).maximum[j];
+            }
+            if( !candidates.contains( extremalVertices.at(minimumChunk).minimumVertex[j] ) )
+            {
+                candidates.push_back( extremalVertices.at(minimumChunk).minimumVertex[j] );
+            }
+            if( !candidates.contains( extremalVertices.at(maximumChunk).maximumVertex[j] ) )
+            {
+                candidates.push_back( extremalVertices.at(maximumChunk).maximumVertex[j] );
+            }
         }
-        if(mVertexData.at(i+1) > max.y)
+
+        //The minimum sphere of the candidates is a lower bound of the minimum sphere of the mesh
+        ComputeMinimumSphere(data, mVertexStride, candidates, sphereCenter, sphereRadius);
+        float candidatesRadius = sphereRadius;
+        if( mApproximateBoundingSphere )
         {
-            max.y = mVertexData.at(i+1);
+            //Grow the sphere to enclose the vertices outside, like Ritter's algorithm
+            float squaredRadius = sphereRadius * sphereRadius;
+            for( int i = 0; i < numberOfVertices; i++ )
+            {
+                glm::vec3 position = GetPosition(data, mVertexStride, i);
+                glm::vec3 difference = position - sphereCenter;
+                float squaredDistance = glm::dot(difference, difference);
+                if( squaredDistance > squaredRadius )
+                {
+                    float distance = glm::sqrt(squaredDistance);
+                    float newRadius = ( sphereRadius + distance ) * 0.5f;
+                    sphereCenter += difference * ( ( newRadius - sphereRadius ) / distance );
+                    sphereRadius = newRadius;
+                    squaredRadius = sphereRadius * sphereRadius;
+                }
+            }
+            if( candidatesRadius > 0.0f )
+            {
+                mBoundingSphereErrorBound = sphereRadius / candidatesRadius - 1.0f;
+            }
         }
-        if( mVertexStride > 2 )
+        else
         {
-            if(mVertexData.at(i+2) <  min.z)
+            //Add the farthest vertex of every chunk until all the vertices are inside the sphere of the candidates
+            bool enclosed = false;
+            QVector<int> farthestVertices(numberOfChunks);
+            for( int iteration = 0; iteration < MAX_BOUNDING_SPHERE_ITERATIONS && !enclosed; iteration++ )
             {
-                min.z = mVertexData.at(i+2);
+                for( int i = 0; i < numberOfChunks; i++ )
+                {
+                    tasks[i] = new GeometryFarthestVertexTask( data, mVertexStride, i * chunkSize, glm::min( (i + 1) * chunkSize, numberOfVertices ), sphereCenter, &farthestVertices[i] );
+                }
+                RunTasks(tasks);
+
+                enclosed = true;
+                float tolerance = sphereRadius * BOUNDING_SPHERE_TOLERANCE + FLT_EPSILON;
+                for( int i = 0; i < numberOfChunks; i++ )
+                {
+                    int vertex = farthestVertices.at(i);
+                    if( glm::distance( GetPosition(data, mVertexStride, vertex), sphereCenter ) > tolerance && !candidates.contains(vertex) )
+                    {
+                        candidates.push_back(vertex);
+                        enclosed = false;
+                    }
+                }
+                if( !enclosed )
+                {
+                    ComputeMinimumSphere(data, mVertexStride, candidates, sphereCenter, sphereRadius);
+                }
             }
-            if(mVertexData.at(i+2) > max.z)
+            if( !enclosed )
             {
-                max.z = mVertexData.at(i+2);
+                QVector<int> vertices(numberOfVertices);
+                for( int i = 0; i < numberOfVertices; i++ )
+                {
+                    vertices[i] = i;
+                }
+                ComputeMinimumSphere(data, mVertexStride, vertices, sphereCenter, sphereRadius);
             }
         }
     }
-    mb.build();
+
     if(mBoundingBox == NULL)
     {
         mBoundingBox = new AxisAlignedBoundingBox();
@@ -285,19 +600,8 @@ void Geometry::ComputeBoundingVolumes()
     }
     mBoundingBox->SetMax(max);
     mBoundingBox->SetMin(min);
-    glm::vec3 sphereCenter;
-    sphereCenter.x = mb.center()[0];
-    sphereCenter.y = mb.center()[1];
-    sphereCenter.z = mb.center()[2];
-    if(!mb.is_valid())
-    {
-        double slack;
-        double error = mb.accuracy(slack);
-        Debug::Warning(QString("Bounding sphere in geometry %1 may be invalid. Accuracy: %2").arg(mName).arg(error));
-    }
-
     mBoundingSphere->SetCenter(sphereCenter);
-    mBoundingSphere->SetRadius(glm::sqrt(mb.squared_radius()));
+    mBoundingSphere->SetRadius(sphereRadius);
 }
 
 void Geometry::ShowInformation() const
@@ -306,6 +610,10 @@ void Geometry::ShowInformation() const
     Debug::Log(QString("   Number of faces: %1").arg(GetNumFaces()));
     Debug::Log(QString("   Number of vertices: %1").arg(GetNumVertices()));
     Debug::Log(QString("   Diameter: %1").arg(mBoundingSphere->GetRadius()*2));
+    if(mApproximateBoundingSphere)
+    {
+        Debug::Log(QString("   Approximate bounding sphere at most %1% bigger than the minimum one").arg(mBoundingSphereErrorBound * 100.0f));
+    }
 }
 
 void Geometry::ComputeAreasOfPolygons()
@@ -345,36 +653,41 @@ void Geometry::Draw()
 {
     if(mVisible)
     {
-        GetGPUGeometry()->Draw();
+        MakeResident();
+        if(mResident)
+        {
+            GetGPUGeometry()->Draw();
+        }
     }
 }
 
 int Geometry::GetNumIndices() const
 {
-    return mIndexData.size();
+    return mResident ? mIndexData.size() : mNumberOfIndicesOnDisk;
 }
 
 int Geometry::GetNumFaces() const
 {
+    int numberOfIndices = GetNumIndices();
     if( mTopology == Triangles )
     {
-        return mIndexData.size() / 3;
+        return numberOfIndices / 3;
     }
     else if( mTopology == Lines )
     {
-        return mIndexData.size() / 2;
+        return numberOfIndices / 2;
     }
     else if( mTopology == Points )
     {
-        return mIndexData.size();
+        return numberOfIndices;
     }
     else if( mTopology == Line_Strip )
     {
-        return mIndexData.size() - 1;
+        return numberOfIndices - 1;
     }
     else if( mTopology == Line_Loop )
     {
-        return mIndexData.size();
+        return numberOfIndices;
     }
     else
     {
@@ -385,7 +698,7 @@ int Geometry::GetNumFaces() const
 
 int Geometry::GetNumVertices() const
 {
-    return mVertexData.size() / mVertexStride;
+    return mResident ? mVertexData.size() / mVertexStride : mNumberOfVerticesOnDisk;
 }
 
 Geometry::Topology Geometry::GetTopology() const
@@ -405,6 +718,14 @@ unsigned int Geometry::GetValueOfIndex(int pPosition) const
     return mIndexData.at(pPosition);
 }
 
+void Geometry::AddContentToHash(QCryptographicHash& pHash) const
+{
+    qint32 header[2] = { mTopology, (qint32)mVertexStride };
+    pHash.addData( (const char*)header, sizeof(header) );
+    pHash.addData( (const char*)mVertexData.constData(), mVertexData.size() * sizeof(float) );
+    pHash.addData( (const char*)mIndexData.constData(), mIndexData.size() * sizeof(unsigned int) );
+}
+
 void Geometry::Normalize(const glm::vec3 &pCenter, float pRadius)
 {
     if(mVertexStride >= 3)
@@ -446,26 +767,117 @@ const GPUGeometry *Geometry::GetGPUGeometry()
 {
     if(mGPUGeometry == NULL || mNeedGPUGeometryUpdate)
     {
-        if( mGPUGeometry != NULL )
+        //If the attributes have been released they are only in the buffers of the current GPUGeometry,
+        //so it is kept and only the positions and the indices are uploaded again, unless a copy shares it
+        if( mGPUGeometry != NULL && ( !mAttributesReleased || mGPUGeometry->IsShared() ) )
         {
-            delete mGPUGeometry;
+            if( mAttributesReleased )
+            {
+                Debug::Warning( QString("Geometry::GetGPUGeometry - The buffers of %1 are shared with a copy, its released attributes are lost").arg(mName) );
+                mAttributesReleased = false;
+            }
+            ReleaseGPUGeometry();
         }
         CHECK_GL_ERROR();
-        mGPUGeometry = new GPUGeometry();
-        mGPUGeometry->SetVerticesData( mVertexData.size(), mVertexStride, mVertexData.data() );
-        if(mNormalData.size() > 0)
-            mGPUGeometry->SetNormalsData(mNormalData.size(), mNormalData.data() );
-        mGPUGeometry->SetIndexsData(mIndexData.size(), mTopology, mIndexData.data() );
+        if( mGPUGeometry == NULL )
+        {
+            mGPUGeometry = new GPUGeometry();
+        }
+        //The compact format needs the bounding box to quantize the positions
+        bool compact = mCompactStorage && mVertexStride == 3 && mBoundingBox != NULL;
+        if(compact)
+        {
+            UploadCompactGPUGeometry();
+        }
+        else
+        {
+            mGPUGeometry->SetVerticesData( mVertexData.size(), mVertexStride, mVertexData.constData() );
+            if(mNormalData.size() > 0)
+                mGPUGeometry->SetNormalsData(mNormalData.size(), mNormalData.constData() );
+            mGPUGeometry->SetIndexsData(mIndexData.size(), mTopology, mIndexData.constData() );
+        }
         if(mColorData.size() > 0)
-            mGPUGeometry->SetColorData(mColorData.size(), mColorStride, mColorData.data() );
+            mGPUGeometry->SetColorData(mColorData.size(), mColorStride, mColorData.constData() );
         if(mTextCoordsData.size() > 0)
-            mGPUGeometry->SetTextCoordsData(mTextCoordsData.size(), mTextCoordsData.data() );
-        if(mTangentData.size() > 0)
-            mGPUGeometry->SetTangentData(mTangentData.size(), mTangentData.data() );
-        if(mBitangentData.size() > 0)
-            mGPUGeometry->SetBitangentData(mBitangentData.size(), mBitangentData.data() );
+            mGPUGeometry->SetTextCoordsData(mTextCoordsData.size(), mTextCoordsData.constData() );
+        if(!compact && mTangentData.size() > 0)
+            mGPUGeometry->SetTangentData(mTangentData.size(), mTangentData.constData() );
+        if(!compact && mBitangentData.size() > 0)
+            mGPUGeometry->SetBitangentData(mBitangentData.size(), mBitangentData.constData() );
         mGPUGeometry->ConfigureVAO();
         mNeedGPUGeometryUpdate = false;
+
+        if(mReleaseAttributesAfterUpload)
+        {
+            mNormalData = QVector<float>();
+            mColorData = QVector<float>();
+            mTextCoordsData = QVector<float>();
+            mTangentData = QVector<float>();
+            mBitangentData = QVector<float>();
+            mAttributesReleased = true;
+        }
     }
     return mGPUGeometry;
 }
+
+void Geometry::ReleaseGPUGeometry()
+{
+    GPUGeometry::Release(mGPUGeometry);
+    mGPUGeometry = NULL;
+}
+
+void Geometry::UploadCompactGPUGeometry()
+{
+    glm::vec3 offset = mBoundingBox->GetMin();
+    glm::vec3 scale = mBoundingBox->GetMax() - offset;
+    glm::vec3 inverseScale;
+    for( int i = 0; i < 3; i++ )
+    {
+        inverseScale[i] = ( scale[i] > 0.0f ) ? 65535.0f / scale[i] : 0.0f;
+    }
+    QVector<unsigned short> vertexData(mVertexData.size());
+    for( int i = 0; i < mVertexData.size(); i++ )
+    {
+        float value = ( mVertexData.at(i) - offset[i % 3] ) * inverseScale[i % 3];
+        vertexData[i] = (unsigned short)glm::clamp(value + 0.5f, 0.0f, 65535.0f);
+    }
+    mGPUGeometry->SetVerticesData(vertexData.size(), vertexData.data(), offset, scale);
+
+    if(mNormalData.size() > 0)
+    {
+        //Octahedral mapping: the normal is projected onto the octahedron and the lower half is folded over the upper one
+        QVector<short> normalData( mNormalData.size() / 3 * 2 );
+        for( int i = 0; i < mNormalData.size() / 3; i++ )
+        {
+            glm::vec3 normal(mNormalData.at(i*3), mNormalData.at(i*3+1), mNormalData.at(i*3+2));
+            float norm = glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z);
+            glm::vec2 encoded(0.0f);
+            if( norm > 0.0f )
+            {
+                encoded = glm::vec2(normal.x, normal.y) / norm;
+                if( normal.z < 0.0f )
+                {
+                    glm::vec2 signs( encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f );
+                    encoded = ( 1.0f - glm::abs( glm::vec2(encoded.y, encoded.x) ) ) * signs;
+                }
+            }
+            normalData[i*2] = (short)glm::round(encoded.x * 32767.0f);
+            normalData[i*2+1] = (short)glm::round(encoded.y * 32767.0f);
+        }
+        mGPUGeometry->SetNormalsData(normalData.size(), normalData.data());
+    }
+
+    if(GetNumVertices() <= 65536)
+    {
+        QVector<unsigned short> indexData(mIndexData.size());
+        for( int i = 0; i < mIndexData.size(); i++ )
+        {
+            indexData[i] = mIndexData.at(i);
+        }
+        mGPUGeometry->SetIndexsData(indexData.size(), mTopology, indexData.data());
+    }
+    else
+    {
+        mGPUGeometry->SetIndexsData(mIndexData.size(), mTopology, mIndexData.constData());
+    }
+}
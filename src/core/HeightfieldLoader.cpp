@@ -0,0 +1,350 @@
+//Definition include
+#include "HeightfieldLoader.h"
+
+//System includes
+#include <float.h>
+
+//Qt includes
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTime>
+#include <QtEndian>
+
+//Dependency includes
+#include "glm/common.hpp"
+#include "glm/exponential.hpp"
+#include "glm/geometric.hpp"
+
+//Project includes
+#include "Debug.h"
+#include "TerrainTileCache.h"
+#include "Tools.h"
+
+/// Value used for the samples without elevation when the format does not define one
+const float DEFAULT_NO_DATA = -FLT_MAX;
+/// Spacing in meters of the SRTM tiles of 1 and 3 arc-seconds
+const float SRTM1_CELL_SIZE = 30.0f;
+const float SRTM3_CELL_SIZE = 90.0f;
+/// Grids with more samples are split into tiles that are paged in from disk when they are used
+const int TILING_THRESHOLD = 4096 * 4096;
+/// Number of cells of the side of a tile, less than 256 so every tile fits in 16-bit indices
+const int TILE_SIZE = 255;
+/// Memory that the resident tiles can use before the least recently used ones are paged out
+const qint64 TILE_MEMORY_BUDGET = 512 * 1024 * 1024;
+
+static void SkipWhitespace(const char*& pText, const char* pEnd)
+{
+    while( pText < pEnd && ( *pText == ' ' || *pText == '\t' || *pText == '\r' || *pText == '\n' ) )
+    {
+        pText++;
+    }
+}
+
+bool HeightfieldLoader::IsHeightfield(const QString& pPath)
+{
+    QString suffix = QFileInfo(pPath).suffix().toLower();
+    return ( suffix == "asc" || suffix == "hgt" || suffix == "f32" || suffix == "raw" );
+}
+
+Scene* HeightfieldLoader::LoadScene(const QString& pPath)
+{
+    QTime t;
+    t.start();
+
+    QFileInfo fileInfo(pPath);
+    QString suffix = fileInfo.suffix().toLower();
+    Grid grid;
+    grid.columns = 0;
+    grid.rows = 0;
+    grid.cellSize = 1.0f;
+    grid.noData = DEFAULT_NO_DATA;
+
+    bool loaded = false;
+    if( suffix == "asc" )
+    {
+        loaded = ReadAsciiGrid(pPath, grid);
+    }
+    else if( suffix == "hgt" )
+    {
+        loaded = ReadHgt(pPath, grid);
+    }
+    else
+    {
+        loaded = ReadRawFloat(pPath, grid);
+    }
+    if( !loaded || grid.columns < 2 || grid.rows < 2 )
+    {
+        Debug::Error( QString("Impossible to load the elevation model %1").arg(pPath) );
+        return NULL;
+    }
+    Debug::Log( QString("HeightfieldLoader::LoadScene - Grid of %1 x %2 samples read in %3 ms").arg(grid.columns).arg(grid.rows).arg( t.elapsed() ) );
+
+    //The samples without elevation get the lowest one so the normals of their neighbours are defined
+    float lowest = FLT_MAX;
+    for( int i = 0; i < grid.heights.size(); i++ )
+    {
+        if( IsValid(grid, i) )
+        {
+            lowest = glm::min(lowest, grid.heights.at(i));
+        }
+    }
+    if( lowest == FLT_MAX )
+    {
+        lowest = 0.0f;
+    }
+
+    Scene* scene;
+    if( grid.columns * grid.rows <= TILING_THRESHOLD )
+    {
+        QVector<Geometry *> meshes(1);
+        meshes[0] = CreateGeometry(fileInfo.baseName(), grid, lowest, 0, 0, grid.columns, grid.rows);
+        scene = new Scene( fileInfo.baseName(), meshes );
+    }
+    else
+    {
+        //Neighbouring tiles share their border samples, and the polygons are numbered tile after tile
+        QString directory = GetTileDirectory(fileInfo);
+        TerrainTileCache* tileCache = new TerrainTileCache(directory, TILE_MEMORY_BUDGET);
+        QVector<Geometry *> meshes;
+        for( int firstRow = 0; firstRow < grid.rows - 1; firstRow += TILE_SIZE )
+        {
+            for( int firstColumn = 0; firstColumn < grid.columns - 1; firstColumn += TILE_SIZE )
+            {
+                int columns = glm::min(TILE_SIZE + 1, grid.columns - firstColumn);
+                int rows = glm::min(TILE_SIZE + 1, grid.rows - firstRow);
+                int row = firstRow / TILE_SIZE;
+                int column = firstColumn / TILE_SIZE;
+                Geometry* mesh = CreateGeometry( QString("%1_%2_%3").arg( fileInfo.baseName() ).arg(row).arg(column), grid, lowest, firstColumn, firstRow, columns, rows );
+                tileCache->AddTile(mesh, row, column);
+                meshes.push_back(mesh);
+            }
+        }
+        Debug::Log( QString("HeightfieldLoader::LoadScene - %1 tiles written into %2").arg( tileCache->GetNumberOfTiles() ).arg(directory) );
+        scene = new Scene( fileInfo.baseName(), meshes );
+        scene->SetTileCache(tileCache);
+    }
+    Debug::Log( QString("HeightfieldLoader::LoadScene - Total time elapsed: %1 ms").arg( t.elapsed() ) );
+    return scene;
+}
+
+QString HeightfieldLoader::GetTileDirectory(const QFileInfo& pFileInfo)
+{
+    //Keyed like the scene cache, so terrains with the same name or different versions of a file do not share tiles
+    QByteArray key = pFileInfo.absoluteFilePath().toUtf8();
+    key += QByteArray::number( pFileInfo.size() );
+    key += QByteArray::number( pFileInfo.lastModified().toMSecsSinceEpoch() );
+    QString name = QString( QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex() );
+    return QDir( Tools::GetProgramPath() ).filePath( QString("TerrainTiles/%1").arg(name) );
+}
+
+bool HeightfieldLoader::ReadAsciiGrid(const QString& pPath, Grid& pGrid)
+{
+    QFile file(pPath);
+    if( !file.open(QFile::ReadOnly) )
+    {
+        return false;
+    }
+    QByteArray content = file.readAll();
+    const char* current = content.constData();
+    const char* end = current + content.size();
+
+    //Header with a keyword and a value per line
+    while( true )
+    {
+        SkipWhitespace(current, end);
+        if( current == end || !( ( *current >= 'a' && *current <= 'z' ) || ( *current >= 'A' && *current <= 'Z' ) ) )
+        {
+            break;
+        }
+        const char* keywordStart = current;
+        while( current < end && *current != ' ' && *current != '\t' )
+        {
+            current++;
+        }
+        QByteArray keyword = QByteArray(keywordStart, current - keywordStart).toLower();
+        SkipWhitespace(current, end);
+        float value;
+        if( !Tools::ParseFloat(current, end, value) )
+        {
+            return false;
+        }
+
+        if( keyword == "ncols" )
+        {
+            pGrid.columns = (int)value;
+        }
+        else if( keyword == "nrows" )
+        {
+            pGrid.rows = (int)value;
+        }
+        else if( keyword == "cellsize" )
+        {
+            pGrid.cellSize = value;
+        }
+        else if( keyword == "nodata_value" )
+        {
+            pGrid.noData = value;
+        }
+    }
+    if( pGrid.columns <= 0 || pGrid.rows <= 0 )
+    {
+        return false;
+    }
+
+    int numberOfSamples = pGrid.columns * pGrid.rows;
+    pGrid.heights.resize(numberOfSamples);
+    for( int i = 0; i < numberOfSamples; i++ )
+    {
+        SkipWhitespace(current, end);
+        if( !Tools::ParseFloat(current, end, pGrid.heights[i]) )
+        {
+            Debug::Warning( QString("The elevation model %1 has %2 samples instead of %3").arg(pPath).arg(i).arg(numberOfSamples) );
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HeightfieldLoader::ReadHgt(const QString& pPath, Grid& pGrid)
+{
+    QFile file(pPath);
+    if( !file.open(QFile::ReadOnly) )
+    {
+        return false;
+    }
+    //The tiles are square and their size is given by the file size
+    int side = glm::round( glm::sqrt( file.size() / 2.0 ) );
+    if( (qint64)side * side * 2 != file.size() )
+    {
+        return false;
+    }
+    QByteArray content = file.readAll();
+    const uchar* samples = (const uchar*)content.constData();
+
+    pGrid.columns = side;
+    pGrid.rows = side;
+    pGrid.cellSize = ( side > 1201 ) ? SRTM1_CELL_SIZE : SRTM3_CELL_SIZE;
+    pGrid.noData = -32768.0f;
+    pGrid.heights.resize(side * side);
+    for( int i = 0; i < side * side; i++ )
+    {
+        pGrid.heights[i] = qFromBigEndian<qint16>(samples + i * 2);
+    }
+    return true;
+}
+
+bool HeightfieldLoader::ReadRawFloat(const QString& pPath, Grid& pGrid)
+{
+    QFile file(pPath);
+    if( !file.open(QFile::ReadOnly) )
+    {
+        return false;
+    }
+    int side = glm::round( glm::sqrt( file.size() / 4.0 ) );
+    if( (qint64)side * side * 4 != file.size() )
+    {
+        Debug::Warning( QString("The tile %1 is not a square of 32-bit floats").arg(pPath) );
+        return false;
+    }
+    pGrid.columns = side;
+    pGrid.rows = side;
+    pGrid.heights.resize(side * side);
+    return file.read( (char*)pGrid.heights.data(), file.size() ) == file.size();
+}
+
+bool HeightfieldLoader::IsValid(const Grid& pGrid, int pSample)
+{
+    float height = pGrid.heights.at(pSample);
+    return ( height == height && height != pGrid.noData );
+}
+
+Geometry* HeightfieldLoader::CreateGeometry(const QString& pName, const Grid& pGrid, float pLowest, int pFirstColumn, int pFirstRow, int pColumns, int pRows)
+{
+    int numberOfSamples = pColumns * pRows;
+    float cellSize = pGrid.cellSize;
+
+    //Heights of the samples of the mesh with a border of one sample, clamped to the grid, for the central differences
+    int borderColumns = pColumns + 2;
+    QVector< float > heights(borderColumns * ( pRows + 2 ));
+    QVector< bool > valid(numberOfSamples);
+    for( int row = -1; row <= pRows; row++ )
+    {
+        int gridRow = glm::clamp(pFirstRow + row, 0, pGrid.rows - 1);
+        for( int column = -1; column <= pColumns; column++ )
+        {
+            int gridColumn = glm::clamp(pFirstColumn + column, 0, pGrid.columns - 1);
+            int sample = gridRow * pGrid.columns + gridColumn;
+            bool validSample = IsValid(pGrid, sample);
+            heights[( row + 1 ) * borderColumns + column + 1] = validSample ? pGrid.heights.at(sample) : pLowest;
+            if( row >= 0 && row < pRows && column >= 0 && column < pColumns )
+            {
+                valid[row * pColumns + column] = validSample;
+            }
+        }
+    }
+
+    //Positions and normals from central differences, row by row without branches in the interior
+    QVector< float > vertexData(numberOfSamples * 3);
+    QVector< float > normalData(numberOfSamples * 3);
+    for( int row = 0; row < pRows; row++ )
+    {
+        int gridRow = pFirstRow + row;
+        float inverseSpanZ = 1.0f / ( ( glm::min(gridRow + 1, pGrid.rows - 1) - glm::max(gridRow - 1, 0) ) * cellSize );
+        const float* current = heights.constData() + ( row + 1 ) * borderColumns + 1;
+        const float* previous = current - borderColumns;
+        const float* next = current + borderColumns;
+        for( int column = 0; column < pColumns; column++ )
+        {
+            int gridColumn = pFirstColumn + column;
+            float spanX = ( glm::min(gridColumn + 1, pGrid.columns - 1) - glm::max(gridColumn - 1, 0) ) * cellSize;
+            float slopeX = ( current[column + 1] - current[column - 1] ) / spanX;
+            float slopeZ = ( next[column] - previous[column] ) * inverseSpanZ;
+
+            int index = ( row * pColumns + column ) * 3;
+            glm::vec3 normal = glm::normalize( glm::vec3(-slopeX, 1.0f, -slopeZ) );
+            vertexData[index] = gridColumn * cellSize;
+            vertexData[index + 1] = current[column];
+            vertexData[index + 2] = gridRow * cellSize;
+            normalData[index] = normal.x;
+            normalData[index + 1] = normal.y;
+            normalData[index + 2] = normal.z;
+        }
+    }
+
+    //Two triangles per cell facing up, the cells with a sample without elevation are skipped
+    QVector< unsigned int > indexData;
+    indexData.reserve( ( pColumns - 1 ) * ( pRows - 1 ) * 6 );
+    for( int row = 0; row < pRows - 1; row++ )
+    {
+        for( int column = 0; column < pColumns - 1; column++ )
+        {
+            unsigned int a = row * pColumns + column;
+            unsigned int b = a + pColumns;
+            unsigned int c = a + 1;
+            unsigned int d = b + 1;
+            if( valid.at(a) && valid.at(b) && valid.at(c) && valid.at(d) )
+            {
+                indexData.push_back(a);
+                indexData.push_back(b);
+                indexData.push_back(c);
+                indexData.push_back(c);
+                indexData.push_back(b);
+                indexData.push_back(d);
+            }
+        }
+    }
+
+    Geometry* mesh = new Geometry(pName, Geometry::Triangles);
+    mesh->SetVerticesData(vertexData, 3);
+    mesh->SetNormalsData(normalData);
+    mesh->SetIndexsData(indexData);
+    //The spheres of the tiles are only merged into the one of the scene, so they do not need to be the minimum ones
+    mesh->SetApproximateBoundingSphere( pColumns < pGrid.columns || pRows < pGrid.rows );
+    mesh->ComputeBoundingVolumes();
+    mesh->ComputeAreasOfPolygons();
+    mesh->SetCompactStorage(true);
+    mesh->SetReleaseAttributesAfterUpload(true);
+    return mesh;
+}
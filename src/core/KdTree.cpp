@@ -0,0 +1,230 @@
+//Definition include
+#include "KdTree.h"
+
+//System includes
+#include <algorithm>
+#include <float.h>
+
+//Dependency includes
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+
+/// Ranges with this number of points or less are leaves
+const int LEAF_SIZE = 8;
+
+/// Order of the indices of the points along an axis
+class KdTreeAxisLess
+{
+public:
+    KdTreeAxisLess(const QVector< glm::vec3 >& pPoints, int pAxis):
+        mPoints(pPoints), mAxis(pAxis)
+    {
+
+    }
+
+    bool operator()(int pA, int pB) const
+    {
+        return mPoints.at(pA)[mAxis] < mPoints.at(pB)[mAxis];
+    }
+
+private:
+    const QVector< glm::vec3 >& mPoints;
+    int mAxis;
+};
+
+static float SquaredDistance(const glm::vec3& pA, const glm::vec3& pB)
+{
+    glm::vec3 difference = pA - pB;
+    return glm::dot(difference, difference);
+}
+
+KdTree::KdTree(const QVector< glm::vec3 >& pPoints):
+    mPoints(pPoints)
+{
+    int numberOfPoints = mPoints.size();
+    mOrder.resize(numberOfPoints);
+    for( int i = 0; i < numberOfPoints; i++ )
+    {
+        mOrder[i] = i;
+    }
+    mAxes.fill(0, numberOfPoints);
+    Build(0, numberOfPoints);
+}
+
+int KdTree::GetNumberOfPoints() const
+{
+    return mPoints.size();
+}
+
+int KdTree::GetNearest(const glm::vec3& pPoint) const
+{
+    int nearest = -1;
+    float distance = FLT_MAX;
+    SearchNearest(0, mOrder.size(), pPoint, nearest, distance);
+    return nearest;
+}
+
+QVector<int> KdTree::GetKNearest(const glm::vec3& pPoint, int pK) const
+{
+    QVector< QPair<float, int> > nearest;
+    int k = glm::min( pK, mOrder.size() );
+    if( k > 0 )
+    {
+        nearest.reserve(k);
+        SearchKNearest(0, mOrder.size(), pPoint, k, nearest);
+    }
+    std::sort_heap( nearest.begin(), nearest.end() );
+
+    QVector<int> result( nearest.size() );
+    for( int i = 0; i < nearest.size(); i++ )
+    {
+        result[i] = nearest.at(i).second;
+    }
+    return result;
+}
+
+QVector<int> KdTree::GetInRadius(const glm::vec3& pPoint, float pRadius) const
+{
+    QVector<int> result;
+    if( pRadius >= 0.0f )
+    {
+        SearchInRadius(0, mOrder.size(), pPoint, pRadius * pRadius, result);
+    }
+    return result;
+}
+
+void KdTree::Build(int pBegin, int pEnd)
+{
+    if( pEnd - pBegin <= LEAF_SIZE )
+    {
+        return;
+    }
+
+    //The range is split by the axis where the points are more spread
+    glm::vec3 min = mPoints.at( mOrder.at(pBegin) );
+    glm::vec3 max = min;
+    for( int i = pBegin + 1; i < pEnd; i++ )
+    {
+        min = glm::min( min, mPoints.at( mOrder.at(i) ) );
+        max = glm::max( max, mPoints.at( mOrder.at(i) ) );
+    }
+    glm::vec3 extent = max - min;
+    int axis = ( extent.x >= extent.y && extent.x >= extent.z ) ? 0 : ( ( extent.y >= extent.z ) ? 1 : 2 );
+
+    int median = ( pBegin + pEnd ) / 2;
+    std::nth_element( mOrder.begin() + pBegin, mOrder.begin() + median, mOrder.begin() + pEnd, KdTreeAxisLess(mPoints, axis) );
+    mAxes[median] = axis;
+
+    Build(pBegin, median);
+    Build(median + 1, pEnd);
+}
+
+void KdTree::SearchNearest(int pBegin, int pEnd, const glm::vec3& pPoint, int& pNearest, float& pDistance) const
+{
+    if( pEnd - pBegin <= LEAF_SIZE )
+    {
+        for( int i = pBegin; i < pEnd; i++ )
+        {
+            float distance = SquaredDistance( pPoint, mPoints.at( mOrder.at(i) ) );
+            if( distance < pDistance )
+            {
+                pDistance = distance;
+                pNearest = mOrder.at(i);
+            }
+        }
+        return;
+    }
+
+    int median = ( pBegin + pEnd ) / 2;
+    const glm::vec3& medianPoint = mPoints.at( mOrder.at(median) );
+    float distance = SquaredDistance( pPoint, medianPoint );
+    if( distance < pDistance )
+    {
+        pDistance = distance;
+        pNearest = mOrder.at(median);
+    }
+
+    //The side of the point first, the other side only if it can be nearer than the best found
+    float difference = pPoint[ mAxes.at(median) ] - medianPoint[ mAxes.at(median) ];
+    if( difference < 0.0f )
+    {
+        SearchNearest(pBegin, median, pPoint, pNearest, pDistance);
+        if( difference * difference < pDistance )
+        {
+            SearchNearest(median + 1, pEnd, pPoint, pNearest, pDistance);
+        }
+    }
+    else
+    {
+        SearchNearest(median + 1, pEnd, pPoint, pNearest, pDistance);
+        if( difference * difference < pDistance )
+        {
+            SearchNearest(pBegin, median, pPoint, pNearest, pDistance);
+        }
+    }
+}
+
+void KdTree::SearchKNearest(int pBegin, int pEnd, const glm::vec3& pPoint, int pK, QVector< QPair<float, int> >& pNearest) const
+{
+    bool leaf = ( pEnd - pBegin <= LEAF_SIZE );
+    int median = ( pBegin + pEnd ) / 2;
+    int first = leaf ? pBegin : median;
+    int last = leaf ? pEnd : median + 1;
+    for( int i = first; i < last; i++ )
+    {
+        float distance = SquaredDistance( pPoint, mPoints.at( mOrder.at(i) ) );
+        if( pNearest.size() < pK )
+        {
+            pNearest.push_back( qMakePair(distance, mOrder.at(i)) );
+            std::push_heap( pNearest.begin(), pNearest.end() );
+        }
+        else if( distance < pNearest.first().first )
+        {
+            std::pop_heap( pNearest.begin(), pNearest.end() );
+            pNearest.last() = qMakePair(distance, mOrder.at(i));
+            std::push_heap( pNearest.begin(), pNearest.end() );
+        }
+    }
+    if( leaf )
+    {
+        return;
+    }
+
+    const glm::vec3& medianPoint = mPoints.at( mOrder.at(median) );
+    float difference = pPoint[ mAxes.at(median) ] - medianPoint[ mAxes.at(median) ];
+    bool leftFirst = ( difference < 0.0f );
+    SearchKNearest(leftFirst ? pBegin : median + 1, leftFirst ? median : pEnd, pPoint, pK, pNearest);
+    if( pNearest.size() < pK || difference * difference < pNearest.first().first )
+    {
+        SearchKNearest(leftFirst ? median + 1 : pBegin, leftFirst ? pEnd : median, pPoint, pK, pNearest);
+    }
+}
+
+void KdTree::SearchInRadius(int pBegin, int pEnd, const glm::vec3& pPoint, float pSquaredRadius, QVector<int>& pResult) const
+{
+    bool leaf = ( pEnd - pBegin <= LEAF_SIZE );
+    int median = ( pBegin + pEnd ) / 2;
+    int first = leaf ? pBegin : median;
+    int last = leaf ? pEnd : median + 1;
+    for( int i = first; i < last; i++ )
+    {
+        if( SquaredDistance( pPoint, mPoints.at( mOrder.at(i) ) ) <= pSquaredRadius )
+        {
+            pResult.push_back( mOrder.at(i) );
+        }
+    }
+    if( leaf )
+    {
+        return;
+    }
+
+    float difference = pPoint[ mAxes.at(median) ] - mPoints.at( mOrder.at(median) )[ mAxes.at(median) ];
+    if( difference <= 0.0f || difference * difference <= pSquaredRadius )
+    {
+        SearchInRadius(pBegin, median, pPoint, pSquaredRadius, pResult);
+    }
+    if( difference >= 0.0f || difference * difference <= pSquaredRadius )
+    {
+        SearchInRadius(median + 1, pEnd, pPoint, pSquaredRadius, pResult);
+    }
+}
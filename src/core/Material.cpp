@@ -1,8 +1,8 @@
 //Definition include
 #include "Material.h"
 
-//Qt includes
-#include <QGLWidget>
+//Project includes
+#include "TextureCache.h"
 
 Material::Material(const QString &pName)
 {
@@ -16,20 +16,26 @@ Material::Material(const QString &pName)
     mShininess = 0.0f;
 }
 
+Material::Material(const Material& pMaterial):
+    mName(pMaterial.mName), mKa(pMaterial.mKa), mKaTexture(pMaterial.mKaTexture),
+    mKd(pMaterial.mKd), mKdTexture(pMaterial.mKdTexture), mKdTextureFileName(pMaterial.mKdTextureFileName),
+    mKs(pMaterial.mKs), mKsTexture(pMaterial.mKsTexture), mShininess(pMaterial.mShininess)
+{
+    TextureCache::AddReference(mKaTexture);
+    TextureCache::AddReference(mKdTexture);
+    TextureCache::AddReference(mKsTexture);
+}
+
 Material::~Material()
 {
-    if( mKaTexture != NULL )
-    {
-        delete mKaTexture;
-    }
-    if( mKdTexture != NULL )
-    {
-        delete mKdTexture;
-    }
-    if( mKsTexture != NULL )
-    {
-        delete mKsTexture;
-    }
+    TextureCache::Release(mKaTexture);
+    TextureCache::Release(mKdTexture);
+    TextureCache::Release(mKsTexture);
+}
+
+QString Material::GetName() const
+{
+    return mName;
 }
 
 glm::vec3 Material::GetKa() const
@@ -49,11 +55,8 @@ Texture* Material::GetKaTexture() const
 
 void Material::SetKaTexture(QImage* pKaTexture)
 {
-    if(mKaTexture != NULL)
-    {
-        delete mKaTexture;
-    }
-    mKaTexture = new Texture( new QImage( QGLWidget::convertToGLFormat(*pKaTexture) ) );
+    TextureCache::Release(mKaTexture);
+    mKaTexture = TextureCache::Acquire(QString(), pKaTexture);
 }
 
 bool Material::HasKaTexture() const
@@ -78,11 +81,14 @@ Texture *Material::GetKdTexture() const
 
 void Material::SetKdTexture(QImage* pKdTexture)
 {
-    if(mKdTexture != NULL)
-    {
-        delete mKdTexture;
-    }
-    mKdTexture = new Texture( new QImage( QGLWidget::convertToGLFormat(*pKdTexture) ) );
+    TextureCache::Release(mKdTexture);
+    mKdTexture = TextureCache::Acquire(QString(), pKdTexture);
+}
+
+void Material::SetKdTexture(Texture* pKdTexture)
+{
+    TextureCache::Release(mKdTexture);
+    mKdTexture = pKdTexture;
 }
 
 bool Material::HasKdTexture() const
@@ -90,6 +96,16 @@ bool Material::HasKdTexture() const
     return ( mKdTexture != NULL );
 }
 
+QString Material::GetKdTextureFileName() const
+{
+    return mKdTextureFileName;
+}
+
+void Material::SetKdTextureFileName(const QString& pFileName)
+{
+    mKdTextureFileName = pFileName;
+}
+
 glm::vec3 Material::GetKs() const
 {
     return mKs;
@@ -107,11 +123,8 @@ Texture *Material::GetKsTexture() const
 
 void Material::SetKsTexture(QImage* pKsTexture)
 {
-    if( mKsTexture != NULL )
-    {
-        delete mKsTexture;
-    }
-    mKsTexture = new Texture( new QImage( QGLWidget::convertToGLFormat(*pKsTexture) ) );
+    TextureCache::Release(mKsTexture);
+    mKsTexture = TextureCache::Acquire(QString(), pKsTexture);
 }
 
 bool Material::HasKsTexture() const
@@ -0,0 +1,81 @@
+//Definition include
+#include "PolygonalTexture.h"
+
+//Dependency includes
+#include "glm/common.hpp"
+#include "glm/exponential.hpp"
+
+/// Maximum side of a page, supported by any OpenGL 3 implementation used by the application
+const int MAX_PAGE_SIZE = 4096;
+
+PolygonalTexture::PolygonalTexture(int pNumberOfPolygons, GLenum pInternalFormat):
+    mNumberOfPolygons(pNumberOfPolygons), mPageSize(GetPageSize(pNumberOfPolygons)), mNumberOfPages(GetNumberOfPages(pNumberOfPolygons))
+{
+    glGenTextures(1, &mGLId);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mGLId);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, pInternalFormat, mPageSize, mPageSize, mNumberOfPages, 0, GL_RED, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+PolygonalTexture::~PolygonalTexture()
+{
+    glDeleteTextures(1, &mGLId);
+}
+
+void PolygonalTexture::SetValues(const float* pValues)
+{
+    int pageTexels = mPageSize * mPageSize;
+    int completePages = mNumberOfPolygons / pageTexels;
+    int remainingTexels = mNumberOfPolygons % pageTexels;
+    int completeRows = remainingTexels / mPageSize;
+    int remainingColumns = remainingTexels % mPageSize;
+
+    //The values are uploaded directly without padding them to complete pages
+    glBindTexture(GL_TEXTURE_2D_ARRAY, mGLId);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if( completePages > 0 )
+    {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, mPageSize, mPageSize, completePages, GL_RED, GL_FLOAT, pValues);
+    }
+    if( completeRows > 0 )
+    {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, completePages, mPageSize, completeRows, 1, GL_RED, GL_FLOAT, pValues + completePages * pageTexels);
+    }
+    if( remainingColumns > 0 )
+    {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, completeRows, completePages, remainingColumns, 1, 1, GL_RED, GL_FLOAT, pValues + completePages * pageTexels + completeRows * mPageSize);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+GLuint PolygonalTexture::GetGLId() const
+{
+    return mGLId;
+}
+
+int PolygonalTexture::GetPageSize() const
+{
+    return mPageSize;
+}
+
+int PolygonalTexture::GetNumberOfPages() const
+{
+    return mNumberOfPages;
+}
+
+int PolygonalTexture::GetPageSize(int pNumberOfPolygons)
+{
+    int size = glm::ceil( glm::sqrt( (float)pNumberOfPolygons ) );
+    return glm::clamp(size, 1, MAX_PAGE_SIZE);
+}
+
+int PolygonalTexture::GetNumberOfPages(int pNumberOfPolygons)
+{
+    int pageTexels = GetPageSize(pNumberOfPolygons) * GetPageSize(pNumberOfPolygons);
+    return glm::max( 1, ( pNumberOfPolygons + pageTexels - 1 ) / pageTexels );
+}
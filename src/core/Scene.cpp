@@ -12,6 +12,7 @@
 //Project includes
 #include "Debug.h"
 #include "MainWindow.h"
+#include "TerrainTileCache.h"
 #include "Tools.h"
 
 Scene::Scene(const QString& pName)
@@ -21,35 +22,50 @@ Scene::Scene(const QString& pName)
     mNumberOfPolygons = 0;
     mNumberOfVertices = 0;
     mBoundingSphere = new BoundingSphere();
+    mTileCache = NULL;
+    mReversedTraversal = false;
 }
 
 Scene::Scene(const QString& pName, const QVector<Geometry *> &pMeshes)
 {
     mName = pName;
-    mBoundingSphere = NULL;
     mNumberOfMeshes = pMeshes.size();
     mNumberOfPolygons = 0;
     mNumberOfVertices = 0;
+    mTileCache = NULL;
+    mReversedTraversal = false;
+    //The spheres are merged by value, so only the sphere of the scene is created
+    glm::vec3 center(0.0f);
+    float radius = 0.0f;
+    bool empty = true;
     for( int i = 0; i < mNumberOfMeshes; i++ )
     {
         //Afegim el mesh a la llista de meshes
         mMeshes.push_back(pMeshes.at(i));
 
+        mPolygonOffsets.push_back(mNumberOfPolygons);
         mNumberOfPolygons += pMeshes.at(i)->GetNumFaces();
         mNumberOfVertices += pMeshes.at(i)->GetNumVertices();
 
         //Recalculem el bounding volume
-        BoundingSphere* newBoundingSphere = BoundingSphere::Merge(mBoundingSphere, pMeshes.at(i)->GetBoundingSphere());
-        if( mBoundingSphere != NULL )
+        const BoundingSphere* meshBoundingSphere = pMeshes.at(i)->GetBoundingSphere();
+        if( meshBoundingSphere != NULL )
         {
-            delete mBoundingSphere;
+            if( empty )
+            {
+                center = meshBoundingSphere->GetCenter();
+                radius = meshBoundingSphere->GetRadius();
+                empty = false;
+            }
+            else
+            {
+                BoundingSphere::Merge(center, radius, meshBoundingSphere->GetCenter(), meshBoundingSphere->GetRadius());
+            }
         }
-        mBoundingSphere = newBoundingSphere;
-    }
-    if( mBoundingSphere == NULL )
-    {
-        mBoundingSphere = new BoundingSphere();
     }
+    mBoundingSphere = new BoundingSphere();
+    mBoundingSphere->SetCenter(center);
+    mBoundingSphere->SetRadius(radius);
 }
 
 Scene::Scene(const Scene& pScene)
@@ -58,8 +74,13 @@ Scene::Scene(const Scene& pScene)
     mMeshes.resize(mNumberOfMeshes);
     for( int i = 0; i < mNumberOfMeshes; i++ )
     {
+        //The copies of the tiles are always in memory
+        pScene.mMeshes.at(i)->MakeResident();
         mMeshes[i] = new Geometry(*pScene.mMeshes.at(i));
     }
+    mTileCache = NULL;
+    mReversedTraversal = false;
+    mPolygonOffsets = pScene.mPolygonOffsets;
     mName = pScene.mName;
     mBoundingSphere = new BoundingSphere(*pScene.mBoundingSphere);
     mNumberOfPolygons = pScene.mNumberOfPolygons;
@@ -73,6 +94,7 @@ Scene::~Scene()
         delete mMeshes.at(i);
     }
     delete mBoundingSphere;
+    delete mTileCache;
 }
 
 void Scene::Add(Geometry *pMesh)
@@ -81,6 +103,7 @@ void Scene::Add(Geometry *pMesh)
     mMeshes.push_back(pMesh);
 
     mNumberOfMeshes++;
+    mPolygonOffsets.push_back(mNumberOfPolygons);
     mNumberOfPolygons += pMesh->GetNumFaces();
     mNumberOfVertices += pMesh->GetNumVertices();
 
@@ -131,6 +154,17 @@ int Scene::GetNumberOfMeshes() const
     return mNumberOfMeshes;
 }
 
+QByteArray Scene::GetContentHash() const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for( int i = 0; i < mNumberOfMeshes; i++ )
+    {
+        mMeshes.at(i)->MakeResident();
+        mMeshes.at(i)->AddContentToHash(hash);
+    }
+    return hash.result();
+}
+
 void Scene::ShowInformation() const
 {
     Debug::Log( QString("Scene name: %1").arg(mName) );
@@ -162,6 +196,26 @@ int Scene::GetPolygonOffset(Geometry *pMesh) const
     return offset;
 }
 
+int Scene::GetPolygonOffsetOfMesh(int pIndex) const
+{
+    return mPolygonOffsets.at(pIndex);
+}
+
+QVector<int> Scene::GetMeshTraversalOrder() const
+{
+    QVector<int> order(mNumberOfMeshes);
+    for( int i = 0; i < mNumberOfMeshes; i++ )
+    {
+        order[i] = ( mReversedTraversal ) ? mNumberOfMeshes - 1 - i : i;
+    }
+    //Without tiles all the meshes are in memory and the order does not matter
+    if( mTileCache != NULL )
+    {
+        mReversedTraversal = !mReversedTraversal;
+    }
+    return order;
+}
+
 QVector< glm::vec3 > Scene::GetVerticesOfPolygon( int pPolygon ) const
 {
     QVector< glm::vec3 > vertices;
@@ -180,6 +234,7 @@ QVector< glm::vec3 > Scene::GetVerticesOfPolygon( int pPolygon ) const
             numPolygons += mMeshes.at(currentMesh)->GetNumFaces();
         }
         int meshPolygon = pPolygon - ( numPolygons - mMeshes.at(currentMesh)->GetNumFaces() );
+        mMeshes.at(currentMesh)->MakeResident();
 
         if( mMeshes.at(currentMesh)->GetTopology() == Geometry::Triangles )
         {
@@ -212,6 +267,16 @@ QVector< float > Scene::GetSerializedPolygonAreas() const
     return areas;
 }
 
+void Scene::SetTileCache(TerrainTileCache* pTileCache)
+{
+    mTileCache = pTileCache;
+}
+
+TerrainTileCache* Scene::GetTileCache() const
+{
+    return mTileCache;
+}
+
 void Scene::Normalize()
 {
     glm::vec3 center = mBoundingSphere->GetCenter();
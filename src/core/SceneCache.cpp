@@ -0,0 +1,388 @@
+//Definition include
+#include "SceneCache.h"
+
+//System includes
+#include <string.h>
+
+//Qt includes
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QTime>
+
+//Project includes
+#include "Debug.h"
+#include "TextureCache.h"
+#include "Tools.h"
+
+/// Identification of the cache files, the version has to change if the format changes
+const quint32 SCENE_CACHE_MAGIC = 0x51534343;
+const quint32 SCENE_CACHE_VERSION = 4;
+
+/// Sequential reader over the memory-mapped cache file that stops at the end of the data
+class SceneCacheReader
+{
+public:
+    SceneCacheReader(const uchar* pData, qint64 pSize):
+        mData(pData), mEnd(pData + pSize), mValid(true)
+    {
+
+    }
+
+    bool IsValid() const
+    {
+        return mValid;
+    }
+
+    void ReadRaw(void* pDestination, qint64 pSize)
+    {
+        if( !mValid || mEnd - mData < pSize )
+        {
+            mValid = false;
+            return;
+        }
+        memcpy(pDestination, mData, pSize);
+        mData += pSize;
+    }
+
+    qint32 ReadInt()
+    {
+        qint32 value = 0;
+        ReadRaw(&value, sizeof(value));
+        return value;
+    }
+
+    qint64 ReadInt64()
+    {
+        qint64 value = 0;
+        ReadRaw(&value, sizeof(value));
+        return value;
+    }
+
+    glm::vec3 ReadVec3()
+    {
+        glm::vec3 value;
+        ReadRaw(&value[0], sizeof(value));
+        return value;
+    }
+
+    QString ReadString()
+    {
+        QByteArray bytes( ReadSize(1), 0 );
+        ReadRaw(bytes.data(), bytes.size());
+        return QString::fromUtf8(bytes);
+    }
+
+    template<class T> void ReadVector(QVector<T>& pVector)
+    {
+        pVector.resize( ReadSize(sizeof(T)) );
+        ReadRaw(pVector.data(), pVector.size() * sizeof(T));
+    }
+
+private:
+    /// Read a number of elements checking that they fit in the remaining data
+    int ReadSize(int pElementSize)
+    {
+        qint32 size = ReadInt();
+        if( size < 0 || ( mEnd - mData ) / pElementSize < size )
+        {
+            mValid = false;
+            return 0;
+        }
+        return size;
+    }
+
+    const uchar* mData;
+    const uchar* mEnd;
+    bool mValid;
+};
+
+static void WriteInt(QFile& pFile, qint32 pValue)
+{
+    pFile.write( (const char*)&pValue, sizeof(pValue) );
+}
+
+static void WriteInt64(QFile& pFile, qint64 pValue)
+{
+    pFile.write( (const char*)&pValue, sizeof(pValue) );
+}
+
+static void WriteVec3(QFile& pFile, const glm::vec3& pValue)
+{
+    pFile.write( (const char*)&pValue[0], sizeof(pValue) );
+}
+
+static void WriteString(QFile& pFile, const QString& pValue)
+{
+    QByteArray bytes = pValue.toUtf8();
+    WriteInt(pFile, bytes.size());
+    pFile.write(bytes);
+}
+
+template<class T> static void WriteVector(QFile& pFile, const QVector<T>& pVector)
+{
+    WriteInt(pFile, pVector.size());
+    pFile.write( (const char*)pVector.constData(), pVector.size() * sizeof(T) );
+}
+
+Scene* SceneCache::Load(const QString& pPath)
+{
+    QTime t;
+    t.start();
+
+    QFileInfo modelInfo(pPath);
+    QFile file( GetCacheFileName(pPath) );
+    if( !modelInfo.exists() || !file.open(QFile::ReadOnly) )
+    {
+        return NULL;
+    }
+    uchar* data = file.map(0, file.size());
+    if( data == NULL )
+    {
+        return NULL;
+    }
+
+    SceneCacheReader reader(data, file.size());
+    quint32 magic = reader.ReadInt();
+    quint32 version = reader.ReadInt();
+    qint64 modelSize = reader.ReadInt64();
+    qint64 modelTime = reader.ReadInt64();
+    if( magic != SCENE_CACHE_MAGIC || version != SCENE_CACHE_VERSION ||
+        modelSize != modelInfo.size() || modelTime != modelInfo.lastModified().toMSecsSinceEpoch() )
+    {
+        file.unmap(data);
+        return NULL;
+    }
+
+    //The files that did not exist are saved with size -1, so the cache is not used either if they appear
+    int numberOfDependencies = reader.ReadInt();
+    for( int i = 0; i < numberOfDependencies && reader.IsValid(); i++ )
+    {
+        QFileInfo dependencyInfo( reader.ReadString() );
+        qint64 dependencySize = reader.ReadInt64();
+        qint64 dependencyTime = reader.ReadInt64();
+        qint64 currentSize = dependencyInfo.exists() ? dependencyInfo.size() : -1;
+        qint64 currentTime = dependencyInfo.exists() ? dependencyInfo.lastModified().toMSecsSinceEpoch() : -1;
+        if( dependencySize != currentSize || dependencyTime != currentTime )
+        {
+            Debug::Log( QString("SceneCache::Load - %1 has changed, the model is imported again").arg( dependencyInfo.filePath() ) );
+            file.unmap(data);
+            return NULL;
+        }
+    }
+
+    QString sceneName = reader.ReadString();
+    int numberOfMeshes = reader.ReadInt();
+    QVector<Geometry *> meshes;
+    for( int i = 0; i < numberOfMeshes && reader.IsValid(); i++ )
+    {
+        QString meshName = reader.ReadString();
+        Geometry* mesh = new Geometry( meshName, (Geometry::Topology)reader.ReadInt() );
+        mesh->mVertexStride = reader.ReadInt();
+        mesh->mColorStride = reader.ReadInt();
+        reader.ReadVector(mesh->mVertexData);
+        reader.ReadVector(mesh->mNormalData);
+        reader.ReadVector(mesh->mColorData);
+        reader.ReadVector(mesh->mTextCoordsData);
+        reader.ReadVector(mesh->mTangentData);
+        reader.ReadVector(mesh->mBitangentData);
+        reader.ReadVector(mesh->mIndexData);
+        reader.ReadVector(mesh->mAreasOfPolygons);
+        mesh->mCompactStorage = ( reader.ReadInt() != 0 );
+        mesh->mReleaseAttributesAfterUpload = ( reader.ReadInt() != 0 );
+        mesh->mNeedGPUGeometryUpdate = true;
+
+        mesh->mBoundingBox = new AxisAlignedBoundingBox();
+        mesh->mBoundingBox->SetMin( reader.ReadVec3() );
+        mesh->mBoundingBox->SetMax( reader.ReadVec3() );
+        mesh->mBoundingSphere = new BoundingSphere();
+        mesh->mBoundingSphere->SetCenter( reader.ReadVec3() );
+        float radius;
+        reader.ReadRaw(&radius, sizeof(radius));
+        mesh->mBoundingSphere->SetRadius(radius);
+
+        if( reader.ReadInt() != 0 )
+        {
+            Material* material = new Material( reader.ReadString() );
+            material->SetKa( reader.ReadVec3() );
+            material->SetKd( reader.ReadVec3() );
+            material->SetKs( reader.ReadVec3() );
+            float shininess;
+            reader.ReadRaw(&shininess, sizeof(shininess));
+            material->SetShininess(shininess);
+            QString textureFileName = reader.ReadString();
+            if( !textureFileName.isEmpty() )
+            {
+                Texture* texture = TextureCache::Acquire(textureFileName);
+                if( texture == NULL )
+                {
+                    QImage image;
+                    if( image.load(textureFileName) )
+                    {
+                        texture = TextureCache::Acquire(textureFileName, &image);
+                    }
+                }
+                if( texture != NULL )
+                {
+                    material->SetKdTexture(texture);
+                    material->SetKdTextureFileName(textureFileName);
+                }
+                else
+                {
+                    Debug::Warning( QString("Impossible to load the image: %1").arg(textureFileName) );
+                }
+            }
+            mesh->SetMaterial(material);
+        }
+        meshes.push_back(mesh);
+    }
+    file.unmap(data);
+
+    if( !reader.IsValid() || meshes.size() != numberOfMeshes )
+    {
+        Debug::Warning( QString("SceneCache::Load - Invalid cache file %1").arg( file.fileName() ) );
+        for( int i = 0; i < meshes.size(); i++ )
+        {
+            delete meshes.at(i);
+        }
+        return NULL;
+    }
+    Debug::Log( QString("SceneCache::Load - Scene loaded from %1 in %2 ms").arg( file.fileName() ).arg( t.elapsed() ) );
+    return new Scene(sceneName, meshes);
+}
+
+void SceneCache::Save(const QString& pPath, const Scene* pScene)
+{
+    QTime t;
+    t.start();
+
+    QFileInfo modelInfo(pPath);
+    QString fileName = GetCacheFileName(pPath);
+    if( !QDir().mkpath( QFileInfo(fileName).absolutePath() ) )
+    {
+        Debug::Warning( QString("SceneCache::Save - Impossible to create the folder of %1").arg(fileName) );
+        return;
+    }
+    //The file is replaced only when it is complete, so an interrupted save does not leave a broken cache
+    QFile file(fileName + ".tmp");
+    if( !file.open(QFile::WriteOnly) )
+    {
+        Debug::Warning( QString("SceneCache::Save - Impossible to write %1").arg( file.fileName() ) );
+        return;
+    }
+
+    WriteInt(file, SCENE_CACHE_MAGIC);
+    WriteInt(file, SCENE_CACHE_VERSION);
+    WriteInt64(file, modelInfo.size());
+    WriteInt64(file, modelInfo.lastModified().toMSecsSinceEpoch());
+    QStringList dependencies = GetDependencies(pPath, pScene);
+    WriteInt(file, dependencies.size());
+    for( int i = 0; i < dependencies.size(); i++ )
+    {
+        QFileInfo dependencyInfo( dependencies.at(i) );
+        WriteString(file, dependencyInfo.absoluteFilePath());
+        WriteInt64(file, dependencyInfo.exists() ? dependencyInfo.size() : -1);
+        WriteInt64(file, dependencyInfo.exists() ? dependencyInfo.lastModified().toMSecsSinceEpoch() : -1);
+    }
+    WriteString(file, pScene->GetName());
+    WriteInt(file, pScene->GetNumberOfMeshes());
+    for( int i = 0; i < pScene->GetNumberOfMeshes(); i++ )
+    {
+        const Geometry* mesh = pScene->GetMesh(i);
+        WriteString(file, mesh->mName);
+        WriteInt(file, mesh->mTopology);
+        WriteInt(file, mesh->mVertexStride);
+        WriteInt(file, mesh->mColorStride);
+        WriteVector(file, mesh->mVertexData);
+        WriteVector(file, mesh->mNormalData);
+        WriteVector(file, mesh->mColorData);
+        WriteVector(file, mesh->mTextCoordsData);
+        WriteVector(file, mesh->mTangentData);
+        WriteVector(file, mesh->mBitangentData);
+        WriteVector(file, mesh->mIndexData);
+        WriteVector(file, mesh->mAreasOfPolygons);
+        WriteInt(file, mesh->mCompactStorage);
+        WriteInt(file, mesh->mReleaseAttributesAfterUpload);
+
+        WriteVec3(file, mesh->mBoundingBox->GetMin());
+        WriteVec3(file, mesh->mBoundingBox->GetMax());
+        WriteVec3(file, mesh->mBoundingSphere->GetCenter());
+        float radius = mesh->mBoundingSphere->GetRadius();
+        file.write( (const char*)&radius, sizeof(radius) );
+
+        const Material* material = mesh->mMaterial;
+        WriteInt(file, material != NULL);
+        if( material != NULL )
+        {
+            WriteString(file, material->GetName());
+            WriteVec3(file, material->GetKa());
+            WriteVec3(file, material->GetKd());
+            WriteVec3(file, material->GetKs());
+            float shininess = material->GetShininess();
+            file.write( (const char*)&shininess, sizeof(shininess) );
+            WriteString(file, material->GetKdTextureFileName());
+        }
+    }
+    bool written = ( file.error() == QFile::NoError );
+    file.close();
+
+    QFile::remove(fileName);
+    if( !written || !file.rename(fileName) )
+    {
+        Debug::Warning( QString("SceneCache::Save - Impossible to write %1").arg(fileName) );
+        QFile::remove( file.fileName() );
+        return;
+    }
+    Debug::Log( QString("SceneCache::Save - Scene saved into %1 in %2 ms").arg(fileName).arg( t.elapsed() ) );
+}
+
+QStringList SceneCache::GetDependencies(const QString& pPath, const Scene* pScene)
+{
+    QStringList dependencies;
+    QFileInfo modelInfo(pPath);
+
+    //Material libraries of the Wavefront models
+    if( modelInfo.suffix().toLower() == "obj" )
+    {
+        QFile model(pPath);
+        if( model.open(QFile::ReadOnly) )
+        {
+            while( !model.atEnd() )
+            {
+                QByteArray line = model.readLine().trimmed();
+                if( line.startsWith("mtllib") )
+                {
+                    QList<QByteArray> libraries = line.mid(6).simplified().split(' ');
+                    for( int i = 0; i < libraries.size(); i++ )
+                    {
+                        if( !libraries.at(i).isEmpty() )
+                        {
+                            dependencies.push_back( modelInfo.absoluteDir().filePath( QString::fromUtf8( libraries.at(i) ) ) );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //Textures of the materials
+    for( int i = 0; i < pScene->GetNumberOfMeshes(); i++ )
+    {
+        const Material* material = pScene->GetMesh(i)->GetMaterial();
+        if( material != NULL && !material->GetKdTextureFileName().isEmpty() && !dependencies.contains( material->GetKdTextureFileName() ) )
+        {
+            dependencies.push_back( material->GetKdTextureFileName() );
+        }
+    }
+    return dependencies;
+}
+
+QString SceneCache::GetCacheFileName(const QString& pPath)
+{
+    QByteArray path = QFileInfo(pPath).absoluteFilePath().toUtf8();
+    QString name = QString( QCryptographicHash::hash(path, QCryptographicHash::Sha1).toHex() );
+    return QDir( Tools::GetProgramPath() ).filePath( QString("SceneCache/%1.bin").arg(name) );
+}
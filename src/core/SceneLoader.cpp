@@ -4,6 +4,9 @@
 //Qt includes
 #include <QFileInfo>
 #include <QImageReader>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 
 //Dependency includes
 #include "assimp/Importer.hpp"
@@ -14,10 +17,171 @@
 
 //Project includes
 #include "Debug.h"
+#include "HeightfieldLoader.h"
+#include "SceneCache.h"
+#include "TextureCache.h"
+
+/// Convert the aiMesh \param pMesh to a Geometry without material and free it, it is called from the thread pool
+static Geometry* ConvertMesh(aiMesh* pMesh)
+{
+    unsigned int numberOfVertices = pMesh->mNumVertices;
+
+    QVector< float > vertexData(numberOfVertices*3);
+    QVector< float > normalData;
+    if( pMesh->HasNormals() )
+    {
+        normalData.resize(numberOfVertices*3);
+    }
+    QVector< glm::vec3 > tangentData;
+    QVector< glm::vec3 > bitangentData;
+    if( pMesh->HasTangentsAndBitangents() )
+    {
+        tangentData.resize(numberOfVertices);
+        bitangentData.resize(numberOfVertices);
+    }
+
+    Geometry * currentMesh = new Geometry(QString(pMesh->mName.data), Geometry::Triangles);
+
+    // Guardem els vertexs, normals, tangents i bitangents
+    for( unsigned int j = 0; j < numberOfVertices; j++ )
+    {
+        aiVector3D tmp = pMesh->mVertices[j];
+        vertexData[j*3] = tmp.x;
+        vertexData[j*3+1] = tmp.y;
+        vertexData[j*3+2] = tmp.z;
+
+        if( pMesh->HasNormals() )
+        {
+            tmp = pMesh->mNormals[j];
+            normalData[j*3] = tmp.x;
+            normalData[j*3+1] = tmp.y;
+            normalData[j*3+2] = tmp.z;
+        }
+        if( pMesh->HasTangentsAndBitangents() )
+        {
+            tmp = pMesh->mTangents[j];
+            tangentData[j] = glm::vec3(tmp.x, tmp.y, tmp.z);
+
+            tmp = pMesh->mBitangents[j];
+            bitangentData[j] =  glm::vec3(tmp.x, tmp.y, tmp.z);
+        }
+    }
+
+    if( pMesh->GetNumUVChannels() > 0 )
+    {
+        if( pMesh->HasTextureCoords(0) )
+        {
+            if( pMesh->mNumUVComponents[0] == 2 )
+            {
+                // Guardem les coordenades de textura
+                QVector< float > textCoordData(numberOfVertices*2);
+                for( unsigned int j = 0; j < numberOfVertices; j++ )
+                {
+                    textCoordData[j*2] = pMesh->mTextureCoords[0][j].x;
+                    textCoordData[j*2+1] = pMesh->mTextureCoords[0][j].y;
+                }
+                currentMesh->SetTextCoordsData(textCoordData);
+            }
+            else
+            {
+                Debug::Warning(QString("Only 2 UV components supported"));
+            }
+        }
+    }
+
+    unsigned int numberOfFaces = pMesh->mNumFaces;
+    QVector< unsigned int > indexData(numberOfFaces*3);
+    for( unsigned int j = 0; j < pMesh->mNumFaces; j++ )
+    {
+        struct aiFace tmpFace = pMesh->mFaces[j];
+        indexData[j*3] = tmpFace.mIndices[0];
+        indexData[j*3+1] = tmpFace.mIndices[1];
+        indexData[j*3+2] = tmpFace.mIndices[2];
+    }
+    //The buffers are adopted by the mesh without copying them
+    currentMesh->SetVerticesData(vertexData, 3);
+    currentMesh->SetIndexsData(indexData);
+    currentMesh->SetNormalsData(normalData);
+
+    if((tangentData.size() > 0) && (bitangentData.size() > 0))
+    {
+        currentMesh->SetTangentData(tangentData.size(), tangentData.data());
+        currentMesh->SetBitangentData(bitangentData.size(), bitangentData.data());
+    }
+
+    currentMesh->ComputeBoundingVolumes();
+    currentMesh->ComputeAreasOfPolygons();
+    currentMesh->SetCompactStorage(true);
+    currentMesh->SetReleaseAttributesAfterUpload(true);
+
+    delete pMesh;
+    return currentMesh;
+}
+
+/// Task of the thread pool that converts a mesh and computes its bounding volumes and areas
+class SceneLoaderMeshTask : public QRunnable
+{
+public:
+    SceneLoaderMeshTask(aiMesh* pMesh, Geometry** pResult):
+        mMesh(pMesh), mResult(pResult)
+    {
+
+    }
+
+    void run()
+    {
+        *mResult = ConvertMesh(mMesh);
+    }
+
+private:
+    aiMesh* mMesh;
+    Geometry** mResult;
+};
+
+/// Task of the thread pool that decodes an image, the result is a null image if it can not be loaded
+class SceneLoaderImageTask : public QRunnable
+{
+public:
+    SceneLoaderImageTask(const QString& pPath, QImage* pResult):
+        mPath(pPath), mResult(pResult)
+    {
+
+    }
+
+    void run()
+    {
+        mResult->load(mPath);
+    }
+
+private:
+    QString mPath;
+    QImage* mResult;
+};
 
 Scene * SceneLoader::LoadScene(const QString &pPath)
 {
-    Scene* sceneLoaded;
+    //The scenes already imported are read from the cache without post-processing them again
+    Scene* sceneLoaded = SceneCache::Load(pPath);
+    if(sceneLoaded != NULL)
+    {
+        return sceneLoaded;
+    }
+
+    //The elevation models are converted directly into a grid mesh
+    if(HeightfieldLoader::IsHeightfield(pPath))
+    {
+        sceneLoaded = HeightfieldLoader::LoadScene(pPath);
+        if(sceneLoaded == NULL)
+        {
+            return new Scene("Default");
+        }
+        //The tiled terrains are already on disk as tiles and they do not fit in the cache file
+        if(sceneLoaded->GetTileCache() == NULL)
+        {
+            SceneCache::Save(pPath, sceneLoaded);
+        }
+        return sceneLoaded;
+    }
 
     Assimp::Importer importer;
     importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE,
@@ -25,123 +189,80 @@ Scene * SceneLoader::LoadScene(const QString &pPath)
                                 aiPrimitiveType_LINE );			//lines
     // Impotem l'escena amb els segents parmetres:
     //   aiProcess_GenNormals
-    //   aiProcess_CalcTangentSpace
     //   aiProcess_Triangulate
     //   aiProcess_JoinIdenticalVertices
     //   aiProcess_PreTransformVertices
     //   aiProcess_RemoveRedundantMaterials
     //   aiProcess_OptimizeMeshes
-    const aiScene* scene = importer.ReadFile(pPath.toLatin1().data(),
-                                             aiProcess_GenNormals               |
-                                             aiProcess_CalcTangentSpace         |
-                                             aiProcess_Triangulate              |
-                                             aiProcess_JoinIdenticalVertices    |
-                                             aiProcess_PreTransformVertices     |
-                                             aiProcess_RemoveRedundantMaterials |
-                                             aiProcess_OptimizeMeshes           |
-                                             aiProcess_SortByPType              |
-                                             aiProcess_ImproveCacheLocality );
+    importer.ReadFile(pPath.toLatin1().data(),
+                      aiProcess_GenNormals               |
+                      aiProcess_Triangulate              |
+                      aiProcess_JoinIdenticalVertices    |
+                      aiProcess_PreTransformVertices     |
+                      aiProcess_RemoveRedundantMaterials |
+                      aiProcess_OptimizeMeshes           |
+                      aiProcess_SortByPType              |
+                      aiProcess_ImproveCacheLocality );
+    //The scene is taken from the importer so every mesh can be freed as soon as it has been converted
+    aiScene* scene = importer.GetOrphanedScene();
 
     if(scene)
     {
         QFileInfo fileInfo(pPath);
         unsigned int numSubMeshes = scene->mNumMeshes;
         QVector<Geometry *> meshesLoaded(numSubMeshes);
-        // Recorrem totes les malles de l'escena
+        //The materials are read in this thread and the meshes are converted and the diffuse textures
+        //decoded by the thread pool. The textures are uploaded to the GPU here, where the context is current
+        QVector<Material *> materials(numSubMeshes);
+        QVector<QString> texturePaths(numSubMeshes);
+        QVector<QString> imagePaths;
         for( unsigned int i = 0; i < numSubMeshes; i++ )
         {
-            aiMesh* subMesh = scene->mMeshes[i];
-            unsigned int numberOfVertices = subMesh->mNumVertices;
-
-            QVector< glm::vec3 > vertexData(numberOfVertices);
-            QVector< glm::vec3 > normalData;
-            if( subMesh->HasNormals() )
-            {
-                normalData.resize(numberOfVertices);
-            }
-            QVector< glm::vec3 > tangentData;
-            QVector< glm::vec3 > bitangentData;
-            if( subMesh->HasTangentsAndBitangents() )
+            aiMaterial * actualAiMaterial = scene->mMaterials[scene->mMeshes[i]->mMaterialIndex];
+            materials[i] = LoadMaterial(actualAiMaterial, fileInfo.absolutePath(), texturePaths[i]);
+            //The textures already in the GPU are not decoded again
+            if( !texturePaths.at(i).isEmpty() && !imagePaths.contains(texturePaths.at(i)) && !TextureCache::Contains(texturePaths.at(i)) )
             {
-                tangentData.resize(numberOfVertices);
-                bitangentData.resize(numberOfVertices);
+                imagePaths.push_back(texturePaths.at(i));
             }
+        }
 
-            Geometry * currentMesh = new Geometry(QString(subMesh->mName.data), Geometry::Triangles);
+        QVector<QImage> images(imagePaths.size());
+        QThreadPool threadPool;
+        threadPool.setMaxThreadCount( QThread::idealThreadCount() );
+        for( int i = 0; i < imagePaths.size(); i++ )
+        {
+            threadPool.start( new SceneLoaderImageTask( imagePaths.at(i), images.data() + i ) );
+        }
+        for( unsigned int i = 0; i < numSubMeshes; i++ )
+        {
+            threadPool.start( new SceneLoaderMeshTask( scene->mMeshes[i], meshesLoaded.data() + i ) );
+            scene->mMeshes[i] = NULL;
+        }
+        threadPool.waitForDone();
 
-            // Guardem els vertexs, normals, tangents i bitangents
-            for( unsigned int j = 0; j < numberOfVertices; j++ )
+        for( unsigned int i = 0; i < numSubMeshes; i++ )
+        {
+            if( !texturePaths.at(i).isEmpty() )
             {
-                aiVector3D tmp = subMesh->mVertices[j];
-                vertexData[j] = glm::vec3(tmp.x, tmp.y, tmp.z);
-
-                if( subMesh->HasNormals() )
-                {
-                    tmp = subMesh->mNormals[j];
-                    normalData[j] = glm::vec3(tmp.x, tmp.y, tmp.z);
-                }
-                if( subMesh->HasTangentsAndBitangents() )
+                int imageIndex = imagePaths.indexOf(texturePaths.at(i));
+                Texture* texture = TextureCache::Acquire( texturePaths.at(i), ( imageIndex >= 0 ) ? &images.at(imageIndex) : NULL );
+                if( texture != NULL )
                 {
-                    tmp = subMesh->mTangents[j];
-                    tangentData[j] = glm::vec3(tmp.x, tmp.y, tmp.z);
-
-                    tmp = subMesh->mBitangents[j];
-                    bitangentData[j] =  glm::vec3(tmp.x, tmp.y, tmp.z);
+                    materials[i]->SetKdTexture(texture);
+                    materials[i]->SetKdTextureFileName(texturePaths.at(i));
                 }
-            }
-
-            if( subMesh->GetNumUVChannels() > 0 )
-            {
-                if( subMesh->HasTextureCoords(0) )
+                else
                 {
-                    if( subMesh->mNumUVComponents[0] == 2 )
-                    {
-                        // Guardem les coordenades de textura
-                        QVector< glm::vec2 > textCoordData(numberOfVertices);
-                        for( unsigned int j = 0; j < numberOfVertices; j++ )
-                        {
-                            textCoordData[j] = glm::vec2( subMesh->mTextureCoords[0][j].x, subMesh->mTextureCoords[0][j].y );
-                        }
-                        currentMesh->SetTextCoordsData( textCoordData.size(), textCoordData.data() );
-                    }
-                    else
-                    {
-                        Debug::Warning(QString("Only 2 UV components supported"));
-                    }
+                    ShowImageError(texturePaths.at(i));
                 }
             }
-
-            aiMaterial * actualAiMaterial = scene->mMaterials[subMesh->mMaterialIndex];
-
-            Material* material = LoadMaterial(actualAiMaterial, fileInfo.absolutePath());
-
-            currentMesh->SetMaterial(material);
-
-            unsigned int numberOfFaces = subMesh->mNumFaces;
-            QVector< unsigned int > indexData(numberOfFaces*3);
-            for( unsigned int j = 0; j < subMesh->mNumFaces; j++ )
-            {
-                struct aiFace tmpFace = subMesh->mFaces[j];
-                indexData[j*3] = tmpFace.mIndices[0];
-                indexData[j*3+1] = tmpFace.mIndices[1];
-                indexData[j*3+2] = tmpFace.mIndices[2];
-            }
-            currentMesh->SetVerticesData(vertexData.size(), vertexData.data());
-            currentMesh->SetIndexsData(indexData.size(), indexData.data());
-            currentMesh->SetNormalsData(normalData.size(), normalData.data());
-
-            if((tangentData.size() > 0) && (bitangentData.size() > 0))
-            {
-                currentMesh->SetTangentData(tangentData.size(), tangentData.data());
-                currentMesh->SetBitangentData(bitangentData.size(), bitangentData.data());
-            }
-
-            currentMesh->ComputeBoundingVolumes();
-            currentMesh->ComputeAreasOfPolygons();
-
-            meshesLoaded[i] = currentMesh;
+            meshesLoaded[i]->SetMaterial(materials.at(i));
         }
+        Debug::Log( QString("SceneLoader::LoadScene - Memory used by the textures: %1 MB").arg( TextureCache::GetMemoryUsage() / 1048576.0 ) );
+        delete scene;
         sceneLoaded = new Scene( fileInfo.baseName(), meshesLoaded );
+        SceneCache::Save(pPath, sceneLoaded);
     }
     else
     {
@@ -151,7 +272,7 @@ Scene * SceneLoader::LoadScene(const QString &pPath)
     return sceneLoaded;
 }
 
-Material* SceneLoader::LoadMaterial(const aiMaterial* pAiMaterial, const QString& pScenePath)
+Material* SceneLoader::LoadMaterial(const aiMaterial* pAiMaterial, const QString& pScenePath, QString& pKdTexturePath)
 {
     Material* material;
 
@@ -186,7 +307,7 @@ Material* SceneLoader::LoadMaterial(const aiMaterial* pAiMaterial, const QString
         material->SetShininess( value );
     }
 
-    // Obtenim la textura difusa
+    // Obtenim el cam de la textura difusa
     if( pAiMaterial->GetTextureCount(aiTextureType_DIFFUSE) > 0 )
     {
         aiString actualAiTexturePath;
@@ -197,39 +318,35 @@ Material* SceneLoader::LoadMaterial(const aiMaterial* pAiMaterial, const QString
         QString finalTexturePath = pScenePath;
         finalTexturePath.append("/").append(actualTexturePath);
 
-        QImage* imageTexture = new QImage();
-        if( imageTexture->load(finalTexturePath) )
+        pKdTexturePath = finalTexturePath;
+    }
+    return material;
+}
+
+void SceneLoader::ShowImageError(const QString& pPath)
+{
+    QFile file(pPath);
+    if(!file.exists())
+    {
+        Debug::Warning(QString("Image %1 not found").arg(pPath));
+    }
+    else
+    {
+        Debug::Warning(QString("Impossible to load the image: %1").arg(pPath));
+        QFileInfo info(pPath);
+        if(info.suffix() == "tga")
         {
-            material->SetKdTexture(imageTexture);
+            Debug::Warning(QString("RLE compression not supported in tga files"));
         }
-        else
+        QList<QByteArray> supportedFormats = QImageReader::supportedImageFormats();
+        QString output;
+        for(int k = 0; k < supportedFormats.size(); k++)
         {
-            QFile file(finalTexturePath);
-            if(!file.exists())
-            {
-                Debug::Warning(QString("Image %1 not found").arg(finalTexturePath));
-            }
-            else
-            {
-                Debug::Warning(QString("Impossible to load the image: %1").arg(finalTexturePath));
-                QFileInfo info(finalTexturePath);
-                if(info.suffix() == "tga")
-                {
-                    Debug::Warning(QString("RLE compression not supported in tga files"));
-                }
-                QList<QByteArray> supportedFormats = QImageReader::supportedImageFormats();
-                QString output;
-                for(int k = 0; k < supportedFormats.size(); k++)
-                {
-                    output += supportedFormats.at(k);
-                    output += ", ";
-                }
-                Debug::Log(QString("Supported images: %1").arg(output));
-            }
+            output += supportedFormats.at(k);
+            output += ", ";
         }
-        delete imageTexture;
+        Debug::Log(QString("Supported images: %1").arg(output));
     }
-    return material;
 }
 
 void SceneLoader::ShowMaterialInformation(const aiMaterial* pMaterial)
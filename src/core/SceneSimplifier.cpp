@@ -0,0 +1,551 @@
+//Definition include
+#include "SceneSimplifier.h"
+
+//System includes
+#include <algorithm>
+#include <float.h>
+#include <functional>
+#include <queue>
+#include <vector>
+
+//Qt includes
+#include <QHash>
+#include <QTime>
+
+//Dependency includes
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
+
+//Project includes
+#include "Debug.h"
+
+/// Weight of the planes that keep the border edges, relative to the squared length of the edge
+const double BORDER_WEIGHT = 1000.0;
+/// Minimum cosine between the normals of a triangle before and after a collapse
+const float MINIMUM_NORMAL_COSINE = 0.2f;
+
+/// Symmetric 4x4 matrix of the sum of squared distances to a set of planes
+class Quadric
+{
+public:
+    Quadric()
+    {
+        for( int i = 0; i < 10; i++ )
+        {
+            mValues[i] = 0.0;
+        }
+    }
+
+    /// Quadric of the plane with normal \param pNormal through \param pPoint multiplied by \param pWeight
+    Quadric(const glm::vec3& pNormal, const glm::vec3& pPoint, double pWeight)
+    {
+        double a = pNormal.x, b = pNormal.y, c = pNormal.z;
+        double d = -( a * pPoint.x + b * pPoint.y + c * pPoint.z );
+        mValues[0] = pWeight * a * a; mValues[1] = pWeight * a * b; mValues[2] = pWeight * a * c; mValues[3] = pWeight * a * d;
+        mValues[4] = pWeight * b * b; mValues[5] = pWeight * b * c; mValues[6] = pWeight * b * d;
+        mValues[7] = pWeight * c * c; mValues[8] = pWeight * c * d;
+        mValues[9] = pWeight * d * d;
+    }
+
+    Quadric& operator+=(const Quadric& pQuadric)
+    {
+        for( int i = 0; i < 10; i++ )
+        {
+            mValues[i] += pQuadric.mValues[i];
+        }
+        return *this;
+    }
+
+    /// Sum of squared distances from \param pPoint
+    double Evaluate(const glm::vec3& pPoint) const
+    {
+        double x = pPoint.x, y = pPoint.y, z = pPoint.z;
+        return mValues[0] * x * x + 2.0 * mValues[1] * x * y + 2.0 * mValues[2] * x * z + 2.0 * mValues[3] * x +
+               mValues[4] * y * y + 2.0 * mValues[5] * y * z + 2.0 * mValues[6] * y +
+               mValues[7] * z * z + 2.0 * mValues[8] * z + mValues[9];
+    }
+
+    /// Point with the minimum error, false if the system is singular
+    bool Minimum(glm::vec3& pPoint) const
+    {
+        //Cramer's rule for the 3x3 system
+        double a = mValues[0], b = mValues[1], c = mValues[2];
+        double e = mValues[4], f = mValues[5], h = mValues[7];
+        double determinant = a * ( e * h - f * f ) - b * ( b * h - f * c ) + c * ( b * f - e * c );
+        if( glm::abs(determinant) < 1e-12 )
+        {
+            return false;
+        }
+        double x = -mValues[3], y = -mValues[6], z = -mValues[8];
+        pPoint.x = ( x * ( e * h - f * f ) - b * ( y * h - f * z ) + c * ( y * f - e * z ) ) / determinant;
+        pPoint.y = ( a * ( y * h - z * f ) - x * ( b * h - f * c ) + c * ( b * z - y * c ) ) / determinant;
+        pPoint.z = ( a * ( e * z - f * y ) - b * ( b * z - y * c ) + x * ( b * f - e * c ) ) / determinant;
+        return true;
+    }
+
+private:
+    double mValues[10];
+};
+
+/// Candidate collapse of the edge of the vertices u and v into a position
+struct EdgeCollapse
+{
+    double cost;
+    int u;
+    int v;
+    int stampU;
+    int stampV;
+    glm::vec3 position;
+
+    bool operator>(const EdgeCollapse& pCollapse) const
+    {
+        return cost > pCollapse.cost;
+    }
+};
+
+/// Order of the vertices by their position to weld the equal ones
+class PositionLess
+{
+public:
+    PositionLess(const QVector<glm::vec3>& pPositions):
+        mPositions(pPositions)
+    {
+
+    }
+
+    bool operator()(int pA, int pB) const
+    {
+        const glm::vec3& a = mPositions.at(pA);
+        const glm::vec3& b = mPositions.at(pB);
+        if( a.x != b.x )
+        {
+            return a.x < b.x;
+        }
+        if( a.y != b.y )
+        {
+            return a.y < b.y;
+        }
+        return a.z < b.z;
+    }
+
+private:
+    const QVector<glm::vec3>& mPositions;
+};
+
+static inline quint64 EdgeKey(int pA, int pB)
+{
+    return pA < pB ? ( (quint64)pA << 32 ) | (quint64)pB : ( (quint64)pB << 32 ) | (quint64)pA;
+}
+
+static inline glm::vec3 FaceNormal(const glm::vec3& pA, const glm::vec3& pB, const glm::vec3& pC)
+{
+    return glm::cross(pB - pA, pC - pA);
+}
+
+/// Compute the position and the cost of collapsing the edge of \param pCollapse
+static void EvaluateCollapse(const QVector<Quadric>& pQuadrics, const QVector<glm::vec3>& pPositions, EdgeCollapse& pCollapse)
+{
+    Quadric quadric = pQuadrics.at(pCollapse.u);
+    quadric += pQuadrics.at(pCollapse.v);
+    const glm::vec3& positionU = pPositions.at(pCollapse.u);
+    const glm::vec3& positionV = pPositions.at(pCollapse.v);
+    glm::vec3 midpoint = ( positionU + positionV ) * 0.5f;
+    if( !quadric.Minimum(pCollapse.position) || glm::distance(pCollapse.position, midpoint) > glm::distance(positionU, positionV) )
+    {
+        //Without a well-defined minimum near the edge, the best of the vertices and the midpoint
+        pCollapse.position = midpoint;
+        if( quadric.Evaluate(positionU) < quadric.Evaluate(pCollapse.position) )
+        {
+            pCollapse.position = positionU;
+        }
+        if( quadric.Evaluate(positionV) < quadric.Evaluate(pCollapse.position) )
+        {
+            pCollapse.position = positionV;
+        }
+    }
+    pCollapse.cost = quadric.Evaluate(pCollapse.position);
+}
+
+Scene* SceneSimplifier::Simplify(const Scene* pScene, float pRatio, QVector<int>& pCoarsePolygons)
+{
+    QTime t;
+    t.start();
+
+    pCoarsePolygons.resize( pScene->GetNumberOfPolygons() );
+    QVector<Geometry *> meshes;
+    int fineOffset = 0;
+    int coarseOffset = 0;
+    for( int i = 0; i < pScene->GetNumberOfMeshes(); i++ )
+    {
+        Geometry* currentMesh = pScene->GetMesh(i);
+        currentMesh->MakeResident();
+        QVector<int> coarseFaces;
+        Geometry* coarseMesh = SimplifyMesh(currentMesh, pRatio, coarseFaces);
+        for( int j = 0; j < coarseFaces.size(); j++ )
+        {
+            pCoarsePolygons[fineOffset + j] = coarseOffset + coarseFaces.at(j);
+        }
+        fineOffset += currentMesh->GetNumFaces();
+        coarseOffset += coarseMesh->GetNumFaces();
+        meshes.push_back(coarseMesh);
+    }
+    Scene* scene = new Scene( QString("%1_lod").arg( pScene->GetName() ), meshes );
+    Debug::Log( QString("SceneSimplifier::Simplify - %1 polygons simplified to %2 in %3 ms").arg( pScene->GetNumberOfPolygons() ).arg( scene->GetNumberOfPolygons() ).arg( t.elapsed() ) );
+    return scene;
+}
+
+Geometry* SceneSimplifier::SimplifyMesh(const Geometry* pMesh, float pRatio, QVector<int>& pCoarseFaces)
+{
+    int numberOfFaces = pMesh->GetNumFaces();
+    if( pMesh->GetTopology() != Geometry::Triangles || pMesh->GetVerticesStride() < 3 || pRatio >= 1.0f || numberOfFaces == 0 )
+    {
+        //Only the triangles are simplified, the other meshes are kept
+        pCoarseFaces.resize(numberOfFaces);
+        for( int i = 0; i < numberOfFaces; i++ )
+        {
+            pCoarseFaces[i] = i;
+        }
+        return new Geometry(*pMesh);
+    }
+
+    //The vertices with the same position are welded so the seams of the attributes are not opened
+    const QVector<float>& vertexData = pMesh->GetVerticesData();
+    unsigned int stride = pMesh->GetVerticesStride();
+    int numberOfVertices = pMesh->GetNumVertices();
+    QVector<glm::vec3> originalPositions(numberOfVertices);
+    for( int i = 0; i < numberOfVertices; i++ )
+    {
+        originalPositions[i] = glm::vec3( vertexData.at(i * stride), vertexData.at(i * stride + 1), vertexData.at(i * stride + 2) );
+    }
+    QVector<int> order(numberOfVertices);
+    for( int i = 0; i < numberOfVertices; i++ )
+    {
+        order[i] = i;
+    }
+    std::sort( order.begin(), order.end(), PositionLess(originalPositions) );
+    QVector<int> weldedVertex(numberOfVertices);
+    QVector<glm::vec3> positions;
+    for( int i = 0; i < numberOfVertices; i++ )
+    {
+        if( i == 0 || originalPositions.at( order.at(i) ) != originalPositions.at( order.at(i - 1) ) )
+        {
+            positions.push_back( originalPositions.at( order.at(i) ) );
+        }
+        weldedVertex[ order.at(i) ] = positions.size() - 1;
+    }
+    order.clear();
+    int numberOfWeldedVertices = positions.size();
+
+    //Faces, their adjacency and the quadrics of the planes of the faces weighted by their area
+    QVector<int> faces(numberOfFaces * 3);
+    QVector<bool> alive(numberOfFaces, true);
+    QVector< QVector<int> > vertexFaces(numberOfWeldedVertices);
+    QVector<Quadric> quadrics(numberOfWeldedVertices);
+    QHash<quint64, int> edges;
+    int numberOfAliveFaces = numberOfFaces;
+    for( int i = 0; i < numberOfFaces; i++ )
+    {
+        for( int k = 0; k < 3; k++ )
+        {
+            faces[i * 3 + k] = weldedVertex.at( pMesh->GetValueOfIndex(i * 3 + k) );
+        }
+        int a = faces.at(i * 3), b = faces.at(i * 3 + 1), c = faces.at(i * 3 + 2);
+        if( a == b || b == c || c == a )
+        {
+            alive[i] = false;
+            numberOfAliveFaces--;
+            continue;
+        }
+        vertexFaces[a].push_back(i);
+        vertexFaces[b].push_back(i);
+        vertexFaces[c].push_back(i);
+        edges[EdgeKey(a, b)]++;
+        edges[EdgeKey(b, c)]++;
+        edges[EdgeKey(c, a)]++;
+
+        glm::vec3 normal = FaceNormal( positions.at(a), positions.at(b), positions.at(c) );
+        float length = glm::length(normal);
+        if( length > 0.0f )
+        {
+            Quadric quadric( normal / length, positions.at(a), length * 0.5 );
+            quadrics[a] += quadric;
+            quadrics[b] += quadric;
+            quadrics[c] += quadric;
+        }
+    }
+
+    //The border edges get a plane perpendicular to their face
+    for( int i = 0; i < numberOfFaces; i++ )
+    {
+        if( !alive.at(i) )
+        {
+            continue;
+        }
+        glm::vec3 normal = FaceNormal( positions.at( faces.at(i * 3) ), positions.at( faces.at(i * 3 + 1) ), positions.at( faces.at(i * 3 + 2) ) );
+        for( int k = 0; k < 3; k++ )
+        {
+            int a = faces.at(i * 3 + k);
+            int b = faces.at(i * 3 + ( k + 1 ) % 3);
+            if( edges.value( EdgeKey(a, b) ) == 1 )
+            {
+                glm::vec3 edge = positions.at(b) - positions.at(a);
+                glm::vec3 borderNormal = glm::cross(edge, normal);
+                float length = glm::length(borderNormal);
+                if( length > 0.0f )
+                {
+                    Quadric quadric( borderNormal / length, positions.at(a), BORDER_WEIGHT * glm::dot(edge, edge) );
+                    quadrics[a] += quadric;
+                    quadrics[b] += quadric;
+                }
+            }
+        }
+    }
+
+    QVector<int> stamps(numberOfWeldedVertices, 0);
+    QVector<int> parents(numberOfWeldedVertices, -1);
+    std::priority_queue< EdgeCollapse, std::vector<EdgeCollapse>, std::greater<EdgeCollapse> > collapses;
+    QHash<quint64, int>::const_iterator it;
+    for( it = edges.constBegin(); it != edges.constEnd(); ++it )
+    {
+        EdgeCollapse collapse;
+        collapse.u = (int)( it.key() >> 32 );
+        collapse.v = (int)( it.key() & 0xFFFFFFFF );
+        collapse.stampU = 0;
+        collapse.stampV = 0;
+        EvaluateCollapse(quadrics, positions, collapse);
+        collapses.push(collapse);
+    }
+    edges.clear();
+
+    int targetFaces = glm::max( (int)( numberOfAliveFaces * pRatio ), 1 );
+    while( numberOfAliveFaces > targetFaces && !collapses.empty() )
+    {
+        EdgeCollapse collapse = collapses.top();
+        collapses.pop();
+        int u = collapse.u;
+        int v = collapse.v;
+        if( parents.at(u) != -1 || parents.at(v) != -1 || stamps.at(u) != collapse.stampU || stamps.at(v) != collapse.stampV )
+        {
+            continue;
+        }
+
+        //The collapse is rejected if a remaining face flips or degenerates
+        bool valid = true;
+        for( int side = 0; side < 2 && valid; side++ )
+        {
+            int moved = ( side == 0 ) ? u : v;
+            int other = ( side == 0 ) ? v : u;
+            const QVector<int>& movedFaces = vertexFaces.at(moved);
+            for( int j = 0; j < movedFaces.size() && valid; j++ )
+            {
+                int face = movedFaces.at(j);
+                if( !alive.at(face) )
+                {
+                    continue;
+                }
+                glm::vec3 before[3], after[3];
+                bool shared = false;
+                for( int k = 0; k < 3; k++ )
+                {
+                    int vertex = faces.at(face * 3 + k);
+                    shared = shared || ( vertex == other );
+                    before[k] = positions.at(vertex);
+                    after[k] = ( vertex == moved ) ? collapse.position : before[k];
+                }
+                if( shared )
+                {
+                    continue;
+                }
+                glm::vec3 normalBefore = FaceNormal(before[0], before[1], before[2]);
+                glm::vec3 normalAfter = FaceNormal(after[0], after[1], after[2]);
+                float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+                valid = ( lengths > 0.0f && glm::dot(normalBefore, normalAfter) >= MINIMUM_NORMAL_COSINE * lengths );
+            }
+        }
+        if( !valid )
+        {
+            continue;
+        }
+
+        //v is merged into u
+        positions[u] = collapse.position;
+        quadrics[u] += quadrics.at(v);
+        parents[v] = u;
+        const QVector<int>& removedFaces = vertexFaces.at(v);
+        for( int j = 0; j < removedFaces.size(); j++ )
+        {
+            int face = removedFaces.at(j);
+            if( !alive.at(face) )
+            {
+                continue;
+            }
+            bool shared = false;
+            for( int k = 0; k < 3; k++ )
+            {
+                if( faces.at(face * 3 + k) == u )
+                {
+                    shared = true;
+                }
+            }
+            if( shared )
+            {
+                alive[face] = false;
+                numberOfAliveFaces--;
+            }
+            else
+            {
+                for( int k = 0; k < 3; k++ )
+                {
+                    if( faces.at(face * 3 + k) == v )
+                    {
+                        faces[face * 3 + k] = u;
+                    }
+                }
+                vertexFaces[u].push_back(face);
+            }
+        }
+        vertexFaces[v] = QVector<int>();
+
+        QVector<int> currentFaces;
+        QVector<int> neighbours;
+        for( int j = 0; j < vertexFaces.at(u).size(); j++ )
+        {
+            int face = vertexFaces.at(u).at(j);
+            if( alive.at(face) )
+            {
+                currentFaces.push_back(face);
+                for( int k = 0; k < 3; k++ )
+                {
+                    int vertex = faces.at(face * 3 + k);
+                    if( vertex != u && !neighbours.contains(vertex) )
+                    {
+                        neighbours.push_back(vertex);
+                    }
+                }
+            }
+        }
+        vertexFaces[u] = currentFaces;
+        stamps[u]++;
+
+        //New candidates of the edges of u
+        for( int j = 0; j < neighbours.size(); j++ )
+        {
+            int w = neighbours.at(j);
+            EdgeCollapse candidate;
+            candidate.u = u;
+            candidate.v = w;
+            candidate.stampU = stamps.at(u);
+            candidate.stampV = stamps.at(w);
+            EvaluateCollapse(quadrics, positions, candidate);
+            collapses.push(candidate);
+        }
+    }
+
+    //Simplified mesh with the remaining faces and the vertices they use, with normals weighted by the area
+    QVector<int> coarseFaceIndex(numberOfFaces, -1);
+    QVector<int> coarseVertexIndex(numberOfWeldedVertices, -1);
+    QVector<float> coarseVertexData;
+    QVector<unsigned int> coarseIndexData;
+    int numberOfCoarseFaces = 0;
+    for( int i = 0; i < numberOfFaces; i++ )
+    {
+        if( !alive.at(i) )
+        {
+            continue;
+        }
+        coarseFaceIndex[i] = numberOfCoarseFaces++;
+        for( int k = 0; k < 3; k++ )
+        {
+            int vertex = faces.at(i * 3 + k);
+            if( coarseVertexIndex.at(vertex) == -1 )
+            {
+                coarseVertexIndex[vertex] = coarseVertexData.size() / 3;
+                coarseVertexData.push_back( positions.at(vertex).x );
+                coarseVertexData.push_back( positions.at(vertex).y );
+                coarseVertexData.push_back( positions.at(vertex).z );
+            }
+            coarseIndexData.push_back( coarseVertexIndex.at(vertex) );
+        }
+    }
+    QVector<float> coarseNormalData(coarseVertexData.size(), 0.0f);
+    for( int i = 0; i < coarseIndexData.size(); i += 3 )
+    {
+        glm::vec3 vertices[3];
+        for( int k = 0; k < 3; k++ )
+        {
+            int index = coarseIndexData.at(i + k) * 3;
+            vertices[k] = glm::vec3( coarseVertexData.at(index), coarseVertexData.at(index + 1), coarseVertexData.at(index + 2) );
+        }
+        glm::vec3 normal = FaceNormal(vertices[0], vertices[1], vertices[2]);
+        for( int k = 0; k < 3; k++ )
+        {
+            int index = coarseIndexData.at(i + k) * 3;
+            coarseNormalData[index] += normal.x;
+            coarseNormalData[index + 1] += normal.y;
+            coarseNormalData[index + 2] += normal.z;
+        }
+    }
+    for( int i = 0; i < coarseNormalData.size(); i += 3 )
+    {
+        glm::vec3 normal( coarseNormalData.at(i), coarseNormalData.at(i + 1), coarseNormalData.at(i + 2) );
+        float length = glm::length(normal);
+        if( length > 0.0f )
+        {
+            normal /= length;
+        }
+        coarseNormalData[i] = normal.x;
+        coarseNormalData[i + 1] = normal.y;
+        coarseNormalData[i + 2] = normal.z;
+    }
+
+    //Every original face is covered by itself if it remains, otherwise by the nearest remaining face around its vertices
+    pCoarseFaces.fill(0, numberOfFaces);
+    for( int i = 0; i < numberOfFaces; i++ )
+    {
+        if( alive.at(i) )
+        {
+            pCoarseFaces[i] = coarseFaceIndex.at(i);
+            continue;
+        }
+        glm::vec3 centroid(0.0f);
+        for( int k = 0; k < 3; k++ )
+        {
+            centroid += originalPositions.at( pMesh->GetValueOfIndex(i * 3 + k) ) / 3.0f;
+        }
+        float nearestDistance = FLT_MAX;
+        for( int k = 0; k < 3; k++ )
+        {
+            int vertex = weldedVertex.at( pMesh->GetValueOfIndex(i * 3 + k) );
+            while( parents.at(vertex) != -1 )
+            {
+                vertex = parents.at(vertex);
+            }
+            const QVector<int>& candidates = vertexFaces.at(vertex);
+            for( int j = 0; j < candidates.size(); j++ )
+            {
+                int face = candidates.at(j);
+                if( !alive.at(face) )
+                {
+                    continue;
+                }
+                glm::vec3 faceCentroid = ( positions.at( faces.at(face * 3) ) + positions.at( faces.at(face * 3 + 1) ) + positions.at( faces.at(face * 3 + 2) ) ) / 3.0f;
+                float distance = glm::distance(centroid, faceCentroid);
+                if( distance < nearestDistance )
+                {
+                    nearestDistance = distance;
+                    pCoarseFaces[i] = coarseFaceIndex.at(face);
+                }
+            }
+        }
+    }
+
+    Geometry* mesh = new Geometry(pMesh->GetName(), Geometry::Triangles);
+    mesh->SetVerticesData(coarseVertexData, 3);
+    mesh->SetNormalsData(coarseNormalData);
+    mesh->SetIndexsData(coarseIndexData);
+    mesh->ComputeBoundingVolumes();
+    mesh->ComputeAreasOfPolygons();
+    mesh->SetCompactStorage(true);
+    mesh->SetReleaseAttributesAfterUpload(true);
+    return mesh;
+}
@@ -0,0 +1,198 @@
+//Definition include
+#include "TerrainTileCache.h"
+
+//Qt includes
+#include <QDir>
+#include <QFile>
+
+//Project includes
+#include "Debug.h"
+#include "GPUGeometry.h"
+
+/// Identification of the tile files
+const quint32 TERRAIN_TILE_MAGIC = 0x51545454;
+
+template<class T> static bool WriteVector(QFile& pFile, const QVector<T>& pVector)
+{
+    qint32 size = pVector.size();
+    qint64 bytes = pVector.size() * sizeof(T);
+    return pFile.write( (const char*)&size, sizeof(size) ) == sizeof(size) &&
+           pFile.write( (const char*)pVector.constData(), bytes ) == bytes;
+}
+
+template<class T> static bool ReadVector(QFile& pFile, QVector<T>& pVector)
+{
+    qint32 size = 0;
+    if( pFile.read( (char*)&size, sizeof(size) ) != sizeof(size) || size < 0 )
+    {
+        return false;
+    }
+    pVector.resize(size);
+    qint64 bytes = size * sizeof(T);
+    return pFile.read( (char*)pVector.data(), bytes ) == bytes;
+}
+
+TerrainTileCache::TerrainTileCache(const QString& pDirectory, qint64 pMemoryBudget):
+    mDirectory(pDirectory), mMemoryBudget(pMemoryBudget), mResidentMemory(0)
+{
+    if( !QDir().mkpath(mDirectory) )
+    {
+        Debug::Warning( QString("TerrainTileCache - Impossible to create the folder %1").arg(mDirectory) );
+    }
+}
+
+TerrainTileCache::~TerrainTileCache()
+{
+    //The meshes are owned by the scene, only the files are removed
+    QHash<Geometry*, Tile>::const_iterator it;
+    for( it = mTiles.constBegin(); it != mTiles.constEnd(); ++it )
+    {
+        QFile::remove( it.value().fileName );
+    }
+}
+
+void TerrainTileCache::AddTile(Geometry* pMesh, int pRow, int pColumn)
+{
+    Tile tile;
+    tile.fileName = QDir(mDirectory).filePath( QString("tile_%1_%2.bin").arg(pRow).arg(pColumn) );
+    tile.row = pRow;
+    tile.column = pColumn;
+    tile.memorySize = GetMemorySize(pMesh);
+    tile.resident = false;
+    tile.position = mResidentTiles.end();
+    if( !WriteTile(tile.fileName, pMesh) )
+    {
+        //Without its file the tile can not be paged out, so it stays resident
+        Debug::Warning( QString("TerrainTileCache::AddTile - Impossible to write %1, the tile is kept in memory").arg(tile.fileName) );
+        return;
+    }
+
+    pMesh->mNumberOfIndicesOnDisk = pMesh->mIndexData.size();
+    pMesh->mNumberOfVerticesOnDisk = pMesh->GetNumVertices();
+    pMesh->mTileCache = this;
+    PageOut(pMesh);
+    mTiles.insert(pMesh, tile);
+    mGrid.insert(qMakePair(pRow, pColumn), pMesh);
+}
+
+void TerrainTileCache::Request(Geometry* pMesh)
+{
+    QHash<Geometry*, Tile>::iterator it = mTiles.find(pMesh);
+    if( it == mTiles.end() )
+    {
+        return;
+    }
+    Tile& tile = it.value();
+    if( tile.resident )
+    {
+        mResidentTiles.erase(tile.position);
+    }
+    else
+    {
+        if( !PageIn(pMesh, tile.fileName) )
+        {
+            PageOut(pMesh);
+            Debug::Error( QString("TerrainTileCache::Request - Impossible to read the tile %1").arg(tile.fileName) );
+            return;
+        }
+        tile.resident = true;
+        mResidentMemory += tile.memorySize;
+    }
+    mResidentTiles.prepend(pMesh);
+    tile.position = mResidentTiles.begin();
+
+    //The tile just requested is never evicted, even if it does not fit in the budget alone
+    while( mResidentMemory > mMemoryBudget && mResidentTiles.size() > 1 )
+    {
+        Geometry* leastRecentlyUsed = mResidentTiles.takeLast();
+        Tile& evicted = mTiles[leastRecentlyUsed];
+        PageOut(leastRecentlyUsed);
+        evicted.resident = false;
+        evicted.position = mResidentTiles.end();
+        mResidentMemory -= evicted.memorySize;
+    }
+}
+
+Geometry* TerrainTileCache::GetTile(int pRow, int pColumn) const
+{
+    return mGrid.value(qMakePair(pRow, pColumn), NULL);
+}
+
+int TerrainTileCache::GetNumberOfTiles() const
+{
+    return mTiles.size();
+}
+
+int TerrainTileCache::GetNumberOfResidentTiles() const
+{
+    return mResidentTiles.size();
+}
+
+qint64 TerrainTileCache::GetResidentMemory() const
+{
+    return mResidentMemory;
+}
+
+bool TerrainTileCache::WriteTile(const QString& pFileName, const Geometry* pMesh) const
+{
+    QFile file(pFileName);
+    if( !file.open(QFile::WriteOnly) )
+    {
+        return false;
+    }
+    quint32 header[2] = { TERRAIN_TILE_MAGIC, pMesh->mVertexStride };
+    bool written = file.write( (const char*)header, sizeof(header) ) == sizeof(header);
+    written = written && WriteVector(file, pMesh->mVertexData);
+    written = written && WriteVector(file, pMesh->mNormalData);
+    written = written && WriteVector(file, pMesh->mTextCoordsData);
+    written = written && WriteVector(file, pMesh->mIndexData);
+    file.close();
+    if( !written )
+    {
+        QFile::remove(pFileName);
+    }
+    return written;
+}
+
+bool TerrainTileCache::PageIn(Geometry* pMesh, const QString& pFileName) const
+{
+    QFile file(pFileName);
+    if( !file.open(QFile::ReadOnly) )
+    {
+        return false;
+    }
+    quint32 header[2] = { 0, 0 };
+    if( file.read( (char*)header, sizeof(header) ) != sizeof(header) || header[0] != TERRAIN_TILE_MAGIC )
+    {
+        return false;
+    }
+    pMesh->mVertexStride = header[1];
+    bool read = ReadVector(file, pMesh->mVertexData);
+    read = read && ReadVector(file, pMesh->mNormalData);
+    read = read && ReadVector(file, pMesh->mTextCoordsData);
+    read = read && ReadVector(file, pMesh->mIndexData);
+    pMesh->mResident = read;
+    pMesh->mNeedGPUGeometryUpdate = true;
+    return read;
+}
+
+void TerrainTileCache::PageOut(Geometry* pMesh) const
+{
+    pMesh->mVertexData = QVector<float>();
+    pMesh->mNormalData = QVector<float>();
+    pMesh->mColorData = QVector<float>();
+    pMesh->mTextCoordsData = QVector<float>();
+    pMesh->mTangentData = QVector<float>();
+    pMesh->mBitangentData = QVector<float>();
+    pMesh->mIndexData = QVector<unsigned int>();
+    pMesh->ReleaseGPUGeometry();
+    pMesh->mAttributesReleased = false;
+    pMesh->mResident = false;
+}
+
+qint64 TerrainTileCache::GetMemorySize(const Geometry* pMesh)
+{
+    //The same buffers are in the CPU until the upload and in the GPU after it
+    return ( pMesh->mVertexData.size() + pMesh->mNormalData.size() + pMesh->mTextCoordsData.size() ) * sizeof(float) +
+           pMesh->mIndexData.size() * sizeof(unsigned int);
+}
@@ -1,21 +1,36 @@
 //Definition include
 #include "Texture.h"
 
-Texture::Texture(QImage *pTexture, bool pRectangle):
-    mTexture(pTexture)
+Texture::Texture(QImage *pTexture, bool pRectangle, GLenum pInternalFormat):
+    mMemorySize(0)
 {
     int imageWidth = pTexture->width();
     int imageHeight = pTexture->height();
 
+    //Bits per texel of the internal formats used
+    qint64 bitsPerTexel = 32;
+    if( pInternalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT )
+    {
+        bitsPerTexel = 4;
+    }
+    else if( pInternalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT )
+    {
+        bitsPerTexel = 8;
+    }
+    mMemorySize = (qint64)imageWidth * imageHeight * bitsPerTexel / 8;
+
     glGenTextures(1, &mGLId);
     if(!pRectangle)
     {
         glBindTexture(GL_TEXTURE_2D, mGLId);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pTexture->bits());
+        glTexImage2D(GL_TEXTURE_2D, 0, pInternalFormat, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pTexture->bits());
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        //The mipmaps are queued to the GPU, so the CPU does not wait for them
+        glGenerateMipmap(GL_TEXTURE_2D);
+        mMemorySize = mMemorySize * 4 / 3;
     }
     else
     {
@@ -24,17 +39,22 @@ Texture::Texture(QImage *pTexture, bool pRectangle):
         glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_WRAP_T, GL_CLAMP);
         glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_RECTANGLE, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexImage2D(GL_TEXTURE_RECTANGLE, 0, GL_RGBA32F, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pTexture->bits());
+        glTexImage2D(GL_TEXTURE_RECTANGLE, 0, pInternalFormat, imageWidth, imageHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, pTexture->bits());
     }
+    delete pTexture;
 }
 
 Texture::~Texture()
 {
     glDeleteTextures(1, &mGLId);
-    delete mTexture;
 }
 
 GLuint Texture::GetGLId() const
 {
     return mGLId;
 }
+
+qint64 Texture::GetMemorySize() const
+{
+    return mMemorySize;
+}
@@ -0,0 +1,81 @@
+//Definition include
+#include "TextureCache.h"
+
+//Qt includes
+#include <QGLWidget>
+
+QHash<QString, Texture*> TextureCache::mTextures;
+QHash<Texture*, int> TextureCache::mReferences;
+bool TextureCache::mCompression = true;
+qint64 TextureCache::mMemoryUsage = 0;
+
+Texture* TextureCache::Acquire(const QString& pPath, const QImage* pImage)
+{
+    if( !pPath.isEmpty() && mTextures.contains(pPath) )
+    {
+        Texture* texture = mTextures.value(pPath);
+        AddReference(texture);
+        return texture;
+    }
+    if( pImage == NULL || pImage->isNull() )
+    {
+        return NULL;
+    }
+
+    GLenum internalFormat = GL_RGBA8;
+    if( mCompression && GLEW_EXT_texture_compression_s3tc )
+    {
+        internalFormat = pImage->hasAlphaChannel() ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    }
+    Texture* texture = new Texture( new QImage( QGLWidget::convertToGLFormat(*pImage) ), false, internalFormat );
+    if( !pPath.isEmpty() )
+    {
+        mTextures.insert(pPath, texture);
+    }
+    mReferences.insert(texture, 1);
+    mMemoryUsage += texture->GetMemorySize();
+    return texture;
+}
+
+void TextureCache::AddReference(Texture* pTexture)
+{
+    if( pTexture != NULL )
+    {
+        mReferences[pTexture]++;
+    }
+}
+
+void TextureCache::Release(Texture* pTexture)
+{
+    if( pTexture == NULL )
+    {
+        return;
+    }
+    int references = --mReferences[pTexture];
+    if( references <= 0 )
+    {
+        QString path = mTextures.key(pTexture);
+        if( !path.isEmpty() )
+        {
+            mTextures.remove(path);
+        }
+        mReferences.remove(pTexture);
+        mMemoryUsage -= pTexture->GetMemorySize();
+        delete pTexture;
+    }
+}
+
+bool TextureCache::Contains(const QString& pPath)
+{
+    return mTextures.contains(pPath);
+}
+
+void TextureCache::SetCompression(bool pCompression)
+{
+    mCompression = pCompression;
+}
+
+qint64 TextureCache::GetMemoryUsage()
+{
+    return mMemoryUsage;
+}
@@ -63,6 +63,11 @@ unsigned int VisibilityChannelHistogram::GetValue(int pViewpoint, int pPolygon)
     return mValues.at(pViewpoint).at(pPolygon);
 }
 
+QVector< unsigned int > VisibilityChannelHistogram::GetValues(int pViewpoint) const
+{
+    return mValues.at(pViewpoint);
+}
+
 void VisibilityChannelHistogram::Compute()
 {
     mSumPerPolygon.fill( 0, mNumberOfPolygons );